@@ -170,9 +170,10 @@ static inline void quadrature_encoder_program_init(PIO pio, uint sm, uint offset
 struct QuadratureState {
     int32_t count;
     uint8_t last_state;
+    uint32_t invalid;       // Transitions where both channels changed
 };
 
-static QuadratureState encoder_states[4] = {{0, 0}, {0, 0}, {0, 0}, {0, 0}};
+static QuadratureState encoder_states[4] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
 
 // Lookup table for efficient quadrature decoding
 // Index: [old_b][old_a][new_b][new_a]
@@ -209,6 +210,11 @@ static inline void quadrature_encoder_request_count(PIO pio, uint sm) {
             uint8_t index = (state->last_state << 2) | new_state;
             int8_t delta = quadrature_lookup[index];
             
+            // Both bits flipped: an edge was missed, direction unknown
+            if ((state->last_state ^ new_state) == 0x03) {
+                state->invalid++;
+            }
+            
             state->count += delta;
             state->last_state = new_state;
         }
@@ -219,6 +225,10 @@ static inline int32_t quadrature_encoder_fetch_count(PIO pio, uint sm) {
     return encoder_states[sm].count;
 }
 
+static inline uint32_t quadrature_encoder_fetch_invalid(PIO pio, uint sm) {
+    return encoder_states[sm].invalid;
+}
+
 // Optional: Reset encoder count (useful for homing)
 static inline void quadrature_encoder_reset_count(PIO pio, uint sm) {
     encoder_states[sm].count = 0;
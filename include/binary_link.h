@@ -0,0 +1,116 @@
+/*
+ * binary_link.h - Binary framed telemetry and command protocol on USB serial
+ * COBS-framed, CRC-checked, versioned messages for logging at the control
+ * rate; entered with the BINARY console command and decoded on the host
+ * by scripts/binlink_decode.py
+ */
+
+#ifndef BINARY_LINK_H
+#define BINARY_LINK_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Frame (before COBS encoding, little-endian):
+//   uint8  version        BINLINK_VERSION
+//   uint8  type           BinLinkMessage
+//   uint16 seq            Per-direction sequence number
+//   ...    payload        Message struct below
+//   uint16 crc            CRC-16/CCITT-FALSE over version..payload
+// Each frame is COBS encoded and sent between 0x00 delimiters, so a reader
+// can join mid-stream and resynchronise after any stray console output.
+
+#define BINLINK_VERSION 1
+#define BINLINK_MAX_PAYLOAD 32
+#define BINLINK_MAX_FRAME 48            // Encoded frame + delimiters
+#define BINLINK_TX_RING_SIZE 8192       // Power of two
+#define BINLINK_TELEMETRY_DEFAULT_HZ 10
+#define BINLINK_TELEMETRY_MAX_HZ 1000
+#define BINLINK_ENCODER_MAX_HZ 1000
+
+typedef enum {
+  BINLINK_MSG_TELEMETRY = 0x01,  // Device -> host, BinTelemetry
+  BINLINK_MSG_ENCODER = 0x02,    // Device -> host, BinEncoder (encoder stream rate)
+  BINLINK_MSG_COMMAND = 0x10,    // Host -> device, BinCommand
+  BINLINK_MSG_ACK = 0x11         // Device -> host, BinAck
+} BinLinkMessage;
+
+typedef enum {
+  BINLINK_CMD_PING = 1,
+  BINLINK_CMD_GOTO = 2,          // arg[0] = azimuth, arg[1] = elevation
+  BINLINK_CMD_STOP = 3,
+  BINLINK_CMD_ESTOP = 4,
+  BINLINK_CMD_RESET_ESTOP = 5,
+  BINLINK_CMD_TELEMETRY_RATE = 6, // arg[0] = Hz (0 = off)
+  BINLINK_CMD_ENCODER_STREAM = 7, // arg[0] = Hz (0 = off)
+  BINLINK_CMD_EXIT = 8           // Back to the text console
+} BinLinkCommand;
+
+typedef enum {
+  BINLINK_ACK_OK = 0,
+  BINLINK_ACK_UNKNOWN = 1,
+  BINLINK_ACK_BAD_ARGS = 2,
+  BINLINK_ACK_REFUSED = 3        // E-stop active
+} BinLinkAckStatus;
+
+// Telemetry flags
+#define BINLINK_FLAG_TRACKING 0x01
+#define BINLINK_FLAG_GPS_VALID 0x02
+#define BINLINK_FLAG_ESTOP 0x04
+#define BINLINK_FLAG_SAT_VALID 0x08
+
+struct __attribute__((packed)) BinTelemetry {
+  uint32_t timeMs;
+  float azimuth;                 // Antenna (deg)
+  float elevation;
+  float targetAz;
+  float targetEl;
+  float satAz;                   // Satellite (valid if BINLINK_FLAG_SAT_VALID)
+  float satEl;
+  uint8_t flags;
+  uint8_t reserved;
+  uint16_t dropped;              // Frames dropped on a full TX ring (wraps)
+};
+
+struct __attribute__((packed)) BinEncoder {
+  uint32_t timeUs;
+  int32_t countEl;               // Raw encoder counts
+  int32_t countAz;
+  float errorAz;                 // Target minus current (deg)
+  float errorEl;
+};
+
+struct __attribute__((packed)) BinCommand {
+  uint8_t code;                  // BinLinkCommand
+  uint8_t reserved[3];
+  float arg[2];
+};
+
+struct __attribute__((packed)) BinAck {
+  uint16_t seq;                  // Sequence number of the command
+  uint8_t code;
+  uint8_t status;                // BinLinkAckStatus
+};
+
+static_assert(sizeof(BinTelemetry) <= BINLINK_MAX_PAYLOAD, "BinTelemetry too large");
+static_assert(sizeof(BinEncoder) <= BINLINK_MAX_PAYLOAD, "BinEncoder too large");
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Hand the USB serial port to the binary protocol / back to the CLI
+void beginBinaryLink();
+void endBinaryLink();
+bool isBinaryLinkActive();
+
+// Decode received frames, queue telemetry and encoder records when due
+// and drain the TX ring into the USB endpoint as space allows (call from
+// the main loop; never blocks). Rates above the loop rate are capped by
+// how often this runs; each record carries its own timestamp.
+void pollBinaryLink();
+
+// Print link counters (for debugging)
+void printBinaryLinkStatus();
+
+#endif // BINARY_LINK_H
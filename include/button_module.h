@@ -40,7 +40,8 @@ void initButtons();
 // If callback is NULL, events are not reported
 void setButtonCallback(ButtonCallback callback);
 
-// Poll for button events (call from main loop if not using callback)
+// Process queued button edges (call from main loop; events go to the
+// callback). Returns immediately when no button is active.
 // Returns button that changed, or BUTTON_NONE
 ButtonID pollButtons();
 
@@ -56,6 +56,9 @@ void calibrateCompass();
 
 // Print compass status to Serial console (for debugging)
 void printCompassStatus();
-void printRawCompassData(int samples);
+
+// Raw readings table: header, then one row per call (the CLI paces them)
+void printRawCompassHeader(int samples);
+void printRawCompassSample(int index);
 
 #endif // COMPASS_MODULE_H
\ No newline at end of file
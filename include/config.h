@@ -142,11 +142,40 @@
 #define CONTROL_LOOP_DT (1.0 / CONTROL_LOOP_HZ)
 #define TRACKING_UPDATE_MS ((unsigned long)(CONTROL_LOOP_DT * 1000))
 #define DISPLAY_UPDATE_MS 500
+#define LED_UPDATE_MS 20     // 50 Hz LED frame rate (temporal dithering needs a steady refresh)
+
+// Web Telemetry Stream (Server-Sent Events on /events)
+#define TELEMETRY_DEFAULT_HZ 10
+#define TELEMETRY_MAX_HZ 20
+#define TELEMETRY_STATUS_MS 1000   // Slow-changing status event interval
+
+// Hamlib rotctld-compatible rotator server (Gpredict, SatNOGS, rotctl -m 2)
+#define ROTCTL_PORT 4533
+
+// WiFi station, associated in the background; services follow the link
+#define WIFI_CONNECT_TIMEOUT_MS 20000   // One association attempt
+#define WIFI_RETRY_MIN_MS 2000          // First retry delay, doubles per failure
+#define WIFI_RETRY_MAX_MS 300000
+#define PARK_AZIMUTH 0.0
+#define PARK_ELEVATION 0.0
+
+// Pass prediction cache (built on Core 1, served on /passes)
+#define PASS_CACHE_HOURS 48            // Prediction window
+#define PASS_CACHE_REFRESH_HOURS 6     // Rebuild so the window stays ahead
+#define PASS_MIN_ELEVATION 0.0         // AOS/LOS elevation (deg)
 
 // Safety Limits (with 5 degree margin for detection)
 #define MAX_ELEVATION 90.0
 #define MIN_ELEVATION 0.0
 
+// Manual Jog (joystick velocity mode)
+#define JOG_MAX_SPEED_AZ 12.0  // deg/s at full deflection
+#define JOG_MAX_SPEED_EL 8.0   // deg/s at full deflection
+#define JOG_ACCEL_AZ 24.0      // deg/s^2
+#define JOG_ACCEL_EL 16.0      // deg/s^2
+#define JOG_EXPO 0.5           // 0 = linear, 1 = fully cubic stick response
+#define JOG_MAX_DT 0.05        // s, longest loop period applied as one jog step
+
 // Display Settings
 #define SCREEN_WIDTH  320
 #define SCREEN_HEIGHT 240
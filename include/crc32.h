@@ -0,0 +1,24 @@
+/*
+ * crc32.h - CRC-32 (IEEE 802.3 / zlib) and CRC-16/CCITT checksums
+ * CRC-32 is computed by the RP2350 DMA sniffer on Core 0, with a table
+ * fallback for short buffers and Core 1 callers
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+// CRC-32/ISO-HDLC: reflected polynomial 0xEDB88320, init and final XOR
+// 0xFFFFFFFF. Matches zlib.crc32() and binascii.crc32() on the host.
+uint32_t calculateCrc32(const void* data, size_t len);
+
+// Continue a CRC-32 over the next chunk, as zlib.crc32(data, crc): start
+// with 0 and pass each result back in. One call equals calculateCrc32().
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len);
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, init 0xFFFF, no final XOR.
+// Binary link frames and version 2 field log records.
+uint16_t calculateCrc16(const void* data, size_t len);
+
+#endif // CRC32_H
@@ -19,11 +19,22 @@ void updateGPS();
 // Get GPS object (for advanced usage)
 TinyGPSPlus& getGPS();
 
+// Milliseconds since the last valid fix (since startup if none yet)
+uint32_t getGpsFixAgeMs();
+
+// Current UTC as Unix seconds, advanced from the last fix (0 without a fix)
+uint32_t getGpsUnixTime();
+
 // Dump current GPS data to Serial (for debugging)
 void printGPSStatus();
+
+// One-line GPS validity/position summary (STREAM output)
+void dumpGPSData();
 void printTLE();
 
-// Run GPS module connection test
-void connectionTest();
+// GPS module connection test, split so the CLI can let updateGPS() run in
+// between: begin counts from now, end reports what arrived since
+void beginConnectionTest();
+void endConnectionTest();
 
 #endif // GPS_MODULE_H
@@ -0,0 +1,19 @@
+/*
+ * heap_stats.h - Heap allocation counters
+ * Counts malloc/calloc/realloc calls per core so code paths can be
+ * checked for allocations (see -Wl,--wrap flags in platformio.ini)
+ */
+
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+#include <Arduino.h>
+
+// Allocations made so far on the calling core. Take the difference of two
+// readings around a code path to count its allocations.
+uint32_t getHeapAllocCount();
+
+// Print allocation counters and heap usage (for debugging)
+void printHeapStats();
+
+#endif // HEAP_STATS_H
@@ -0,0 +1,142 @@
+/*
+ * http_server.h - Event-driven HTTP server on the lwIP raw TCP API
+ * Per-connection state machines serviced with bounded work per poll
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Server limits
+#define HTTP_MAX_CONNECTIONS 6
+#define HTTP_MAX_STREAMS 3         // Event streams; the rest stay free for requests
+#define HTTP_RX_BUFFER_SIZE 1536   // Request line + headers + form body (or one upload piece)
+#define HTTP_TX_BUFFER_SIZE 1024   // Headers and one response chunk
+#define HTTP_CONTEXT_SIZE 64       // Per-response scratch for chunk generators
+#define HTTP_HEADER_RESERVE 256    // Room kept for headers ahead of a direct body
+#define HTTP_IDLE_TIMEOUT_MS 10000
+
+typedef enum {
+  HTTP_GET = 0,
+  HTTP_POST,
+  HTTP_OTHER
+} HttpMethod;
+
+// Parsed request, valid only during the handler call
+struct HttpRequest {
+  HttpMethod method;
+  const char* path;        // Without query string
+  const char* query;       // Text after '?', "" if none
+  const char* headers;     // Raw header block (use httpGetHeader)
+  const char* body;        // Request body, "" if none
+  uint16_t bodyLength;
+  bool authorized;         // Valid Basic credentials were supplied
+};
+
+// Opaque connection handle passed to handlers
+struct HttpConnection;
+
+// Route handler. Must answer with exactly one httpSend*() call and must
+// not block; long operations belong in a job polled from the main loop.
+typedef void (*HttpHandler)(HttpConnection* conn, const HttpRequest* req);
+
+// Optional body consumer for uploads larger than the rx buffer. Called
+// once with data == nullptr before the body (a response here rejects the
+// upload), then with each piece as it arrives; the route's handler runs
+// after the last byte with an empty req->body. Requires Content-Length.
+typedef void (*HttpBodyHandler)(HttpConnection* conn, const HttpRequest* req,
+                                const char* data, size_t len);
+
+struct HttpRoute {
+  const char* path;
+  HttpMethod method;
+  bool requireAuth;
+  HttpHandler handler;
+  HttpBodyHandler bodyHandler;   // nullptr: body buffered in rx
+};
+
+// Chunk generator for streamed responses. Write up to 'cap' bytes into
+// 'buf' and return the count; return 0 when the response is complete.
+// 'context' is HTTP_CONTEXT_SIZE bytes of per-response state, zeroed when
+// the response starts.
+typedef size_t (*HttpChunkGenerator)(char* buf, size_t cap, void* context);
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Start listening. 'routes' must stay valid while the server runs.
+bool startHttpServer(uint16_t port, const HttpRoute* routes, uint8_t routeCount,
+                     const char* username, const char* password);
+
+// Close the listener and all connections
+void stopHttpServer();
+
+// Service all connections: parse, dispatch and send at most one chunk per
+// connection per call (call from main loop)
+void pollHttpServer();
+
+bool isHttpServerRunning();
+
+// ============================================================================
+// RESPONSE API (call from a handler)
+// ============================================================================
+
+// Complete response with a small body (copied)
+void httpSend(HttpConnection* conn, int status, const char* contentType, const char* body);
+
+// Same, with extra header lines (each ending in "\r\n")
+void httpSendWithHeaders(HttpConnection* conn, int status, const char* contentType,
+                         const char* extraHeaders, const char* body);
+
+// Direct body: serialize into the connection's own send buffer (no
+// intermediate copy), then commit 'length' bytes with httpSendBody().
+char* httpBodyBuffer(HttpConnection* conn, size_t* capacity);
+void httpSendBody(HttpConnection* conn, int status, const char* contentType,
+                  const char* extraHeaders, size_t length);
+
+// Response streamed from an open file (closed when done or on error).
+// The length comes from file.size().
+void httpSendFile(HttpConnection* conn, int status, const char* contentType,
+                  const char* extraHeaders, File file);
+
+// Chunked response produced by 'generator' as the send buffer drains.
+// Returns the generator context so the handler can seed it.
+void* httpSendChunked(HttpConnection* conn, int status, const char* contentType,
+                      HttpChunkGenerator generator);
+
+// Turn the connection into a Server-Sent Events stream. It stays open
+// and receives every httpBroadcastEvent() frame. Answers 503 when
+// HTTP_MAX_STREAMS are already open.
+void httpBeginEventStream(HttpConnection* conn);
+
+// ============================================================================
+// EVENT STREAMS
+// ============================================================================
+
+// Send one pre-serialized SSE frame ("event: ...\ndata: ...\n\n") to every
+// open stream. Clients whose send window cannot take the whole frame skip
+// it rather than queue it. Returns the number of clients that got it.
+uint8_t httpBroadcastEvent(const char* frame, size_t len);
+
+// Number of open event streams
+uint8_t httpEventStreamCount();
+
+// Streams that became ready for broadcasts (headers sent) since the last
+// call, so the caller can send them an initial frame
+uint8_t httpTakeNewEventStreams();
+
+// Find 'name' in a query string or form body and URL-decode its value
+// into 'out'. Returns false if the parameter is missing.
+bool httpGetParam(const char* params, const char* name, char* out, size_t outSize);
+
+// Copy a request header value into 'out' (case-insensitive name).
+// Returns false if the header is missing.
+bool httpGetHeader(const HttpRequest* req, const char* name, char* out, size_t outSize);
+
+// Print connection table and counters (for debugging)
+void printHttpServerStatus();
+
+#endif // HTTP_SERVER_H
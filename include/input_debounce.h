@@ -0,0 +1,31 @@
+/*
+ * input_debounce.h - PIO input debouncer for mechanical inputs
+ * Buttons, index sensors and e-stop sampled and debounced in PIO
+ */
+
+#ifndef INPUT_DEBOUNCE_H
+#define INPUT_DEBOUNCE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Called from the debouncer IRQ for each clean transition.
+// 'level' is the new pin level, 'timeUs' the micros() time the pin
+// settled (the debounce delay is already subtracted).
+typedef void (*InputEdgeHandler)(uint8_t pin, bool level, uint32_t timeUs);
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Add a pin (configured as INPUT_PULLUP) to the debouncer and report its
+// transitions to 'handler'. Restarts the PIO sampler with the new pin set.
+bool addDebouncedInput(uint8_t pin, InputEdgeHandler handler);
+
+// Current debounced level of a pin (false if the pin is not debounced)
+bool getDebouncedInput(uint8_t pin);
+
+// Print debouncer configuration and counters (for debugging)
+void printInputDebounceStatus();
+
+#endif // INPUT_DEBOUNCE_H
@@ -45,14 +45,18 @@ JoystickData getJoystickState();
 // Check if joystick is in deadband
 bool isJoystickCentered();
 
-// Get speed command for azimuth (-1.0 to +1.0)
+// Get speed command for azimuth (-1.0 to +1.0, after expo curve)
 // Negative = left, Positive = right, 0 = stop
 float getJoystickAzimuthSpeed();
 
-// Get speed command for elevation (-1.0 to +1.0)
+// Get speed command for elevation (-1.0 to +1.0, after expo curve)
 // Negative = down, Positive = up, 0 = stop
 float getJoystickElevationSpeed();
 
+// Expo curve for speed commands (0 = linear, 1 = cubic)
+void setJoystickExpo(float expo);
+float getJoystickExpo();
+
 // Manual mode control (called by display/serial, not by joystick button)
 void setJoystickManualMode(bool active);
 bool isJoystickManualMode();
@@ -94,6 +98,9 @@ void updateJoystick();
 
 // Dump current GPS data to Serial (for debugging)
 void printJoystickStatus();
-void printRawJoystickData(int samples);
+
+// Raw readings table: header, then one row per call (the CLI paces them)
+void printRawJoystickHeader(int samples);
+void printRawJoystickSample(int index);
 
 #endif // JOYSTICK_MODULE_H
\ No newline at end of file
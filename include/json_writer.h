@@ -0,0 +1,57 @@
+/*
+ * json_writer.h - Allocation-free streaming JSON writer
+ * Formats straight into a caller-provided buffer with fixed-point floats
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+#define JSON_MAX_DEPTH 16
+
+// Writer state. Output is always NUL-terminated; on overflow it is cut
+// short, 'overflow' is set and jsonLength() returns 0.
+struct JsonWriter {
+  char* buf;
+  size_t cap;              // Buffer size including the terminator
+  size_t len;
+  bool overflow;
+  uint8_t depth;
+  uint16_t hasItems;       // Bit per nesting level: a comma is needed
+};
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+// Functions taking a 'key' write "key": first; pass nullptr inside arrays.
+
+void jsonBegin(JsonWriter* w, char* buf, size_t cap);
+
+void jsonObjectBegin(JsonWriter* w, const char* key = nullptr);
+void jsonObjectEnd(JsonWriter* w);
+void jsonArrayBegin(JsonWriter* w, const char* key = nullptr);
+void jsonArrayEnd(JsonWriter* w);
+
+void jsonString(JsonWriter* w, const char* key, const char* value);
+void jsonBool(JsonWriter* w, const char* key, bool value);
+void jsonInt(JsonWriter* w, const char* key, int32_t value);
+void jsonUInt(JsonWriter* w, const char* key, uint32_t value);
+void jsonNull(JsonWriter* w, const char* key);
+
+// Fixed-point number with 'decimals' (0-6) digits after the point,
+// rounded half away from zero. NaN and infinity are written as null.
+void jsonFixed(JsonWriter* w, const char* key, double value, uint8_t decimals);
+
+// Append raw text (must already be valid JSON in context)
+void jsonRaw(JsonWriter* w, const char* text);
+
+// Bytes written (excluding the terminator); 0 if the output overflowed
+size_t jsonLength(const JsonWriter* w);
+
+// The fixed-point formatter behind jsonFixed(), for other text protocols.
+// Writes a NUL-terminated number into 'out'; returns its length, or 0 if
+// the value is NaN, infinite, out of range or does not fit.
+size_t formatFixed(char* out, size_t outSize, double value, uint8_t decimals);
+
+#endif // JSON_WRITER_H
@@ -19,9 +19,19 @@ typedef enum {
   LED_MODE_FLASH_YELLOW,      // GPS acquisition
   LED_MODE_FLASH_BLUE,        // Compass calibration
   LED_MODE_RAINBOW,           // Test/demo mode
+  LED_MODE_POINTING,          // Antenna/satellite azimuth indicator
   LED_MODE_CUSTOM             // User-defined pattern
 } LEDMode;
 
+// Animation layers, composited bottom to top. Each layer runs one mode;
+// LED_MODE_OFF leaves a layer transparent.
+typedef enum {
+  LED_LAYER_STATUS = 0,       // System state (setLEDMode)
+  LED_LAYER_POINTER,          // Pointing indicator markers
+  LED_LAYER_ALERT,            // Emergency stop, calibration
+  LED_LAYER_COUNT
+} LEDLayer;
+
 // RGB color structure
 struct RGBColor {
   uint8_t r;
@@ -36,12 +46,16 @@ struct RGBColor {
 // Initialize LED module (sets up PIO)
 void initLEDs();
 
-// Set LED mode (automatic pattern control)
+// Set LED mode (automatic pattern control) of the status layer
 void setLEDMode(LEDMode mode);
 
-// Get current LED mode
+// Get current status layer mode
 LEDMode getLEDMode();
 
+// Set/get the mode running on a specific layer
+void setLEDLayerMode(LEDLayer layer, LEDMode mode);
+LEDMode getLEDLayerMode(LEDLayer layer);
+
 // Get pointer to LED buffer for direct manipulation
 uint32_t* getLEDBuffer();
 
@@ -54,10 +68,16 @@ void setLED(uint8_t index, RGBColor color);
 void setLEDBrightness(uint8_t brightness); // 0-255
 uint8_t getLEDBrightness(); // Get current brightness
 void showLEDs(); // Push buffer to LEDs
-void testLEDs(); // Run LED test sequence
+void benchmarkLEDs(); // Time frame rendering for 24 and 50 LED rings
+
+// LED test sequence, one tick per call every LED_TEST_TICK_MS (LEDTEST runs
+// it as a CLI stream). Layer rendering pauses while ticks keep coming.
+#define LED_TEST_TICK_MS 50
+int getLEDTestTicks();
+void stepLEDTest(int tick);
 
 // Helper functions for common colors
-RGBColor RGB(uint32_t r, uint32_t g, uint32_t b);
+RGBColor RGB(uint8_t r, uint8_t g, uint8_t b);
 RGBColor colorRed();
 RGBColor colorGreen();
 RGBColor colorBlue();
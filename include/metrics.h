@@ -0,0 +1,88 @@
+/*
+ * metrics.h - Counter/gauge/histogram registry with Prometheus text export
+ * Hot paths only do atomic adds on preallocated slots; all formatting
+ * happens when /metrics (or the METRICS command) is read
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+// Counters and gauges with stored values. Sampled gauges (heap, stack,
+// GPS age, uptime) are read at scrape time and have no id here.
+typedef enum {
+  METRIC_CONTROL_LOOPS = 0,
+  METRIC_TRACKING_ERROR_RMS,       // Millidegrees, current/last pass
+  METRIC_PASSES_TRACKED,
+  METRIC_ENCODER_INVALID_EL,
+  METRIC_ENCODER_INVALID_AZ,
+  METRIC_SGP4_EVALUATIONS,
+  METRIC_PASS_SEARCHES,
+  METRIC_SGP4_INITS,               // Predictors initialised from TLE text
+  METRIC_SGP4_CACHE_HITS,          // Predictors copied from the SGP4 cache
+  METRIC_PASS_SATELLITES_SCREENED, // Watched satellites that cannot rise at the site
+  METRIC_COUNT
+} MetricId;
+
+typedef enum {
+  HISTOGRAM_CONTROL_JITTER = 0,    // Microseconds
+  HISTOGRAM_HTTP_LATENCY,          // Microseconds
+  HISTOGRAM_COUNT
+} HistogramId;
+
+#define METRICS_MAX_BUCKETS 8
+
+struct MetricHistogramData {
+  volatile uint32_t counts[METRICS_MAX_BUCKETS + 1];   // Per bucket, last is +Inf
+  volatile uint32_t sum;
+};
+
+extern volatile uint32_t metricValues[METRIC_COUNT];
+extern MetricHistogramData metricHistograms[HISTOGRAM_COUNT];
+extern const uint32_t* const metricHistogramBounds[HISTOGRAM_COUNT];
+extern const uint8_t metricHistogramBucketCount[HISTOGRAM_COUNT];
+
+// ============================================================================
+// HOT PATH (lock-free, safe from either core and from interrupts)
+// ============================================================================
+
+static inline void metricAdd(MetricId id, uint32_t n) {
+  __atomic_fetch_add(&metricValues[id], n, __ATOMIC_RELAXED);
+}
+
+static inline void metricInc(MetricId id) {
+  metricAdd(id, 1);
+}
+
+static inline void metricSet(MetricId id, int32_t value) {
+  __atomic_store_n(&metricValues[id], (uint32_t)value, __ATOMIC_RELAXED);
+}
+
+static inline void metricObserve(HistogramId id, uint32_t value) {
+  const uint32_t* bounds = metricHistogramBounds[id];
+  uint8_t n = metricHistogramBucketCount[id];
+  uint8_t bucket = 0;
+  while (bucket < n && value > bounds[bucket]) {
+    bucket++;
+  }
+  __atomic_fetch_add(&metricHistograms[id].counts[bucket], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&metricHistograms[id].sum, value, __ATOMIC_RELAXED);
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Paint the calling core's unused stack so the scrape can report its
+// low-water mark. Call once early in setup() and setup1().
+void initStackWatermark();
+
+// Chunk generator producing the Prometheus text exposition. 'context'
+// must start zeroed (as HttpChunkGenerator contexts do).
+size_t metricsChunk(char* buf, size_t cap, void* context);
+
+// Print the same text to Serial
+void printMetrics();
+
+#endif // METRICS_H
@@ -0,0 +1,37 @@
+/*
+ * motion_profile.h - Acceleration-limited velocity profiler for one axis
+ * Turns a velocity command into a smooth position setpoint for the PID loop
+ */
+
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <Arduino.h>
+
+// Profile state for one axis
+struct AxisProfile {
+  float position;      // Setpoint handed to the position loop (degrees)
+  float velocity;      // Current profile velocity (degrees/s)
+  float maxAccel;      // Acceleration limit (degrees/s^2)
+  float minPosition;   // Travel limits (used when 'limited' is set)
+  float maxPosition;
+  bool limited;        // Axis has end stops (elevation) or is continuous (azimuth)
+};
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Set up a profile at rest at 'position'
+void initAxisProfile(AxisProfile* profile, float position, float maxAccel,
+                     float minPosition, float maxPosition, bool limited);
+
+// Stop the profile at a new position (no motion)
+void resetAxisProfile(AxisProfile* profile, float position);
+
+// Advance the profile by dt seconds toward 'commandVelocity' (degrees/s).
+// Velocity changes by at most maxAccel * dt; on a limited axis the profile
+// also slows so it can stop at the travel limit. Returns the new position.
+float updateAxisProfile(AxisProfile* profile, float commandVelocity, float dt);
+
+#endif // MOTION_PROFILE_H
@@ -36,8 +36,28 @@ bool isEmergencyStop();
 float pidControl(float error, float &errorIntegral, float &lastError, float dt);
 void updateMotorControl();
 
+// Raw encoder counts and target-minus-measured error (deg), read now
+void readEncoderSample(int32_t* countEl, int32_t* countAz, float* errorAz, float* errorEl);
+
+// Joystick jog: step the target position over dt seconds (the measured
+// period of the main loop's control block)
+void updateManualJog(float dt);
+
 // Homing
-void homeAxes();
+typedef enum {
+  HOMING_IDLE = 0,
+  HOMING_ELEVATION,    // Driving elevation toward its index
+  HOMING_AZIMUTH,      // Driving azimuth toward its index
+  HOMING_SETTLING,     // Both found, waiting for the axes to stop
+  HOMING_DONE,
+  HOMING_FAILED
+} HomingState;
+
+bool beginHoming();           // Start non-blocking homing (false if not started)
+HomingState updateHoming();   // Step homing (call periodically while active)
+HomingState getHomingState();
+bool cancelHoming();          // Stop a running homing (state FAILED); false if none
+void homeAxes();              // Blocking: begin + update until finished
 
 // PIO encoder functions
 void setupPIOEncoders();
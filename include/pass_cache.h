@@ -0,0 +1,92 @@
+/*
+ * pass_cache.h - Precomputed pass schedule for a watch list of satellites
+ * Built in the background on Core 1, queried from Core 0 by binary search
+ */
+
+#ifndef PASS_CACHE_H
+#define PASS_CACHE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "tle_catalog.h"
+
+#define PASS_CACHE_SIZE 256       // Passes per buffer (two buffers)
+#define PASS_WATCH_MAX 12         // Satellites predicted, incl. the tracked one
+#define PASS_QUERY_MAX_SATS 8     // Satellite filter entries per query
+#define PASS_BUILD_SLICE_US 20000 // Core 1 prediction time per call
+
+// One predicted pass, 20 bytes. Angles in tenths of a degree.
+struct PassEntry {
+  uint32_t aos;            // Unix time (s)
+  uint32_t los;
+  uint32_t noradId;
+  uint16_t aosAz;
+  uint16_t maxAz;
+  uint16_t losAz;
+  int16_t maxEl;
+};
+
+// Passes overlapping [from, to), optionally for some satellites only
+struct PassQuery {
+  uint32_t from;
+  uint32_t to;
+  uint32_t sats[PASS_QUERY_MAX_SATS];
+  uint8_t satCount;        // 0 = all cached satellites
+};
+
+// Resume point for queryPasses(); start with passCursorBegin()
+struct PassCursor {
+  uint32_t aos;
+  uint32_t noradId;
+  bool done;
+};
+
+struct PassCacheInfo {
+  bool ready;
+  uint32_t start;          // Window covered (Unix time)
+  uint32_t end;
+  uint16_t count;
+  uint16_t dropped;        // Passes that did not fit
+  uint8_t screened;        // Satellites skipped: orbit never rises at the site
+  uint32_t buildMs;
+};
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Core 1: reset, then call from loop1(). Rebuilds when the watch list,
+// the site or the window start changes; bounded work per call.
+void initPassCache();
+void updatePassCache();
+
+// Core 0: set the satellites to predict (NORAD IDs, looked up in the
+// catalog). The tracked satellite is always included. Returns how many
+// were found.
+uint8_t setPassWatchList(const uint32_t* ids, uint8_t count);
+
+// Core 0: re-resolve the watch list when the catalog or the tracked TLE
+// changes (call from the main loop)
+void pollPassCache();
+
+// Watched satellite name, "" if not watched
+const char* getPassWatchName(uint32_t noradId);
+
+// Resolved watch list (NORAD IDs, tracked satellite first)
+uint8_t getPassWatchList(uint32_t* ids, uint8_t maxIds);
+
+// Parse "25544,43017 33591" into IDs. Returns 0 on malformed input.
+uint8_t parseNoradList(const char* text, uint32_t* ids, uint8_t maxIds);
+
+// Copy up to maxOut passes that follow 'cursor' in (AOS, NORAD ID) order
+// and match 'query'. Advances the cursor; sets cursor->done at the end.
+// Safe against a concurrent rebuild.
+void passCursorBegin(const PassQuery* query, PassCursor* cursor);
+uint16_t queryPasses(const PassQuery* query, PassCursor* cursor, PassEntry* out, uint16_t maxOut);
+
+void getPassCacheInfo(PassCacheInfo* info);
+
+// Print watch list, cache state and upcoming passes (for debugging)
+void printPassCacheStatus(uint8_t maxPasses);
+
+#endif // PASS_CACHE_H
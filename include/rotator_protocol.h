@@ -0,0 +1,43 @@
+/*
+ * rotator_protocol.h - Yaesu GS-232A/B and EasyComm II on the USB serial port
+ * Lets station software that only speaks serial rotator protocols drive
+ * the tracker; selected with the PROTOCOL console command
+ */
+
+#ifndef ROTATOR_PROTOCOL_H
+#define ROTATOR_PROTOCOL_H
+
+#include <Arduino.h>
+#include "config.h"
+
+typedef enum {
+  ROTATOR_PROTOCOL_NONE = 0,   // Human CLI
+  ROTATOR_PROTOCOL_GS232A,
+  ROTATOR_PROTOCOL_GS232B,
+  ROTATOR_PROTOCOL_EASYCOMM2,
+  ROTATOR_PROTOCOL_COUNT
+} RotatorProtocol;
+
+#define ROTATOR_LINE_SIZE 48
+#define ROTATOR_ESCAPE "+++"   // Returns to the CLI from any protocol mode
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Switch protocol; ROTATOR_PROTOCOL_NONE hands the port back to the CLI
+void setRotatorProtocol(RotatorProtocol protocol);
+RotatorProtocol getRotatorProtocol();
+
+// Protocol by name ("GS232A", "GS232B", "EASYCOMM", "CLI");
+// returns false if unknown
+bool parseRotatorProtocol(const char* name, RotatorProtocol* protocol);
+const char* rotatorProtocolName(RotatorProtocol protocol);
+
+// Feed one received byte; replies are written to Serial
+void feedRotatorProtocol(char c);
+
+// Print protocol mode and counters (for debugging)
+void printRotatorProtocolStatus();
+
+#endif // ROTATOR_PROTOCOL_H
@@ -0,0 +1,37 @@
+/*
+ * rotctl_server.h - Hamlib rotctld-compatible TCP rotator server
+ * Lets Gpredict, SatNOGS and rotctl (model 2, NET rotctl) drive the tracker
+ */
+
+#ifndef ROTCTL_SERVER_H
+#define ROTCTL_SERVER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Server limits
+#define ROTCTL_MAX_CLIENTS 4
+#define ROTCTL_RX_BUFFER_SIZE 128    // Pending command text per client
+#define ROTCTL_REPLY_SIZE 192        // Longest reply (\dump_state)
+#define ROTCTL_MAX_LINES_PER_POLL 4  // Commands handled per client per poll
+#define ROTCTL_IDLE_TIMEOUT_MS 120000
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Start listening for rotctl clients
+bool startRotctlServer(uint16_t port);
+
+// Close the listener and all clients
+void stopRotctlServer();
+
+// Execute pending commands (call from main loop)
+void pollRotctlServer();
+
+bool isRotctlServerRunning();
+
+// Print clients and counters (for debugging)
+void printRotctlServerStatus();
+
+#endif // ROTCTL_SERVER_H
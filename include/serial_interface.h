@@ -20,10 +20,18 @@
 // Command buffer size
 #define SERIAL_BUFFER_SIZE 128
 
-// Command parsing
-struct SerialCommand {
-  char command[32];
-  char args[96];
+// Parsed command arguments (see the command table in serial_interface.cpp)
+#define SERIAL_MAX_ARGS 2
+
+struct CommandArg {
+  long i;                  // Integer value (I, or F truncated)
+  float f;                 // Numeric value (F, or I converted)
+  const char* s;           // Argument text (all types)
+};
+
+struct CommandArgs {
+  uint8_t count;           // Arguments supplied
+  CommandArg arg[SERIAL_MAX_ARGS];
 };
 
 // ============================================================================
@@ -73,9 +81,9 @@ void setTLE(const char* name, const char* line1, const char* line2);
 void printTLE();
 
 // Diagnostic functions
-void printRawCompassData(int samples);
-void printRawJoystickData(int samples);
 void printEncoderCounts();
+
+// Print GPS data once a second for 'duration' seconds (any key stops)
 void streamGPSData(unsigned long duration);
 
 // LED Funtions
@@ -0,0 +1,28 @@
+/*
+ * sgp4_cache.h - Initialised SGP4 predictors kept in RAM (Core 1)
+ * Switching back to a recently used element set copies its initialised
+ * state instead of parsing the TLE text and re-running the SGP4 setup
+ */
+
+#ifndef SGP4_CACHE_H
+#define SGP4_CACHE_H
+
+#include <Arduino.h>
+#include <Sgp4.h>
+#include "config.h"
+
+#define SGP4_CACHE_SIZE 16        // Pass watch list plus a few recent selections
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Core 1 only. Set up 'sat' for a TLE, from the cache when these element
+// lines were initialised before. Replaces the whole predictor, observer
+// site included: call site() afterwards. False if the TLE is rejected.
+bool initSatellite(Sgp4* sat, const char* name, const char* line1, const char* line2);
+
+// Print cache use (for debugging)
+void printSgp4CacheStatus();
+
+#endif // SGP4_CACHE_H
@@ -39,6 +39,29 @@ struct TrackerState {
   volatile bool tracking;
 };
 
+// Pose snapshot shared between cores. Each half has a single writer
+// (antenna: Core 0 control loop, satellite: Core 1 tracking) and its own
+// sequence counter, so readers on either core never see a torn update.
+struct AntennaPose {
+  float azimuth;        // Encoder azimuth (0-360)
+  float elevation;      // Encoder elevation
+  float errorAz;        // Target minus current, shortest path
+  float errorEl;        // Target minus current
+};
+
+struct SatellitePose {
+  float azimuth;        // Current satellite azimuth
+  float elevation;      // Current satellite elevation (negative = below horizon)
+  float aosAzimuth;     // Azimuth at next acquisition of signal
+  bool valid;           // Satellite position is being computed
+  bool aosValid;        // aosAzimuth holds a prediction
+};
+
+struct PoseSnapshot {
+  AntennaPose antenna;
+  SatellitePose satellite;
+};
+
 // Global shared data
 extern MotorPosition motorPos;
 extern TargetPosition targetPos;
@@ -78,4 +101,9 @@ extern bool wifiConfigured;
 // Function to initialize shared data
 void initSharedData();
 
+// Pose snapshot access (lock-free, safe from either core)
+void publishAntennaPose(const AntennaPose& pose);
+void publishSatellitePose(const SatellitePose& pose);
+void getPoseSnapshot(PoseSnapshot* snapshot);
+
 #endif // SHARED_DATA_H
\ No newline at end of file
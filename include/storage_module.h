@@ -16,7 +16,9 @@ typedef enum {
   STORAGE_TYPE_SD_CARD
 } StorageType;
 
-// Configuration structure for persistent storage
+// Configuration structure for persistent storage. Stored field by field
+// (see the schema in storage_module.cpp): a new member needs a field ID,
+// and a change of meaning needs a CONFIG_VERSION bump and migration step.
 struct StorageConfig {
   // WiFi credentials
   char wifiSSID[32];
@@ -41,18 +43,14 @@ struct StorageConfig {
   char tleLine1[70];
   char tleLine2[70];
   bool tleValid;
-  
-  // Magic number and version for validation
-  uint32_t magic;      // 0xCAFEBABE
-  uint16_t version;    // Config structure version
-  uint16_t checksum;   // Simple checksum for validation
 };
 
 // ============================================================================
 // PUBLIC API
 // ============================================================================
 
-// Initialize storage (auto-detects type)
+// Initialize storage (auto-detects type) and rebuild the configuration
+// from the config log
 bool initStorage();
 
 // Get detected storage type
@@ -61,12 +59,22 @@ StorageType getStorageType();
 // Check if storage is available
 bool isStorageAvailable();
 
-// Load configuration from storage
+// Copy the configuration from the RAM cache (no flash access)
 bool loadConfig(StorageConfig* config);
 
-// Save configuration to storage
+// Update the RAM cache and mark it dirty. The changed fields reach flash
+// on a later updateStorage() once changes have been quiet for a moment.
 bool saveConfig(const StorageConfig* config);
 
+// Write-behind flush; call from the Core 0 main loop
+void updateStorage();
+
+// Append pending changes to flash now
+bool flushConfig();
+
+// True while the cache holds changes not yet on flash
+bool isConfigDirty();
+
 // Erase all stored configuration
 bool eraseConfig();
 
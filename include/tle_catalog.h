@@ -0,0 +1,121 @@
+/*
+ * tle_catalog.h - On-flash TLE catalog with streaming 3LE ingest
+ * Uploads are parsed line by line as they arrive and written straight to
+ * LittleFS, so catalog size is bounded by flash, not RAM. The committed
+ * catalog is sorted by NORAD ID and indexed in RAM by ID and name.
+ */
+
+#ifndef TLE_CATALOG_H
+#define TLE_CATALOG_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define TLE_CATALOG_FILE "/tle_catalog.dat"
+#define TLE_CATALOG_TEMP_FILE "/tle_catalog.tmp"   // Upload, in arrival order
+#define TLE_CATALOG_BUILD_FILE "/tle_catalog.new"  // Sorted catalog being written
+#define TLE_CATALOG_MAX_ENTRIES 1000    // Upload + sorted copy must fit the 0.5 MB filesystem
+#define TLE_NAME_KEY_LENGTH 10          // Name index key: upper-cased name prefix
+#define TLE_LINE_LENGTH 69
+#define TLE_INGEST_LINE_SIZE 96         // Longest input line accepted
+
+// Mean elements of a TLE, parsed once at ingest. Single precision is
+// plenty for screening and display; propagation still initialises SGP4
+// from the text lines.
+struct TleElements {
+  float inclination;                    // Degrees
+  float raan;                           // Right ascension of the ascending node (deg)
+  float eccentricity;
+  float argPerigee;                     // Degrees
+  float meanAnomaly;                    // Degrees
+  float meanMotion;                     // Revolutions per day
+  float bstar;                          // Drag term (1/earth radii)
+};
+
+// One catalog entry as stored on flash
+struct TleRecord {
+  uint32_t noradId;
+  uint32_t epoch;                       // Element set epoch (Unix time)
+  TleElements elements;
+  char name[25];
+  char line1[TLE_LINE_LENGTH + 1];
+  char line2[TLE_LINE_LENGTH + 1];
+};
+
+// Result of an ingest run
+struct CatalogIngestStats {
+  uint32_t lines;
+  uint32_t entries;          // Records written
+  uint32_t badChecksum;      // Entries rejected for a checksum mismatch
+  uint32_t badFormat;        // Entries rejected for layout/field errors
+  uint32_t dropped;          // Valid entries beyond TLE_CATALOG_MAX_ENTRIES
+  uint32_t duplicates;       // Entries superseded by a later one with the same NORAD ID
+  uint32_t bytes;
+  uint32_t elapsedMs;
+  float entriesPerSec;
+};
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+// Validate a TLE pair: length, line numbers, checksums, matching catalog
+// numbers and field ranges. On failure 'error' (if given) gets a reason.
+bool validateTle(const char* line1, const char* line2, char* error = nullptr, size_t errorSize = 0);
+
+// Catalog number (NORAD ID) of a TLE line 1, Alpha-5 aware; 0 if malformed
+uint32_t tleCatalogNumber(const char* line1);
+
+// Epoch of a TLE line 1 as Unix time (to the second); 0 if malformed
+uint32_t tleEpoch(const char* line1);
+
+// Mean elements of a TLE; false if a field is malformed
+bool parseTleElements(const char* line1, const char* line2, TleElements* elements);
+
+// Streaming ingest. Only one ingest or build runs at a time.
+// endCatalogIngest() returns true if it started a catalog build; 'stats'
+// are final only once the build finishes (getLastIngestStats()). With no
+// usable entries the old catalog is kept and false is returned.
+bool beginCatalogIngest();
+void feedCatalogIngest(const char* data, size_t len);
+bool endCatalogIngest(CatalogIngestStats* stats);
+void abortCatalogIngest();
+bool isCatalogIngestActive();
+
+// Catalog build: sorts an upload (or an older catalog format found on
+// first use) into the live catalog. stepCatalogBuild() does a few records
+// of flash I/O per call; the web interface runs it as a "catalog" job.
+// The old catalog is deleted when the build starts, so the upload and the
+// new copy fit the flash together; lookups see an empty catalog until the
+// build ends, and stay empty if it fails.
+typedef enum {
+  CATALOG_BUILD_IDLE = 0,
+  CATALOG_BUILD_RUNNING,
+  CATALOG_BUILD_DONE,       // Last build committed a catalog
+  CATALOG_BUILD_FAILED
+} CatalogBuildState;
+
+CatalogBuildState stepCatalogBuild();
+bool isCatalogBuildActive();
+const char* getCatalogBuildMessage();
+
+// Stats of the last finished ingest; false if there has been none
+bool getLastIngestStats(CatalogIngestStats* stats);
+
+// Catalog contents, in NORAD ID order. Lookups are binary searches over
+// the RAM index followed by a single record read.
+uint32_t getCatalogCount();
+bool readCatalogRecord(uint32_t index, TleRecord* record);
+bool findCatalogRecord(uint32_t noradId, TleRecord* record);
+
+// Records whose name starts with 'prefix' (case-insensitive), in name
+// order. Stores up to maxResults record indices; returns how many.
+uint32_t findCatalogByName(const char* prefix, uint32_t* indices, uint32_t maxResults);
+
+// Incremented each time a build commits a new catalog
+uint32_t getCatalogGeneration();
+
+// Print catalog summary and last ingest stats (for debugging)
+void printCatalogStatus();
+
+#endif // TLE_CATALOG_H
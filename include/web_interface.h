@@ -7,22 +7,39 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
 #include "config.h"
 #include "shared_data.h"
 #include "motor_control.h"
+#include "http_server.h"
+#include "json_writer.h"
+#include "rotctl_server.h"
+#include "tle_catalog.h"
+#include "pass_cache.h"
+#include "gps_module.h"
+#include "metrics.h"
 
-// Initialize web interface
+// Initialize web interface and start WiFi association in the background
+// (returns immediately; services start once the link is up)
 void initWebInterface();
 
-// Handle web client requests
+// Drop the current link and associate again with the current credentials
+void reconnectWiFi();
+
+// Link up and network services running
+bool isWiFiOnline();
+
+// Link state machine and reconnect counters
+void printWiFiLinkStatus();
+
+// Service HTTP and rotctl connections and async jobs (call from main loop,
+// never blocks)
 void handleWebClient();
 
-// Web server handlers
-void handleRoot();
-void handleTLE();
-void handleHome();
-void handleStop();
-void handleNotFound();
+// Live telemetry (/events) pose frame rate, 0 = status events only
+void setTelemetryRate(uint8_t hz);
+uint8_t getTelemetryRate();
+
+// Tracker status document (served by /status, also used on the console)
+void writeStatusJson(JsonWriter* w);
 
 #endif // WEB_INTERFACE_H
@@ -0,0 +1,210 @@
+"""
+binlink_decode.py - Decode the tracker's binary link into CSV
+
+Reads COBS-framed messages (see include/binary_link.h) from the USB serial
+port or a raw capture file and writes one CSV per message type:
+<prefix>_telemetry.csv and <prefix>_encoder.csv. Frames with a bad CRC
+or stray console text between frames are skipped and counted.
+
+    python scripts/binlink_decode.py /dev/ttyACM0 -o run1 --enter --encoder
+    python scripts/binlink_decode.py capture.bin -o run1
+
+Ctrl-C stops logging; on a serial port the tracker is sent back to the
+text console. Linux only for serial ports (uses termios, no pyserial).
+"""
+
+import argparse
+import csv
+import os
+import stat
+import struct
+import sys
+import termios
+import tty
+
+VERSION = 1
+
+MSG_TELEMETRY = 0x01
+MSG_ENCODER = 0x02
+MSG_COMMAND = 0x10
+MSG_ACK = 0x11
+
+CMD_TELEMETRY_RATE = 6
+CMD_ENCODER_STREAM = 7
+CMD_EXIT = 8
+
+TELEMETRY = struct.Struct("<IffffffBBH")
+TELEMETRY_FIELDS = ("time_ms", "azimuth", "elevation", "target_az", "target_el",
+                    "sat_az", "sat_el", "flags", "reserved", "dropped")
+ENCODER = struct.Struct("<Iiiff")
+ENCODER_FIELDS = ("time_us", "count_el", "count_az", "error_az", "error_el")
+COMMAND = struct.Struct("<B3xff")
+ACK = struct.Struct("<HBB")
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_pos = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_pos] = code
+            code_pos = len(out)
+            out.append(0)
+            code = 1
+        else:
+            out.append(byte)
+            code += 1
+            if code == 0xFF:
+                out[code_pos] = code
+                code_pos = len(out)
+                out.append(0)
+                code = 1
+    out[code_pos] = code
+    out.append(0)
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def build_frame(msg_type, seq, payload):
+    raw = bytes([VERSION, msg_type]) + struct.pack("<H", seq) + payload
+    return cobs_encode(raw + struct.pack("<H", crc16(raw)))
+
+
+def command_frame(seq, code, arg0=0.0, arg1=0.0):
+    return build_frame(MSG_COMMAND, seq, COMMAND.pack(code, arg0, arg1))
+
+
+class Decoder:
+    def __init__(self, prefix):
+        self.telemetry_file = open(prefix + "_telemetry.csv", "w", newline="")
+        self.encoder_file = open(prefix + "_encoder.csv", "w", newline="")
+        self.telemetry = csv.writer(self.telemetry_file)
+        self.encoder = csv.writer(self.encoder_file)
+        self.telemetry.writerow(("seq",) + TELEMETRY_FIELDS)
+        self.encoder.writerow(("seq",) + ENCODER_FIELDS)
+        self.pending = bytearray()
+        self.frames = 0
+        self.bad = 0
+        self.lost = 0
+        self.last_seq = None
+
+    def feed(self, data):
+        self.pending += data
+        while True:
+            end = self.pending.find(0)
+            if end < 0:
+                return
+            frame = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if frame:
+                self.handle(frame)
+
+    def handle(self, frame):
+        raw = cobs_decode(frame)
+        if raw is None or len(raw) < 6 or raw[0] != VERSION:
+            self.bad += 1
+            return
+        if crc16(raw[:-2]) != struct.unpack_from("<H", raw, len(raw) - 2)[0]:
+            self.bad += 1
+            return
+
+        self.frames += 1
+        msg_type = raw[1]
+        seq = struct.unpack_from("<H", raw, 2)[0]
+        payload = raw[4:-2]
+        if self.last_seq is not None:
+            self.lost += (seq - self.last_seq - 1) & 0xFFFF
+        self.last_seq = seq
+
+        if msg_type == MSG_TELEMETRY and len(payload) == TELEMETRY.size:
+            self.telemetry.writerow((seq,) + TELEMETRY.unpack(payload))
+        elif msg_type == MSG_ENCODER and len(payload) == ENCODER.size:
+            self.encoder.writerow((seq,) + ENCODER.unpack(payload))
+        elif msg_type == MSG_ACK and len(payload) == ACK.size:
+            acked, code, status = ACK.unpack(payload)
+            print(f"ack: command {code} (seq {acked}) status {status}", file=sys.stderr)
+
+    def close(self):
+        self.telemetry_file.close()
+        self.encoder_file.close()
+        print(f"{self.frames} frames, {self.bad} bad, {self.lost} missing by sequence",
+              file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("source", help="serial device or capture file")
+    parser.add_argument("-o", "--output", default="binlink", help="CSV file prefix")
+    parser.add_argument("--enter", action="store_true", help="send BINARY to the console first")
+    parser.add_argument("--rate", type=float, help="telemetry rate in Hz (0-1000)")
+    parser.add_argument("--encoder", type=float, nargs="?", const=100.0, metavar="HZ",
+                        help="enable the encoder stream (0-1000 Hz, default 100)")
+    args = parser.parse_args()
+
+    is_device = stat.S_ISCHR(os.stat(args.source).st_mode)
+    fd = os.open(args.source, os.O_RDWR | os.O_NOCTTY if is_device else os.O_RDONLY)
+    is_tty = os.isatty(fd)
+    saved = None
+    if is_tty:
+        saved = termios.tcgetattr(fd)
+        tty.setraw(fd)
+
+    decoder = Decoder(args.output)
+    seq = 0
+
+    def send(frame):
+        if is_tty:
+            os.write(fd, frame)
+
+    try:
+        if args.enter:
+            send(b"\rBINARY\r")
+        if args.rate is not None:
+            send(command_frame(seq, CMD_TELEMETRY_RATE, args.rate))
+            seq += 1
+        if args.encoder is not None:
+            send(command_frame(seq, CMD_ENCODER_STREAM, args.encoder))
+            seq += 1
+        while True:
+            data = os.read(fd, 4096)
+            if not data:
+                break
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if is_tty:
+            send(command_frame(seq, CMD_EXIT))
+            termios.tcsetattr(fd, termios.TCSADRAIN, saved)
+        os.close(fd)
+        decoder.close()
+
+
+if __name__ == "__main__":
+    main()
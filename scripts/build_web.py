@@ -0,0 +1,91 @@
+"""
+build_web.py - Build the web UI into the LittleFS image
+
+Minifies web/*.{html,css,js}, gzips each file into data/www/<name>.gz
+and stamps asset URLs in the HTML with a content hash so the browser
+can cache them forever. Runs as a PlatformIO pre-script (before build
+and uploadfs) or standalone:
+
+    python scripts/build_web.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+SOURCE_EXTENSIONS = (".html", ".css", ".js")
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    text = re.sub(r">\s+<", "><", text)
+    return re.sub(r"\s+", " ", text).strip()
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{}:;,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    # Conservative: drop comment-only lines, indentation and blank lines.
+    # Line structure is kept so automatic semicolon insertion still works.
+    lines = []
+    for line in text.splitlines():
+        line = line.strip()
+        if line and not line.startswith("//"):
+            lines.append(line)
+    return "\n".join(lines)
+
+
+MINIFIERS = {".html": minify_html, ".css": minify_css, ".js": minify_js}
+
+
+def write_gzip(path, data):
+    # mtime=0 keeps the output byte-identical for identical input
+    with open(path, "wb") as out:
+        with gzip.GzipFile(filename="", mode="wb", fileobj=out, compresslevel=9, mtime=0) as gz:
+            gz.write(data)
+
+
+def build_web(project_dir):
+    source_dir = os.path.join(project_dir, "web")
+    output_dir = os.path.join(project_dir, "data", "www")
+    if not os.path.isdir(source_dir):
+        return
+    os.makedirs(output_dir, exist_ok=True)
+
+    names = sorted(n for n in os.listdir(source_dir) if n.endswith(SOURCE_EXTENSIONS))
+    minified = {}
+    for name in names:
+        with open(os.path.join(source_dir, name), encoding="utf-8") as f:
+            minified[name] = MINIFIERS[os.path.splitext(name)[1]](f.read())
+
+    # Cache busting: reference assets as name?v=<hash>
+    hashes = {n: hashlib.sha1(t.encode("utf-8")).hexdigest()[:8]
+              for n, t in minified.items() if not n.endswith(".html")}
+    for name in names:
+        if name.endswith(".html"):
+            for asset, digest in hashes.items():
+                minified[name] = re.sub(r'(["\'])%s\1' % re.escape(asset),
+                                        r"\g<1>%s?v=%s\g<1>" % (asset, digest),
+                                        minified[name])
+
+    for name in names:
+        source_size = os.path.getsize(os.path.join(source_dir, name))
+        data = minified[name].encode("utf-8")
+        target = os.path.join(output_dir, name + ".gz")
+        write_gzip(target, data)
+        print("web: %-12s %6d -> %6d -> %5d bytes" %
+              (name, source_size, len(data), os.path.getsize(target)))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    build_web(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        build_web(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
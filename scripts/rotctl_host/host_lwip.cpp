@@ -0,0 +1,296 @@
+// ============================================================================
+// host_lwip.cpp - lwIP raw TCP API over POSIX sockets (rotctl host harness)
+// ============================================================================
+
+#include <lwip/tcp.h>
+#include <Arduino.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// Callbacks run from hostLwipService() on the caller's thread, as they
+// would from the tcpip thread. Each connection has a small receive window
+// that only tcp_recved() reopens, so an application that holds pbufs
+// stops reading from the socket and the kernel pushes back on the client.
+
+#define HOST_RECV_WINDOW 512
+#define HOST_SEND_BUFFER 2048
+#define HOST_POLL_UNIT_MS 500      // lwIP coarse timer period
+
+struct tcp_pcb {
+  int fd;
+  bool listening;
+  bool dead;                // Closed or aborted, freed after the service pass
+  bool finDelivered;
+  void* arg;
+  tcp_accept_fn acceptFn;
+  tcp_recv_fn recvFn;
+  tcp_err_fn errFn;
+  tcp_poll_fn pollFn;
+  u8_t pollInterval;
+  unsigned long lastPoll;
+  uint32_t window;          // Bytes that may be delivered before tcp_recved()
+};
+
+const ip_addr_t ip_addr_any_type = {0};
+
+static std::vector<struct tcp_pcb*> pcbs;
+static uint16_t bindPort = 0;
+
+// ============================================================================
+// PBUFS
+// ============================================================================
+
+static struct pbuf* pbufAlloc(const void* data, u16_t len) {
+  struct pbuf* p = (struct pbuf*)malloc(sizeof(struct pbuf) + len);
+  p->next = nullptr;
+  p->payload = p + 1;
+  p->tot_len = len;
+  p->len = len;
+  memcpy(p->payload, data, len);
+  return p;
+}
+
+void pbuf_cat(struct pbuf* head, struct pbuf* tail) {
+  struct pbuf* p = head;
+  for (; p->next; p = p->next) {
+    p->tot_len += tail->tot_len;
+  }
+  p->tot_len += tail->tot_len;
+  p->next = tail;
+}
+
+u8_t pbuf_free(struct pbuf* p) {
+  u8_t count = 0;
+  while (p) {
+    struct pbuf* next = p->next;
+    free(p);
+    p = next;
+    count++;
+  }
+  return count;
+}
+
+struct pbuf* pbuf_free_header(struct pbuf* q, u16_t size) {
+  while (q && size) {
+    if (size >= q->len) {
+      struct pbuf* next = q->next;
+      size -= q->len;
+      free(q);
+      q = next;
+    } else {
+      q->payload = (uint8_t*)q->payload + size;
+      q->len -= size;
+      q->tot_len -= size;
+      size = 0;
+    }
+  }
+  return q;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf* p, void* dataptr, u16_t len, u16_t offset) {
+  u16_t copied = 0;
+  for (; p && copied < len; p = p->next) {
+    if (offset >= p->len) {
+      offset -= p->len;
+      continue;
+    }
+    u16_t n = min((u16_t)(p->len - offset), (u16_t)(len - copied));
+    memcpy((uint8_t*)dataptr + copied, (const uint8_t*)p->payload + offset, n);
+    copied += n;
+    offset = 0;
+  }
+  return copied;
+}
+
+// ============================================================================
+// PCBS
+// ============================================================================
+
+static struct tcp_pcb* newPcb(int fd) {
+  struct tcp_pcb* pcb = new tcp_pcb();
+  pcb->fd = fd;
+  pcb->window = HOST_RECV_WINDOW;
+  pcb->lastPoll = millis();
+  pcbs.push_back(pcb);
+  return pcb;
+}
+
+// Stop using the pcb now; memory is released after the service pass so
+// callers up the stack never see a dangling pointer
+static void killPcb(struct tcp_pcb* pcb, bool reset) {
+  if (pcb->dead) {
+    return;
+  }
+  if (pcb->fd >= 0) {
+    if (reset) {
+      struct linger lin = {1, 0};
+      setsockopt(pcb->fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+    }
+    close(pcb->fd);
+    pcb->fd = -1;
+  }
+  pcb->dead = true;
+}
+
+struct tcp_pcb* tcp_new_ip_type(u8_t type) {
+  return newPcb(-1);
+}
+
+err_t tcp_bind(struct tcp_pcb* pcb, const ip_addr_t* ipaddr, u16_t port) {
+  bindPort = port;
+  return ERR_OK;
+}
+
+struct tcp_pcb* tcp_listen_with_backlog(struct tcp_pcb* pcb, u8_t backlog) {
+  int fd = socket(AF_INET6, SOCK_STREAM, 0);
+  int off = 0;
+  int on = 1;
+  setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  struct sockaddr_in6 addr = {};
+  addr.sin6_family = AF_INET6;
+  addr.sin6_addr = in6addr_any;
+  addr.sin6_port = htons(bindPort);
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, backlog) != 0) {
+    perror("listen");
+    close(fd);
+    return nullptr;
+  }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+
+  pcb->fd = fd;
+  pcb->listening = true;
+  return pcb;
+}
+
+void tcp_accept(struct tcp_pcb* pcb, tcp_accept_fn accept) { pcb->acceptFn = accept; }
+void tcp_arg(struct tcp_pcb* pcb, void* arg) { pcb->arg = arg; }
+void tcp_recv(struct tcp_pcb* pcb, tcp_recv_fn recv) { pcb->recvFn = recv; }
+void tcp_err(struct tcp_pcb* pcb, tcp_err_fn err) { pcb->errFn = err; }
+
+void tcp_poll(struct tcp_pcb* pcb, tcp_poll_fn poll, u8_t interval) {
+  pcb->pollFn = poll;
+  pcb->pollInterval = interval;
+}
+
+void tcp_recved(struct tcp_pcb* pcb, u16_t len) {
+  pcb->window += len;
+  if (pcb->window > HOST_RECV_WINDOW) {
+    fprintf(stderr, "lwip: tcp_recved() opened the window past its size\n");
+    abort();
+  }
+}
+
+void tcp_nagle_disable(struct tcp_pcb* pcb) {
+  int on = 1;
+  setsockopt(pcb->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+err_t tcp_write(struct tcp_pcb* pcb, const void* data, u16_t len, u8_t flags) {
+  if (pcb->dead) {
+    return ERR_CLSD;
+  }
+  if (send(pcb->fd, data, len, MSG_NOSIGNAL) != len) {
+    return ERR_MEM;
+  }
+  return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb* pcb) {
+  return ERR_OK;
+}
+
+u16_t tcp_sndbuf(struct tcp_pcb* pcb) {
+  return HOST_SEND_BUFFER;
+}
+
+err_t tcp_close(struct tcp_pcb* pcb) {
+  killPcb(pcb, false);
+  return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb* pcb) {
+  tcp_err_fn errFn = pcb->errFn;
+  void* arg = pcb->arg;
+  killPcb(pcb, true);
+  if (errFn) {
+    errFn(arg, ERR_ABRT);
+  }
+}
+
+// ============================================================================
+// SERVICE LOOP
+// ============================================================================
+
+static void serviceListener(struct tcp_pcb* listener) {
+  for (;;) {
+    int fd = accept(listener->fd, nullptr, nullptr);
+    if (fd < 0) {
+      return;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    struct tcp_pcb* pcb = newPcb(fd);
+    listener->acceptFn(listener->arg, pcb, ERR_OK);
+  }
+}
+
+static void serviceConnection(struct tcp_pcb* pcb) {
+  if (pcb->recvFn && !pcb->finDelivered && pcb->window > 0) {
+    uint8_t buf[HOST_RECV_WINDOW];
+    ssize_t n = recv(pcb->fd, buf, pcb->window, 0);
+    if (n > 0) {
+      pcb->window -= n;
+      pcb->recvFn(pcb->arg, pcb, pbufAlloc(buf, (u16_t)n), ERR_OK);
+    } else if (n == 0) {
+      pcb->finDelivered = true;
+      pcb->recvFn(pcb->arg, pcb, nullptr, ERR_OK);
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      // Reset by the peer: lwIP frees the pcb and reports it
+      tcp_err_fn errFn = pcb->errFn;
+      void* arg = pcb->arg;
+      killPcb(pcb, false);
+      if (errFn) {
+        errFn(arg, ERR_RST);
+      }
+      return;
+    }
+  }
+
+  unsigned long now = millis();
+  if (pcb->pollFn && !pcb->dead &&
+      now - pcb->lastPoll >= (unsigned long)pcb->pollInterval * HOST_POLL_UNIT_MS) {
+    pcb->lastPoll = now;
+    pcb->pollFn(pcb->arg, pcb);
+  }
+}
+
+void hostLwipService() {
+  // Index loop: accept adds pcbs while we iterate
+  for (size_t i = 0; i < pcbs.size(); i++) {
+    struct tcp_pcb* pcb = pcbs[i];
+    if (pcb->dead) {
+      continue;
+    }
+    if (pcb->listening) {
+      serviceListener(pcb);
+    } else if (pcb->fd >= 0) {
+      serviceConnection(pcb);
+    }
+  }
+
+  for (size_t i = 0; i < pcbs.size();) {
+    if (pcbs[i]->dead) {
+      delete pcbs[i];
+      pcbs[i] = pcbs.back();
+      pcbs.pop_back();
+    } else {
+      i++;
+    }
+  }
+}
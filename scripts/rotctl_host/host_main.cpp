@@ -0,0 +1,82 @@
+// ============================================================================
+// host_main.cpp - Runs rotctl_server.cpp on a Linux host
+// ============================================================================
+
+#include <Arduino.h>
+#include <lwip/tcp.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include "rotctl_server.h"
+#include "shared_data.h"
+#include "motor_control.h"
+#include "heap_stats.h"
+
+// The antenna follows the target instantly, so "P" followed by "p" reads
+// back the commanded position. Set ROTCTL_HOST_ESTOP=1 in the environment
+// to start with the emergency stop held.
+
+TargetPosition targetPos = {0.0f, 0.0f, false};
+TrackerState trackerState = {};
+HostSerial Serial;
+
+static bool emergencyStop = false;
+static uint32_t stopCount = 0;
+
+unsigned long millis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000UL;
+}
+
+unsigned long micros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000UL;
+}
+
+int HostSerial::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vprintf(format, args);
+  va_end(args);
+  fflush(stdout);
+  return n;
+}
+
+void getPoseSnapshot(PoseSnapshot* snapshot) {
+  memset(snapshot, 0, sizeof(*snapshot));
+  snapshot->antenna.azimuth = targetPos.azimuth;
+  snapshot->antenna.elevation = targetPos.elevation;
+}
+
+bool isEmergencyStop() {
+  return emergencyStop;
+}
+
+void stopAllMotors() {
+  stopCount++;
+}
+
+// The harness does not wrap malloc; rotctl_server only compares readings
+uint32_t getHeapAllocCount() {
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  uint16_t port = argc > 1 ? (uint16_t)atoi(argv[1]) : ROTCTL_PORT;
+  const char* estop = getenv("ROTCTL_HOST_ESTOP");
+  emergencyStop = estop && estop[0] == '1';
+
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  if (!startRotctlServer(port)) {
+    return 1;
+  }
+
+  // Main loop: lwIP callbacks, then the server's poll, as on the device
+  for (;;) {
+    hostLwipService();
+    pollRotctlServer();
+    usleep(1000);
+  }
+}
@@ -0,0 +1,33 @@
+/*
+ * Arduino.h - Host stand-in for the Arduino core used by the rotctl harness
+ */
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#define F(text) (text)
+
+using std::min;
+using std::max;
+
+unsigned long millis();
+unsigned long micros();
+
+// Serial output goes to stdout
+class HostSerial {
+public:
+  int printf(const char* format, ...);
+  void print(const char* text) { fputs(text, stdout); }
+  void println(const char* text = "") { puts(text); }
+};
+
+extern HostSerial Serial;
+
+#endif // ARDUINO_H
@@ -0,0 +1,15 @@
+/*
+ * LWIPMutex.h - Host stand-in: the harness runs lwIP callbacks and the
+ * poll loop on one thread, so the lock is a no-op
+ */
+
+#ifndef LWIPMUTEX_H
+#define LWIPMUTEX_H
+
+class LWIPMutex {
+public:
+  LWIPMutex() {}
+  ~LWIPMutex() {}
+};
+
+#endif // LWIPMUTEX_H
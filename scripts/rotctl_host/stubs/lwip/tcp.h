@@ -0,0 +1,67 @@
+/*
+ * lwip/tcp.h - The subset of the lwIP raw TCP API used by rotctl_server,
+ * implemented over POSIX sockets in host_lwip.cpp
+ */
+
+#ifndef LWIP_TCP_H
+#define LWIP_TCP_H
+
+#include <stdint.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef int8_t err_t;
+
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_VAL -6
+#define ERR_ABRT -13
+#define ERR_RST -14
+#define ERR_CLSD -15
+
+#define IPADDR_TYPE_ANY 46
+#define TCP_WRITE_FLAG_COPY 0x01
+
+typedef struct ip_addr { uint32_t addr; } ip_addr_t;
+extern const ip_addr_t ip_addr_any_type;
+#define IP_ANY_TYPE (&ip_addr_any_type)
+
+struct pbuf {
+  struct pbuf* next;
+  void* payload;
+  u16_t tot_len;            // This pbuf and the rest of the chain
+  u16_t len;                // This pbuf only
+};
+
+struct tcp_pcb;
+
+typedef err_t (*tcp_accept_fn)(void* arg, struct tcp_pcb* newpcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err);
+typedef err_t (*tcp_poll_fn)(void* arg, struct tcp_pcb* pcb);
+typedef void (*tcp_err_fn)(void* arg, err_t err);
+
+struct tcp_pcb* tcp_new_ip_type(u8_t type);
+err_t tcp_bind(struct tcp_pcb* pcb, const ip_addr_t* ipaddr, u16_t port);
+struct tcp_pcb* tcp_listen_with_backlog(struct tcp_pcb* pcb, u8_t backlog);
+void tcp_accept(struct tcp_pcb* pcb, tcp_accept_fn accept);
+void tcp_arg(struct tcp_pcb* pcb, void* arg);
+void tcp_recv(struct tcp_pcb* pcb, tcp_recv_fn recv);
+void tcp_err(struct tcp_pcb* pcb, tcp_err_fn err);
+void tcp_poll(struct tcp_pcb* pcb, tcp_poll_fn poll, u8_t interval);
+void tcp_recved(struct tcp_pcb* pcb, u16_t len);
+void tcp_nagle_disable(struct tcp_pcb* pcb);
+err_t tcp_write(struct tcp_pcb* pcb, const void* data, u16_t len, u8_t flags);
+err_t tcp_output(struct tcp_pcb* pcb);
+u16_t tcp_sndbuf(struct tcp_pcb* pcb);
+err_t tcp_close(struct tcp_pcb* pcb);
+void tcp_abort(struct tcp_pcb* pcb);
+
+void pbuf_cat(struct pbuf* head, struct pbuf* tail);
+u8_t pbuf_free(struct pbuf* p);
+struct pbuf* pbuf_free_header(struct pbuf* q, u16_t size);
+u16_t pbuf_copy_partial(const struct pbuf* p, void* dataptr, u16_t len, u16_t offset);
+
+// Harness only: accept, read and run poll timers (lwIP's tcpip thread)
+void hostLwipService();
+
+#endif // LWIP_TCP_H
@@ -0,0 +1,11 @@
+/*
+ * motor_control.h - Host stand-in for the motor calls rotctl_server uses
+ */
+
+#ifndef MOTOR_CONTROL_H
+#define MOTOR_CONTROL_H
+
+bool isEmergencyStop();
+void stopAllMotors();
+
+#endif // MOTOR_CONTROL_H
@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+#
+# test_rotctl.sh - Drive the rotctl server with Hamlib's rotctl (model 2)
+#
+# Runs against the host build (make test) or, with ROTCTL_HOST set, a
+# tracker on the network. The device test moves the antenna; clear the
+# area first.
+#
+#   ./test_rotctl.sh                      host build on a free local port
+#   ROTCTL_HOST=tracker.local ./test_rotctl.sh
+
+set -u
+
+HOST=${ROTCTL_HOST:-}
+PORT=${ROTCTL_PORT:-45330}
+SERVER_PID=
+
+failures=0
+
+cleanup() {
+  [ -n "$SERVER_PID" ] && kill "$SERVER_PID" 2>/dev/null
+}
+trap cleanup EXIT
+
+start_server() {
+  cleanup
+  ./rotctl_host "$PORT" >/dev/null &
+  SERVER_PID=$!
+  for _ in $(seq 50); do
+    (exec 3<>"/dev/tcp/127.0.0.1/$PORT") 2>/dev/null && return 0
+    sleep 0.1
+  done
+  echo "server did not start"
+  exit 1
+}
+
+rot() {
+  timeout 10 rotctl -m 2 -r "${HOST:-localhost}:$PORT" "$@" 2>&1
+}
+
+pass() { echo "ok   $1"; }
+fail() { echo "FAIL $1: $2"; failures=$((failures + 1)); }
+
+# Numbers in rotctl's output, labelled or not
+numbers() {
+  grep -oE -- '-?[0-9]+(\.[0-9]+)?' | tr '\n' ' '
+}
+
+expect_pos() {
+  local name=$1 az=$2 el=$3 out
+  out=$(rot p)
+  read -r gotAz gotEl <<<"$(echo "$out" | numbers)"
+  if awk -v a="${gotAz:-x}" -v e="${gotEl:-x}" -v wa="$az" -v we="$el" \
+      'BEGIN { exit !((a - wa) ^ 2 < 0.01 && (e - we) ^ 2 < 0.01) }'; then
+    pass "$name"
+  else
+    fail "$name" "expected $az $el, got: $out"
+  fi
+}
+
+expect_ok() {
+  local name=$1 out
+  shift
+  if out=$(rot "$@"); then
+    pass "$name"
+  else
+    fail "$name" "$out"
+  fi
+}
+
+command -v rotctl >/dev/null || { echo "rotctl not found (install Hamlib)"; exit 1; }
+[ -z "$HOST" ] && start_server
+
+expect_ok "P 180 45" P 180 45
+expect_pos "p after P" 180 45
+
+expect_ok "P -90 10 (signed azimuth)" P -90 10
+[ -z "$HOST" ] && expect_pos "p after signed P" 270 10
+
+expect_ok "S" S
+[ -z "$HOST" ] && expect_pos "p after S holds position" 270 10
+
+expect_ok "K" K
+[ -z "$HOST" ] && expect_pos "p after K" 0 0
+
+# rotctl reads \dump_state when it opens the rotator; print what it got
+out=$(rot '\dump_state')
+if [ $? -eq 0 ] && echo "$out" | numbers | grep -qE '(^| )360(\.0+)? ' &&
+   echo "$out" | numbers | grep -qE '(^| )90(\.0+)? '; then
+  pass "\\dump_state"
+else
+  fail "\\dump_state" "$out"
+fi
+
+if [ -z "$HOST" ]; then
+  # Out-of-range elevation is refused
+  if out=$(rot P 10 120) && ! echo "$out" | grep -qiE 'error|invalid|RPRT -'; then
+    fail "P 10 120 rejected" "$out"
+  else
+    pass "P 10 120 rejected"
+  fi
+
+  # A burst bigger than the line buffer is answered in full, not dropped
+  exec 3<>"/dev/tcp/127.0.0.1/$PORT"
+  for _ in $(seq 200); do printf 'p\n'; done >&3
+  lines=0
+  while [ $lines -lt 400 ] && read -r -t 5 _ <&3; do
+    lines=$((lines + 1))
+  done
+  exec 3<&-
+  if [ $lines -eq 400 ]; then
+    pass "200 pipelined p"
+  else
+    fail "200 pipelined p" "$lines of 400 reply lines"
+  fi
+
+  # With the e-stop held, moves are refused
+  ROTCTL_HOST_ESTOP=1 start_server
+  if out=$(rot P 90 30) && ! echo "$out" | grep -qiE 'error|rejected|RPRT -'; then
+    fail "P refused during e-stop" "$out"
+  else
+    pass "P refused during e-stop"
+  fi
+fi
+
+[ $failures -eq 0 ] && echo "all passed" || echo "$failures failed"
+exit $((failures > 0))
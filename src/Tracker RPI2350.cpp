@@ -16,6 +16,8 @@
 #include "button_module.h"
 #include "led_module.h"
 #include "storage_module.h"
+#include "pass_cache.h"
+#include "metrics.h"
 
 
 // Pulse LED blink patterns
@@ -59,6 +61,7 @@ void updatePulse() {
 
 void setup() {
   Serial.begin(115200);
+  initStackWatermark();
   delay(2000);
   
   // Print banner
@@ -157,14 +160,15 @@ void loop() {
   static unsigned long lastCompassUpdate = 0;
   static unsigned long lastJoystickUpdate = 0;
   static unsigned long lastLEDUpdate = 0;
+  static uint32_t lastControlMicros = 0;
   
   unsigned long now = millis();
   
   // Update LED indicator
   updatePulse();
   
-  // Update LED ring (20 Hz)
-  if (now - lastLEDUpdate >= 150) {
+  // Update LED ring (50 Hz)
+  if (now - lastLEDUpdate >= LED_UPDATE_MS) {
     updateLEDs();
     lastLEDUpdate = now;
   }
@@ -175,38 +179,24 @@ void loop() {
   // Handle web requests
   handleWebClient();
   
+  // Keep the pass cache watch list in step with catalog and TLE changes
+  pollPassCache();
+  
   // Handle touch input
   handleDisplayTouch();
   
-  // Poll hardware buttons (NEW)
-  //pollButtons();
+  // Poll hardware buttons (drains the ISR edge queue; no work when idle)
+  pollButtons();
+  
+  // Write-behind configuration flush (no work unless a save is pending)
+  updateStorage();
   
-  // Update joystick (NEW - 50 Hz)
+  // Update joystick state and calibration (5 Hz). Jogging itself runs in
+  // the control block below at the control rate.
   if (now - lastJoystickUpdate >= 200) {
     updateJoystick();
     
-    // If joystick manual mode is active, override target position
     if (isJoystickManualMode()) {
-      float azSpeed = getJoystickAzimuthSpeed();
-      float elSpeed = getJoystickElevationSpeed();
-      
-      // Update target position based on joystick
-      // Speed is normalized -1 to +1, scale to degrees per update
-      const float MANUAL_SPEED = 1.0; // degrees per 20ms at full deflection
-      
-      if (abs(azSpeed) > 0.01) {
-        targetPos.azimuth += azSpeed * MANUAL_SPEED;
-        while (targetPos.azimuth < 0) targetPos.azimuth += 360.0;
-        while (targetPos.azimuth >= 360) targetPos.azimuth -= 360.0;
-        trackerState.tracking = false; // Disable tracking when manually controlled
-      }
-      
-      if (abs(elSpeed) > 0.01) {
-        targetPos.elevation += elSpeed * MANUAL_SPEED;
-        targetPos.elevation = constrain(targetPos.elevation, MIN_ELEVATION, MAX_ELEVATION);
-        trackerState.tracking = false;
-      }
-      
       // Update LED mode for manual control
       setLEDMode(LED_MODE_STEADY_PURPLE);
     } else if (!trackerState.tracking) {
@@ -227,25 +217,40 @@ void loop() {
     
     // Update LED mode based on GPS status
     if (trackerState.gpsValid && !isJoystickManualMode()) {
-      if (trackerState.tracking) {
-        setLEDMode(LED_MODE_STEADY_GREEN);
-      } else {
-        setLEDMode(LED_MODE_STEADY_GREEN);
-      }
+      setLEDMode(LED_MODE_STEADY_GREEN);
     } else if (!isJoystickManualMode()) {
       setLEDMode(LED_MODE_FLASH_YELLOW);
     }
     
+    // Pointing markers drawn over the status colour while tracking
+    setLEDLayerMode(LED_LAYER_POINTER, trackerState.tracking ? LED_MODE_POINTING : LED_MODE_OFF);
+    
     lastGPSUpdate = now;
   }
   
   // Motor control loop (100 Hz)
   if (now - lastControlUpdate >= TRACKING_UPDATE_MS) {
+    // Jitter: deviation of the actual period from the nominal one
+    uint32_t nowMicros = micros();
+    float controlDt = CONTROL_LOOP_DT;
+    if (lastControlMicros != 0) {
+      int32_t jitter = (int32_t)(nowMicros - lastControlMicros) - TRACKING_UPDATE_MS * 1000;
+      metricObserve(HISTOGRAM_CONTROL_JITTER, jitter < 0 ? -jitter : jitter);
+      controlDt = (nowMicros - lastControlMicros) * 1e-6f;
+    }
+    lastControlMicros = nowMicros;
+    
+    // Joystick jog moves the target even while the position loop is off
+    updateManualJog(controlDt);
     //updateMotorControl();
     
-    // Update LED for emergency stop
+    // Alert layer overrides status and pointing while active
     if (isEmergencyStop()) {
-      setLEDMode(LED_MODE_FLASH_RED);
+      setLEDLayerMode(LED_LAYER_ALERT, LED_MODE_FLASH_RED);
+    } else if (isBackgroundCalibrationActive()) {
+      setLEDLayerMode(LED_LAYER_ALERT, LED_MODE_FLASH_BLUE);
+    } else {
+      setLEDLayerMode(LED_LAYER_ALERT, LED_MODE_OFF);
     }
     
     lastControlUpdate = now;
@@ -261,11 +266,6 @@ void loop() {
   if (now - lastCompassUpdate >= 50) {
     //updateBackgroundCalibration();
     
-    // Update LED during compass calibration
-    if (isBackgroundCalibrationActive()) {
-      setLEDMode(LED_MODE_FLASH_BLUE);
-    }
-    
     lastCompassUpdate = now;
   }
   
@@ -277,14 +277,19 @@ void loop() {
 // ============================================================================
 
 void setup1() {
+  initStackWatermark();
   Serial.println(F("Core 1: Satellite calculation engine started"));
   //initTracking();
+  initPassCache();
 }
 
 void loop1() {
   // Process TLE updates and calculate satellite positions
   //updateTracking();
   
+  // Background pass prediction (time-sliced)
+  updatePassCache();
+  
   // Run at lower rate than motor control (10 Hz)
   delay(100);
 }
\ No newline at end of file
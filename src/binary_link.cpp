@@ -0,0 +1,357 @@
+// ============================================================================
+// binary_link.cpp - Binary framed telemetry and command protocol
+// ============================================================================
+
+#include "binary_link.h"
+#include "shared_data.h"
+#include "motor_control.h"
+#include "serial_interface.h"
+#include "crc32.h"
+
+// Producers (telemetry and encoder timers, acks) all run on Core 0 in
+// pollBinaryLink() and only ever append whole encoded frames to the TX
+// ring, which the same poll drains. A frame that does not fit is dropped
+// and counted, so the main loop never waits on USB.
+//
+// USB CDC has no DMA channel to feed: TinyUSB copies into the endpoint
+// buffer itself. The ring plays that role here, and the drain writes only
+// what Serial.availableForWrite() says will not block.
+
+#define BINLINK_TX_MASK (BINLINK_TX_RING_SIZE - 1)
+
+static_assert((BINLINK_TX_RING_SIZE & BINLINK_TX_MASK) == 0, "BINLINK_TX_RING_SIZE must be a power of two");
+
+static bool linkActive = false;
+static bool exitPending = false;        // EXIT acked, leave once it is sent
+static uint16_t encoderHz = 0;           // 0 = encoder stream off
+static uint16_t telemetryHz = BINLINK_TELEMETRY_DEFAULT_HZ;
+static uint32_t lastTelemetryUs = 0;
+static uint32_t lastEncoderUs = 0;
+static uint16_t txSeq = 0;
+
+// TX ring of encoded frames
+static uint8_t txRing[BINLINK_TX_RING_SIZE];
+static volatile uint32_t txHead = 0;    // Producer
+static volatile uint32_t txTail = 0;    // Consumer
+
+// RX frame being collected (still COBS encoded)
+static uint8_t rxFrame[BINLINK_MAX_FRAME];
+static uint8_t rxLen = 0;
+static bool rxOverflow = false;
+
+// Counters
+static uint32_t framesSent = 0;
+static uint32_t framesDropped = 0;
+static uint32_t bytesSent = 0;
+static uint32_t framesReceived = 0;
+static uint32_t badFrames = 0;          // CRC, COBS or version errors
+static uint32_t maxRingUsed = 0;
+
+// ============================================================================
+// FRAMING
+// ============================================================================
+
+// COBS encode 'len' bytes and append the 0x00 delimiter; returns the
+// encoded length (at most len + len / 254 + 2)
+static size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+  size_t codePos = 0;
+  size_t o = 1;
+  uint8_t code = 1;
+
+  for (size_t i = 0; i < len; i++) {
+    if (in[i] == 0) {
+      out[codePos] = code;
+      codePos = o++;
+      code = 1;
+    } else {
+      out[o++] = in[i];
+      if (++code == 0xFF) {
+        out[codePos] = code;
+        codePos = o++;
+        code = 1;
+      }
+    }
+  }
+  out[codePos] = code;
+  out[o++] = 0x00;
+  return o;
+}
+
+// COBS decode a frame without its delimiter (in place is fine: output
+// never overtakes input). Returns the decoded length, 0 if malformed.
+static size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out) {
+  size_t i = 0;
+  size_t o = 0;
+
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len) {
+      return 0;
+    }
+    for (uint8_t k = 1; k < code; k++) {
+      out[o++] = in[i++];
+    }
+    if (code != 0xFF && i < len) {
+      out[o++] = 0;
+    }
+  }
+  return o;
+}
+
+// Encode one message and append it to the TX ring (all or nothing)
+static bool queueFrame(BinLinkMessage type, const void* payload, size_t len) {
+  uint8_t raw[4 + BINLINK_MAX_PAYLOAD + 2];
+  uint8_t frame[BINLINK_MAX_FRAME];
+
+  raw[0] = BINLINK_VERSION;
+  raw[1] = type;
+  raw[2] = txSeq & 0xFF;
+  raw[3] = txSeq >> 8;
+  memcpy(raw + 4, payload, len);
+  uint16_t crc = calculateCrc16(raw, 4 + len);
+  raw[4 + len] = crc & 0xFF;
+  raw[5 + len] = crc >> 8;
+  // Leading delimiter too: console text printed between frames then
+  // only spoils itself, not the frame after it
+  frame[0] = 0x00;
+  size_t n = 1 + cobsEncode(raw, 6 + len, frame + 1);
+
+  uint32_t head = txHead;
+  uint32_t used = head - txTail;
+  if (used + n > BINLINK_TX_RING_SIZE) {
+    framesDropped++;
+    return false;
+  }
+
+  size_t first = min(n, (size_t)(BINLINK_TX_RING_SIZE - (head & BINLINK_TX_MASK)));
+  memcpy(txRing + (head & BINLINK_TX_MASK), frame, first);
+  memcpy(txRing, frame + first, n - first);
+  __dmb();
+  txHead = head + n;
+
+  txSeq++;
+  framesSent++;
+  if (used + n > maxRingUsed) {
+    maxRingUsed = used + n;
+  }
+  return true;
+}
+
+// Hand the ring to the USB endpoint as far as it has room
+static void drainTx() {
+  uint32_t tail = txTail;
+  uint32_t pending = txHead - tail;
+  int room = Serial.availableForWrite();
+
+  while (pending > 0 && room > 0) {
+    size_t contiguous = BINLINK_TX_RING_SIZE - (tail & BINLINK_TX_MASK);
+    size_t n = min((size_t)min(pending, (uint32_t)room), contiguous);
+    Serial.write(txRing + (tail & BINLINK_TX_MASK), n);
+    tail += n;
+    pending -= n;
+    room -= n;
+    bytesSent += n;
+  }
+  txTail = tail;
+}
+
+// ============================================================================
+// MESSAGES
+// ============================================================================
+
+static void queueTelemetry() {
+  PoseSnapshot pose;
+  getPoseSnapshot(&pose);
+
+  BinTelemetry msg;
+  msg.timeMs = millis();
+  msg.azimuth = pose.antenna.azimuth;
+  msg.elevation = pose.antenna.elevation;
+  msg.targetAz = targetPos.azimuth;
+  msg.targetEl = targetPos.elevation;
+  msg.satAz = pose.satellite.azimuth;
+  msg.satEl = pose.satellite.elevation;
+  msg.flags = (trackerState.tracking ? BINLINK_FLAG_TRACKING : 0) |
+              (trackerState.gpsValid ? BINLINK_FLAG_GPS_VALID : 0) |
+              (isEmergencyStop() ? BINLINK_FLAG_ESTOP : 0) |
+              (pose.satellite.valid ? BINLINK_FLAG_SAT_VALID : 0);
+  msg.reserved = 0;
+  msg.dropped = framesDropped;
+  queueFrame(BINLINK_MSG_TELEMETRY, &msg, sizeof(msg));
+}
+
+// Sampled here rather than in the control loop so the stream does not
+// depend on the position loop running, and its rate is set by the host
+static void queueEncoder() {
+  int32_t countEl, countAz;
+  float errorAz, errorEl;
+  readEncoderSample(&countEl, &countAz, &errorAz, &errorEl);
+
+  BinEncoder msg;
+  msg.timeUs = micros();
+  msg.countEl = countEl;
+  msg.countAz = countAz;
+  msg.errorAz = errorAz;
+  msg.errorEl = errorEl;
+  queueFrame(BINLINK_MSG_ENCODER, &msg, sizeof(msg));
+}
+
+static uint8_t executeCommand(const BinCommand* cmd) {
+  switch (cmd->code) {
+    case BINLINK_CMD_PING:
+      return BINLINK_ACK_OK;
+
+    case BINLINK_CMD_GOTO: {
+      float az = cmd->arg[0];
+      float el = cmd->arg[1];
+      if (!(az >= 0.0f && az < 360.0f && el >= MIN_ELEVATION && el <= MAX_ELEVATION)) {
+        return BINLINK_ACK_BAD_ARGS;
+      }
+      if (isEmergencyStop()) {
+        return BINLINK_ACK_REFUSED;
+      }
+      setManualPosition(az, el);
+      return BINLINK_ACK_OK;
+    }
+
+    case BINLINK_CMD_STOP:
+      endTracking();
+      return BINLINK_ACK_OK;
+
+    case BINLINK_CMD_ESTOP:
+      beginEmergencyStop();
+      return BINLINK_ACK_OK;
+
+    case BINLINK_CMD_RESET_ESTOP:
+      beginResetEmergencyStop();
+      return BINLINK_ACK_OK;
+
+    case BINLINK_CMD_TELEMETRY_RATE:
+      if (!(cmd->arg[0] >= 0.0f && cmd->arg[0] <= BINLINK_TELEMETRY_MAX_HZ)) {
+        return BINLINK_ACK_BAD_ARGS;
+      }
+      telemetryHz = (uint16_t)cmd->arg[0];
+      return BINLINK_ACK_OK;
+
+    case BINLINK_CMD_ENCODER_STREAM:
+      if (!(cmd->arg[0] >= 0.0f && cmd->arg[0] <= BINLINK_ENCODER_MAX_HZ)) {
+        return BINLINK_ACK_BAD_ARGS;
+      }
+      encoderHz = (uint16_t)cmd->arg[0];
+      return BINLINK_ACK_OK;
+
+    case BINLINK_CMD_EXIT:
+      exitPending = true;
+      return BINLINK_ACK_OK;
+
+    default:
+      return BINLINK_ACK_UNKNOWN;
+  }
+}
+
+// Check and dispatch one received frame (COBS encoded, no delimiter)
+static void handleFrame(uint8_t* frame, size_t len) {
+  size_t n = cobsDecode(frame, len, frame);
+  if (n < 6 || frame[0] != BINLINK_VERSION) {
+    badFrames++;
+    return;
+  }
+  uint16_t crc = frame[n - 2] | (frame[n - 1] << 8);
+  if (calculateCrc16(frame, n - 2) != crc) {
+    badFrames++;
+    return;
+  }
+  framesReceived++;
+
+  if (frame[1] != BINLINK_MSG_COMMAND || n - 6 != sizeof(BinCommand)) {
+    return;  // Nothing else is addressed to the device
+  }
+
+  BinCommand cmd;
+  memcpy(&cmd, frame + 4, sizeof(cmd));
+  BinAck ack;
+  ack.seq = frame[2] | (frame[3] << 8);
+  ack.code = cmd.code;
+  ack.status = executeCommand(&cmd);
+  queueFrame(BINLINK_MSG_ACK, &ack, sizeof(ack));
+}
+
+static void receiveFrames() {
+  // Bounded per poll so a flood of input cannot stall the loop
+  for (int i = 0; i < 256 && Serial.available() > 0; i++) {
+    uint8_t c = Serial.read();
+    if (c == 0x00) {
+      if (rxOverflow) {
+        badFrames++;
+      } else if (rxLen > 0) {
+        handleFrame(rxFrame, rxLen);
+      }
+      rxLen = 0;
+      rxOverflow = false;
+    } else if (rxLen < sizeof(rxFrame)) {
+      rxFrame[rxLen++] = c;
+    } else {
+      rxOverflow = true;
+    }
+  }
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+void beginBinaryLink() {
+  txHead = 0;
+  txTail = 0;
+  rxLen = 0;
+  rxOverflow = false;
+  exitPending = false;
+  lastTelemetryUs = micros();
+  lastEncoderUs = lastTelemetryUs;
+  linkActive = true;
+}
+
+void endBinaryLink() {
+  linkActive = false;
+  encoderHz = 0;
+}
+
+bool isBinaryLinkActive() {
+  return linkActive;
+}
+
+void pollBinaryLink() {
+  if (!linkActive) {
+    return;
+  }
+
+  receiveFrames();
+
+  uint32_t now = micros();
+  if (telemetryHz > 0 && !exitPending && now - lastTelemetryUs >= 1000000UL / telemetryHz) {
+    queueTelemetry();
+    lastTelemetryUs = now;
+  }
+  if (encoderHz > 0 && !exitPending && now - lastEncoderUs >= 1000000UL / encoderHz) {
+    queueEncoder();
+    lastEncoderUs = now;
+  }
+
+  drainTx();
+
+  // Leave once the EXIT ack is on its way
+  if (exitPending && txHead == txTail) {
+    endBinaryLink();
+    Serial.print(F("\r\n> "));
+  }
+}
+
+void printBinaryLinkStatus() {
+  Serial.println(F("\n=== BINARY LINK ==="));
+  Serial.printf("Mode: %s, telemetry %u Hz, encoder stream %u Hz\n",
+                linkActive ? "active" : "off", telemetryHz, encoderHz);
+  Serial.printf("Frames sent: %lu (%lu bytes), dropped: %lu\n", framesSent, bytesSent, framesDropped);
+  Serial.printf("Frames received: %lu, bad: %lu\n", framesReceived, badFrames);
+  Serial.printf("TX ring: %lu of %u bytes at peak\n", maxRingUsed, BINLINK_TX_RING_SIZE);
+  Serial.println();
+}
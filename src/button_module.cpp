@@ -3,6 +3,7 @@
 // ============================================================================
 
 #include "button_module.h"
+#include "input_debounce.h"
 
 // Button pin assignments (using unused GPIOs)
 const uint8_t buttonPins[5] = {
@@ -20,108 +21,168 @@ struct ButtonState {
   unsigned long lastChange; // Time of last state change
   unsigned long pressTime;  // Time button was pressed
   bool longPressFired;      // Has long press event been fired?
+  bool rawLevel;            // Level after the most recent edge (pressed = true)
+  uint32_t rawTimeUs;       // Timestamp of the most recent edge
+  bool rawPending;          // rawLevel not yet accepted or rejected
 };
 
-static ButtonState buttonStates[5] = {{false, false, 0, 0, false}};
+static ButtonState buttonStates[5] = {{false, false, 0, 0, false, false, 0, false}};
 static ButtonCallback buttonCallback = nullptr;
 
-// Debounce time in milliseconds
-#define DEBOUNCE_TIME_MS 50
+// Minimum hold time before an edge is accepted. The pins are already
+// debounced by the PIO input filter, so this only guards against
+// glitches shorter than one poll.
+#define DEBOUNCE_TIME_MS 5
 #define LONG_PRESS_TIME_MS 1000
 
-// Raw button states from ISR (volatile for thread safety)
-volatile bool rawButtonStates[5] = {false, false, false, false, false};
-volatile unsigned long lastInterruptTime[5] = {0, 0, 0, 0, 0};
+// Edge event queue (power of 2). Written only by the debouncer IRQ, read only
+// by pollButtons(), so head and tail each have a single writer and no lock
+// is needed. 64 entries hold several seconds of worst-case contact bounce.
+#define BUTTON_QUEUE_SIZE 64
 
-// ISR enable flag - prevents interrupt storm during initialization
+struct ButtonEdge {
+  uint32_t timeUs;          // micros() when the edge was seen
+  uint8_t button;           // ButtonID
+  uint8_t level;            // 1 = pressed (pin low)
+};
+
+static ButtonEdge edgeQueue[BUTTON_QUEUE_SIZE];
+static volatile uint32_t edgeHead = 0;      // Next slot to write (ISR)
+static volatile uint32_t edgeTail = 0;      // Next slot to read (consumer)
+static volatile uint32_t edgeOverflows = 0; // Edges dropped on a full queue
+
+// Buttons that still need time-based processing (pending edge, or held
+// and waiting for long press). Zero together with an empty queue means
+// pollButtons() has nothing to do.
+static uint8_t activeMask = 0;
+
+// ISR enable flag - ignore edges until initialization is complete
 volatile bool isrEnabled = false;
 
 // ============================================================================
-// INTERRUPT HANDLERS (one per button)
+// INTERRUPT HANDLER
 // ============================================================================
 
-void __not_in_flash_func(button1_ISR)() {
-  if (!isrEnabled) return;
-  
-  unsigned long now = millis();
-  if (now - lastInterruptTime[1] > DEBOUNCE_TIME_MS) {
-    rawButtonStates[1] = !digitalRead(BUTTON_1_PIN); // Active low
-    lastInterruptTime[1] = now;
+// Record one edge. On overflow the edge is counted and dropped; the
+// consumer then resynchronises from the pin levels.
+static inline void __not_in_flash_func(pushButtonEdge)(uint8_t button, bool pressed, uint32_t timeUs) {
+  uint32_t head = edgeHead;
+  if (head - edgeTail >= BUTTON_QUEUE_SIZE) {
+    edgeOverflows++;
+    return;
   }
+  
+  ButtonEdge& edge = edgeQueue[head & (BUTTON_QUEUE_SIZE - 1)];
+  edge.timeUs = timeUs;
+  edge.button = button;
+  edge.level = pressed;
+  
+  __dmb();  // Entry visible before the new head
+  edgeHead = head + 1;
 }
 
-void __not_in_flash_func(button2_ISR)() {
+// Clean transitions from the PIO debouncer, timestamped when the pin settled
+static void __not_in_flash_func(buttonInputEdge)(uint8_t pin, bool level, uint32_t timeUs) {
   if (!isrEnabled) return;
   
-  unsigned long now = millis();
-  if (now - lastInterruptTime[2] > DEBOUNCE_TIME_MS) {
-    rawButtonStates[2] = !digitalRead(BUTTON_2_PIN);
-    lastInterruptTime[2] = now;
+  for (uint8_t i = 1; i <= 4; i++) {
+    if (buttonPins[i] == pin) {
+      pushButtonEdge(i, !level, timeUs);  // Active low
+      return;
+    }
   }
 }
 
-void __not_in_flash_func(button3_ISR)() {
-  if (!isrEnabled) return;
+// ============================================================================
+// BUTTON PROCESSING
+// ============================================================================
+
+// Convert an edge timestamp (micros) to the millis() time base
+static unsigned long edgeTimeMs(uint32_t timeUs) {
+  return millis() - (micros() - timeUs) / 1000;
+}
+
+// Accept a debounced level that became stable at 'timeMs'
+static void commitButtonState(ButtonID button, bool pressed, unsigned long timeMs) {
+  ButtonState* state = &buttonStates[button];
+  if (pressed == state->currentState) {
+    return;
+  }
+  
+  state->lastState = state->currentState;
+  state->currentState = pressed;
+  state->lastChange = timeMs;
   
-  unsigned long now = millis();
-  if (now - lastInterruptTime[3] > DEBOUNCE_TIME_MS) {
-    rawButtonStates[3] = !digitalRead(BUTTON_3_PIN);
-    lastInterruptTime[3] = now;
+  if (state->currentState) {
+    // Button pressed
+    state->pressTime = timeMs;
+    state->longPressFired = false;
+    
+    if (buttonCallback) {
+      buttonCallback(button, BUTTON_EVENT_PRESS);
+    }
+  } else {
+    // Button released
+    if (buttonCallback) {
+      buttonCallback(button, BUTTON_EVENT_RELEASE);
+    }
   }
 }
 
-void __not_in_flash_func(button4_ISR)() {
-  if (!isrEnabled) return;
+// Feed one raw edge into the debouncer. A level counts once it has been
+// held for DEBOUNCE_TIME_MS, judged from the edge timestamps, so a short
+// press between polls still produces both events.
+static void processButtonEdge(const ButtonEdge& edge) {
+  ButtonState* state = &buttonStates[edge.button];
   
-  unsigned long now = millis();
-  if (now - lastInterruptTime[4] > DEBOUNCE_TIME_MS) {
-    rawButtonStates[4] = !digitalRead(BUTTON_4_PIN);
-    lastInterruptTime[4] = now;
+  if (state->rawPending &&
+      edge.timeUs - state->rawTimeUs >= DEBOUNCE_TIME_MS * 1000UL) {
+    commitButtonState((ButtonID)edge.button, state->rawLevel, edgeTimeMs(state->rawTimeUs));
   }
+  
+  state->rawLevel = edge.level;
+  state->rawTimeUs = edge.timeUs;
+  state->rawPending = true;
+  activeMask |= (1 << edge.button);
 }
 
-// ============================================================================
-// BUTTON PROCESSING
-// ============================================================================
-
+// Time-based work for one button: settle a pending edge, fire long press
 void processButton(ButtonID button) {
   if (button == BUTTON_NONE || button > BUTTON_4) return;
   
   ButtonState* state = &buttonStates[button];
-  bool raw = rawButtonStates[button];
-  unsigned long now = millis();
-  
-  // Update current state from debounced raw state
-  if (raw != state->currentState) {
-    state->lastState = state->currentState;
-    state->currentState = raw;
-    state->lastChange = now;
-    
-    if (state->currentState) {
-      // Button pressed
-      state->pressTime = now;
-      state->longPressFired = false;
-      
-      if (buttonCallback) {
-        buttonCallback(button, BUTTON_EVENT_PRESS);
-      }
-    } else {
-      // Button released
-      if (buttonCallback) {
-        buttonCallback(button, BUTTON_EVENT_RELEASE);
-      }
-    }
+  uint32_t nowUs = micros();
+  
+  if (state->rawPending && nowUs - state->rawTimeUs >= DEBOUNCE_TIME_MS * 1000UL) {
+    state->rawPending = false;
+    commitButtonState(button, state->rawLevel, edgeTimeMs(state->rawTimeUs));
   }
   
   // Check for long press
   if (state->currentState && !state->longPressFired) {
-    if ((now - state->pressTime) >= LONG_PRESS_TIME_MS) {
+    if ((millis() - state->pressTime) >= LONG_PRESS_TIME_MS) {
       state->longPressFired = true;
       if (buttonCallback) {
         buttonCallback(button, BUTTON_EVENT_LONG_PRESS);
       }
     }
   }
+  
+  if (!state->rawPending && !(state->currentState && !state->longPressFired)) {
+    activeMask &= ~(1 << button);
+  }
+}
+
+// Queue overflowed: edges were lost, so take the pins as the truth
+static void resyncButtons() {
+  Serial.printf("WARNING: Button queue overflow (%lu edges dropped)\n", edgeOverflows);
+  edgeOverflows = 0;
+  
+  uint32_t nowUs = micros();
+  for (int i = 1; i <= 4; i++) {
+    ButtonEdge edge = {nowUs, (uint8_t)i, (uint8_t)!digitalRead(buttonPins[i])};
+    processButtonEdge(edge);
+  }
 }
 
 // ============================================================================
@@ -150,34 +211,33 @@ void initButtons() {
     
     // Read initial state (active low, so invert)
     bool initialState = !digitalRead(buttonPins[i]);
-    rawButtonStates[i] = initialState;
     buttonStates[i].currentState = initialState;
-    
-    lastInterruptTime[i] = millis();
+    buttonStates[i].rawLevel = initialState;
+    buttonStates[i].rawTimeUs = micros();
+    buttonStates[i].rawPending = false;
   }
   
-  Serial.println("Button pins configured, settling...");
-  delay(100);
+  edgeHead = 0;
+  edgeTail = 0;
+  edgeOverflows = 0;
+  activeMask = 0;
   
-  // Now attach interrupts with ISRs disabled initially
-  isrEnabled = false;
+  Serial.println("Button pins configured");
   
-  attachInterrupt(digitalPinToInterrupt(BUTTON_1_PIN), button1_ISR, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(BUTTON_2_PIN), button2_ISR, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(BUTTON_3_PIN), button3_ISR, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(BUTTON_4_PIN), button4_ISR, CHANGE);
+  // Hand the pins to the PIO debouncer with edges ignored until ready
+  isrEnabled = false;
   
-  Serial.println("Interrupts attached, enabling...");
-  delay(50);
+  for (int i = 1; i <= 4; i++) {
+    addDebouncedInput(buttonPins[i], buttonInputEdge);
+  }
   
-  // Enable ISRs after everything is stable
   isrEnabled = true;
   
   Serial.println("Hardware buttons initialized");
-  Serial.printf("Button 1: GPIO %d (state: %d)\n", BUTTON_1_PIN, rawButtonStates[1]);
-  Serial.printf("Button 2: GPIO %d (state: %d)\n", BUTTON_2_PIN, rawButtonStates[2]);
-  Serial.printf("Button 3: GPIO %d (state: %d)\n", BUTTON_3_PIN, rawButtonStates[3]);
-  Serial.printf("Button 4: GPIO %d (state: %d)\n", BUTTON_4_PIN, rawButtonStates[4]);
+  Serial.printf("Button 1: GPIO %d (state: %d)\n", BUTTON_1_PIN, buttonStates[1].currentState);
+  Serial.printf("Button 2: GPIO %d (state: %d)\n", BUTTON_2_PIN, buttonStates[2].currentState);
+  Serial.printf("Button 3: GPIO %d (state: %d)\n", BUTTON_3_PIN, buttonStates[3].currentState);
+  Serial.printf("Button 4: GPIO %d (state: %d)\n", BUTTON_4_PIN, buttonStates[4].currentState);
 }
 
 void setButtonCallback(ButtonCallback callback) {
@@ -185,19 +245,40 @@ void setButtonCallback(ButtonCallback callback) {
 }
 
 ButtonID pollButtons() {
-  // Process all buttons and return first one that changed
+  // Idle: no edges queued and nothing waiting on a timer
+  if (edgeHead == edgeTail && activeMask == 0 && edgeOverflows == 0) {
+    return BUTTON_NONE;
+  }
+  
+  bool prevStates[5];
+  for (int i = 1; i <= 4; i++) {
+    prevStates[i] = buttonStates[i].currentState;
+  }
+  
+  // Drain every queued edge in order
+  uint32_t head = edgeHead;
+  __dmb();  // Read entries only after seeing the head that covers them
+  while (edgeTail != head) {
+    processButtonEdge(edgeQueue[edgeTail & (BUTTON_QUEUE_SIZE - 1)]);
+    edgeTail = edgeTail + 1;
+  }
+  
+  if (edgeOverflows) {
+    resyncButtons();
+  }
+  
+  // Settle pending edges and check long presses
   for (int i = 1; i <= 4; i++) {
-    ButtonID button = (ButtonID)i;
-    bool prevState = buttonStates[i].currentState;
-    processButton(button);
-    if (buttonStates[i].currentState != prevState) {
-      return button;
+    if (activeMask & (1 << i)) {
+      processButton((ButtonID)i);
     }
   }
   
-  // Check for long presses even without state change
+  // Return first button that changed
   for (int i = 1; i <= 4; i++) {
-    processButton((ButtonID)i);
+    if (buttonStates[i].currentState != prevStates[i]) {
+      return (ButtonID)i;
+    }
   }
   
   return BUTTON_NONE;
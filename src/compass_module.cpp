@@ -347,28 +347,23 @@ void printCompassStatus() {
   Serial.println();
 }
 
-void printRawCompassData(int samples) {
+void printRawCompassHeader(int samples) {
   Serial.println(F("\n=== RAW COMPASS DATA ==="));
   Serial.printf("Collecting %d samples...\n", samples);
   Serial.println();
   Serial.println(F("Sample    X       Y       Z     Heading"));
   Serial.println(F("------  ------  ------  ------  -------"));
-  
+}
+
+void printRawCompassSample(int index) {
   QMC5883LCompass& compass = getCompass();
+  compass.read();
+  float heading = readCompassHeading();
   
-  for (int i = 0; i < samples; i++) {
-    compass.read();
-    float heading = readCompassHeading();
-    
-    Serial.printf("%4d    %6d  %6d  %6d  %7.2f\n",
-                  i + 1,
-                  compass.getX(),
-                  compass.getY(),
-                  compass.getZ(),
-                  heading);
-    
-    delay(100);
-  }
-  
-  Serial.println();
+  Serial.printf("%4d    %6d  %6d  %6d  %7.2f\n",
+                index + 1,
+                compass.getX(),
+                compass.getY(),
+                compass.getZ(),
+                heading);
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+// ============================================================================
+// crc32.cpp - CRC-32 via the DMA sniffer, CRC-16 by table
+// ============================================================================
+
+#include "crc32.h"
+#include "hardware/dma.h"
+
+// The sniffer watches one DMA channel and folds every byte it moves into
+// a CRC. Copying the buffer into a dummy byte (no write increment) runs
+// the whole checksum in hardware at one byte per system clock. There is
+// only one sniffer, so it is used from Core 0 only; Core 1 and buffers
+// too short to be worth the channel setup use the nibble table.
+
+#define CRC32_DMA_MIN_LEN 32
+
+static int crcDma = -1;
+static bool crcDmaClaimed = false;
+
+// ============================================================================
+// INTERNAL FUNCTIONS
+// ============================================================================
+
+// Reflected CRC-32 (poly 0xEDB88320), a nibble at a time
+static const uint32_t crc32NibbleTable[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t crc32Table(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ crc32NibbleTable[crc & 0x0F];
+    crc = (crc >> 4) ^ crc32NibbleTable[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021), a nibble at a time
+static const uint16_t crc16NibbleTable[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static uint32_t reverseBits(uint32_t x) {
+  x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+  x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+  x = ((x >> 4) & 0x0F0F0F0F) | ((x & 0x0F0F0F0F) << 4);
+  x = ((x >> 8) & 0x00FF00FF) | ((x & 0x00FF00FF) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+// CRC32R mode feeds each byte bit-reversed into an MSB-first register;
+// reading the result reversed and inverted gives the reflected CRC-32.
+// A running CRC resumes from its inverse, bit-reversed into that register.
+static uint32_t crc32Dma(uint32_t crc, const uint8_t* data, size_t len) {
+  static uint8_t sink;
+
+  dma_channel_config c = dma_channel_get_default_config(crcDma);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_sniff_enable(&c, true);
+
+  dma_sniffer_enable(crcDma, DMA_SNIFF_CTRL_CALC_VALUE_CRC32R, true);
+  dma_sniffer_set_output_reverse_enabled(true);
+  dma_sniffer_set_output_invert_enabled(true);
+  dma_sniffer_set_data_accumulator(reverseBits(~crc));
+
+  dma_channel_configure(crcDma, &c, &sink, data, len, true);
+  dma_channel_wait_for_finish_blocking(crcDma);
+
+  crc = dma_sniffer_get_data_accumulator();
+  dma_sniffer_disable();
+  return crc;
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+uint32_t calculateCrc32(const void* data, size_t len) {
+  return crc32Update(0, data, len);
+}
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  if (len < CRC32_DMA_MIN_LEN || rp2040.cpuid() != 0) {
+    return crc32Table(crc, bytes, len);
+  }
+
+  if (!crcDmaClaimed) {
+    crcDma = dma_claim_unused_channel(false);
+    crcDmaClaimed = true;
+  }
+  if (crcDma < 0) {
+    return crc32Table(crc, bytes, len);
+  }
+  return crc32Dma(crc, bytes, len);
+}
+
+uint16_t calculateCrc16(const void* data, size_t len) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc = (crc << 4) ^ crc16NibbleTable[(crc >> 12) ^ (bytes[i] >> 4)];
+    crc = (crc << 4) ^ crc16NibbleTable[(crc >> 12) ^ (bytes[i] & 0x0F)];
+  }
+  return crc;
+}
@@ -116,6 +116,30 @@ void updateGPS() {
 }
 
 
+uint32_t getGpsFixAgeMs() {
+  return millis() - lastValidGPS;
+}
+
+uint32_t getGpsUnixTime() {
+  if (!trackerState.gpsValid) {
+    return 0;
+  }
+  
+  // Days since 1970-01-01 (civil calendar, March-based year)
+  int32_t y = trackerState.gpsYear;
+  uint32_t m = trackerState.gpsMonth;
+  uint32_t d = trackerState.gpsDay;
+  if (m <= 2) y--;
+  uint32_t era = y / 400;
+  uint32_t yoe = y - era * 400;
+  uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  uint32_t days = era * 146097 + doe - 719468;
+  
+  uint32_t seconds = trackerState.gpsHour * 3600UL + trackerState.gpsMinute * 60UL + trackerState.gpsSecond;
+  return days * 86400UL + seconds + (millis() - lastValidGPS) / 1000;
+}
+
 void printTLE() {
   Serial.println(F("\n=== TLE DATA ==="));
   Serial.println();
@@ -216,7 +240,6 @@ SentenceStats stats;
 String inputBuffer = "";
 
 // Function prototypes
-void connectionTest();
 void readRawData(int durationSec);
 void analyzeSentences(int durationSec);
 void processSentence(String sentence);
@@ -232,19 +255,28 @@ int countFields(String data);
 
 #define DEBUG_SERIAL Serial
 
-void connectionTest() {
+// Counters at the start of the connection test
+static uint32_t testStartChars = 0;
+static uint32_t testStartSentences = 0;
+static unsigned long testStartMs = 0;
+
+void beginConnectionTest() {
   DEBUG_SERIAL.println("\n=== GPS Module Connection Test ===");
   DEBUG_SERIAL.println("Checking if GPS module is communicating...\n");
   
-  delay(1000);
+  testStartChars = gps.charsProcessed();
+  testStartSentences = gps.passedChecksum() + gps.failedChecksum();
+  testStartMs = millis();
+}
+
+void endConnectionTest() {
+  uint32_t chars = gps.charsProcessed() - testStartChars;
+  uint32_t sentences = gps.passedChecksum() + gps.failedChecksum() - testStartSentences;
   
-  if (GPS_SERIAL.available()) {
+  if (chars > 0) {
     DEBUG_SERIAL.println("✓ Data detected on UART!");
-    DEBUG_SERIAL.print("Sample: ");
-    for (int i = 0; i < 50 && GPS_SERIAL.available(); i++) {
-      DEBUG_SERIAL.write(GPS_SERIAL.read());
-    }
-    DEBUG_SERIAL.println("\n");
+    DEBUG_SERIAL.printf("%lu bytes, %lu sentences in %lu ms\n\n",
+                        (unsigned long)chars, (unsigned long)sentences, millis() - testStartMs);
   } else {
     DEBUG_SERIAL.println("✗ No data on UART");
     DEBUG_SERIAL.println("\nTroubleshooting:");
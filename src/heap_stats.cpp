@@ -0,0 +1,60 @@
+// ============================================================================
+// heap_stats.cpp - Heap allocation counters
+// ============================================================================
+
+#include "heap_stats.h"
+#include <reent.h>
+
+// newlib's malloc(), calloc() and realloc() call these reentrant versions,
+// so wrapping them counts every allocation (including String and printf
+// float conversion) without touching the core's own malloc wrappers.
+static volatile uint32_t allocCount[2] = {0, 0};
+static volatile uint32_t freeCount[2] = {0, 0};
+
+extern "C" {
+void* __real__malloc_r(struct _reent* r, size_t size);
+void* __real__calloc_r(struct _reent* r, size_t count, size_t size);
+void* __real__realloc_r(struct _reent* r, void* ptr, size_t size);
+void __real__free_r(struct _reent* r, void* ptr);
+
+void* __wrap__malloc_r(struct _reent* r, size_t size) {
+  allocCount[rp2040.cpuid()]++;
+  return __real__malloc_r(r, size);
+}
+
+void* __wrap__calloc_r(struct _reent* r, size_t count, size_t size) {
+  allocCount[rp2040.cpuid()]++;
+  return __real__calloc_r(r, count, size);
+}
+
+void* __wrap__realloc_r(struct _reent* r, void* ptr, size_t size) {
+  allocCount[rp2040.cpuid()]++;
+  return __real__realloc_r(r, ptr, size);
+}
+
+void __wrap__free_r(struct _reent* r, void* ptr) {
+  if (ptr) {
+    freeCount[rp2040.cpuid()]++;
+  }
+  __real__free_r(r, ptr);
+}
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+uint32_t getHeapAllocCount() {
+  return allocCount[rp2040.cpuid()];
+}
+
+void printHeapStats() {
+  Serial.println(F("\n=== HEAP ==="));
+  Serial.printf("Used: %d / %d bytes (free %d)\n",
+                rp2040.getUsedHeap(), rp2040.getTotalHeap(), rp2040.getFreeHeap());
+  for (int core = 0; core < 2; core++) {
+    Serial.printf("Core %d: %lu allocations, %lu frees\n",
+                  core, allocCount[core], freeCount[core]);
+  }
+  Serial.println();
+}
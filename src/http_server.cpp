@@ -0,0 +1,940 @@
+// ============================================================================
+// http_server.cpp - Event-driven HTTP server implementation
+// ============================================================================
+
+#include "http_server.h"
+#include <lwip/tcp.h>
+#include <LWIPMutex.h>
+#include <errno.h>
+#include "heap_stats.h"
+#include "metrics.h"
+
+// lwIP callbacks only move bytes in and out of the connection buffers and
+// record events; parsing, dispatch and response generation happen in
+// pollHttpServer() under the lwIP lock, one step per connection per call.
+
+typedef enum {
+  CONN_FREE = 0,
+  CONN_READING,            // Collecting request line, headers and body
+  CONN_SENDING,            // Draining tx buffer / generating chunks
+  CONN_STREAMING,          // Event stream: headers sent, frames pushed by broadcast
+  CONN_CLOSING             // Response done, close pending
+} ConnState;
+
+struct HttpConnection {
+  ConnState state;
+  struct tcp_pcb* pcb;
+  unsigned long lastActivity;
+  bool peerClosed;         // FIN received
+  uint32_t startUs;        // First request byte received (latency metric)
+
+  struct pbuf* pending;    // Received, not yet in rx (window stays closed)
+  char rx[HTTP_RX_BUFFER_SIZE + 1];
+  uint16_t rxLen;
+
+  HttpRequest request;     // Valid once headerLen is set
+  const HttpRoute* route;
+  uint16_t headerLen;      // 0 until the header block has been parsed
+  uint32_t bodyRemaining;  // Body bytes not yet received
+
+  char tx[HTTP_TX_BUFFER_SIZE];
+  uint16_t txLen;          // Bytes in tx
+  uint16_t txSent;         // Bytes of tx already handed to lwIP
+
+  File file;               // Body source for httpSendFile
+  HttpChunkGenerator generator;
+  bool chunked;            // Chunked body still open
+  bool stream;             // Becomes an event stream once headers are sent
+  uint8_t context[HTTP_CONTEXT_SIZE];
+};
+
+static HttpConnection connections[HTTP_MAX_CONNECTIONS];
+static struct tcp_pcb* listenPcb = nullptr;
+static const HttpRoute* routeTable = nullptr;
+static uint8_t routeTableSize = 0;
+static char authToken[96] = "";   // Expected "Basic ..." credentials
+
+// Counters
+static uint32_t requestCount = 0;
+static uint32_t rejectedCount = 0;     // No free connection slot
+static uint32_t maxPollUs = 0;
+static uint32_t lastRequestAllocs = 0;   // Heap allocations in the last handler
+static uint32_t maxRequestAllocs = 0;
+static uint32_t allocatingRequests = 0;  // Requests whose handler allocated
+static uint32_t eventsSent = 0;        // Frames delivered (per client)
+static uint32_t eventsDropped = 0;     // Frames skipped for slow clients
+static uint8_t streamsOpened = 0;      // Streams that started since httpTakeNewEventStreams()
+
+// Chunk framing: "XXX\r\n" before the data, "\r\n" after
+#define CHUNK_HEADER_SIZE 5
+#define CHUNK_TRAILER_SIZE 2
+
+// ============================================================================
+// INTERNAL FUNCTIONS
+// ============================================================================
+
+static const char* statusText(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 202: return "Accepted";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+static void base64Encode(const char* in, char* out, size_t outSize) {
+  static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t len = strlen(in);
+  size_t o = 0;
+
+  for (size_t i = 0; i < len && o + 4 < outSize; i += 3) {
+    uint32_t v = (uint8_t)in[i] << 16;
+    if (i + 1 < len) v |= (uint8_t)in[i + 1] << 8;
+    if (i + 2 < len) v |= (uint8_t)in[i + 2];
+
+    out[o++] = table[(v >> 18) & 0x3F];
+    out[o++] = table[(v >> 12) & 0x3F];
+    out[o++] = (i + 1 < len) ? table[(v >> 6) & 0x3F] : '=';
+    out[o++] = (i + 2 < len) ? table[v & 0x3F] : '=';
+  }
+  out[o] = '\0';
+}
+
+static void resetConnection(HttpConnection* conn) {
+  conn->state = CONN_FREE;
+  conn->pcb = nullptr;
+  conn->peerClosed = false;
+  conn->startUs = 0;
+  if (conn->pending) {
+    pbuf_free(conn->pending);
+    conn->pending = nullptr;
+  }
+  conn->rxLen = 0;
+  conn->route = nullptr;
+  conn->headerLen = 0;
+  conn->bodyRemaining = 0;
+  conn->txLen = 0;
+  conn->txSent = 0;
+  conn->generator = nullptr;
+  conn->chunked = false;
+  conn->stream = false;
+  if (conn->file) {
+    conn->file.close();
+  }
+}
+
+// Detach callbacks and close; abort if lwIP has no memory to close cleanly
+static void closeConnection(HttpConnection* conn) {
+  struct tcp_pcb* pcb = conn->pcb;
+  if (pcb) {
+    tcp_arg(pcb, nullptr);
+    tcp_recv(pcb, nullptr);
+    tcp_sent(pcb, nullptr);
+    tcp_err(pcb, nullptr);
+    tcp_poll(pcb, nullptr, 0);
+    if (tcp_close(pcb) != ERR_OK) {
+      tcp_abort(pcb);
+    }
+  }
+  resetConnection(conn);
+}
+
+// Start a response: status line and headers into the tx buffer
+static bool beginResponse(HttpConnection* conn, int status, const char* contentType,
+                          const char* extraHeaders, int contentLength,
+                          size_t limit = HTTP_TX_BUFFER_SIZE) {
+  if (conn->state != CONN_READING) {
+    return false;  // Handler already responded
+  }
+
+  int n;
+  if (contentLength >= 0) {
+    n = snprintf(conn->tx, limit,
+                 "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n%sConnection: close\r\n\r\n",
+                 status, statusText(status), contentType, contentLength,
+                 extraHeaders ? extraHeaders : "");
+  } else {
+    n = snprintf(conn->tx, limit,
+                 "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n%sConnection: close\r\n\r\n",
+                 status, statusText(status), contentType,
+                 extraHeaders ? extraHeaders : "");
+  }
+
+  if (n < 0 || n >= (int)limit) {
+    return false;
+  }
+
+  conn->txLen = n;
+  conn->txSent = 0;
+  conn->state = CONN_SENDING;
+  return true;
+}
+
+// Refill the tx buffer with the next chunk from the generator
+static void nextChunk(HttpConnection* conn) {
+  char* data = conn->tx + CHUNK_HEADER_SIZE;
+  size_t cap = sizeof(conn->tx) - CHUNK_HEADER_SIZE - CHUNK_TRAILER_SIZE;
+  size_t len = conn->generator(data, cap, conn->context);
+
+  if (len == 0) {
+    // Last chunk
+    memcpy(conn->tx, "0\r\n\r\n", 5);
+    conn->txLen = 5;
+    conn->chunked = false;
+  } else {
+    // Fixed-width hex length keeps the data where the generator put it
+    char header[CHUNK_HEADER_SIZE + 1];
+    snprintf(header, sizeof(header), "%03X\r\n", (unsigned)len);
+    memcpy(conn->tx, header, CHUNK_HEADER_SIZE);
+    memcpy(data + len, "\r\n", CHUNK_TRAILER_SIZE);
+    conn->txLen = CHUNK_HEADER_SIZE + len + CHUNK_TRAILER_SIZE;
+  }
+  conn->txSent = 0;
+}
+
+// Refill the tx buffer from the file being sent
+static void nextFileBlock(HttpConnection* conn) {
+  int len = conn->file.read((uint8_t*)conn->tx, sizeof(conn->tx));
+  if (len <= 0) {
+    conn->file.close();
+    len = 0;
+  }
+  conn->txLen = len;
+  conn->txSent = 0;
+}
+
+// Response fully handed to lwIP: record the request latency
+static void finishResponse(HttpConnection* conn) {
+  if (conn->startUs != 0) {
+    metricObserve(HISTOGRAM_HTTP_LATENCY, micros() - conn->startUs);
+  }
+  conn->state = CONN_CLOSING;
+}
+
+// Hand as much of the tx buffer to lwIP as the send window allows
+static void sendStep(HttpConnection* conn) {
+  if (conn->txSent == conn->txLen) {
+    if (conn->chunked) {
+      nextChunk(conn);
+    } else if (conn->file) {
+      nextFileBlock(conn);
+      if (conn->txLen == 0) {
+        finishResponse(conn);
+        return;
+      }
+    } else if (conn->stream) {
+      conn->state = CONN_STREAMING;
+      streamsOpened++;
+      return;
+    } else {
+      finishResponse(conn);
+      return;
+    }
+  }
+
+  uint16_t avail = tcp_sndbuf(conn->pcb);
+  uint16_t len = min((uint16_t)(conn->txLen - conn->txSent), avail);
+  if (len == 0) {
+    return;  // Wait for ACKs
+  }
+
+  bool more = conn->chunked || conn->stream || conn->file || (conn->txSent + len < conn->txLen);
+  err_t err = tcp_write(conn->pcb, conn->tx + conn->txSent, len,
+                        TCP_WRITE_FLAG_COPY | (more ? TCP_WRITE_FLAG_MORE : 0));
+  if (err == ERR_OK) {
+    conn->txSent += len;
+    tcp_output(conn->pcb);
+  } else if (err != ERR_MEM) {
+    closeConnection(conn);
+  }
+}
+
+// Find the end of the header block; returns header length or 0
+static uint16_t findHeaderEnd(const char* buf, uint16_t len) {
+  for (uint16_t i = 3; i < len; i++) {
+    if (buf[i - 3] == '\r' && buf[i - 2] == '\n' && buf[i - 1] == '\r' && buf[i] == '\n') {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+// Case-insensitive header lookup within the header block. Returns a
+// pointer to the value (leading spaces skipped) or nullptr.
+static const char* findHeader(const char* headers, const char* name) {
+  size_t nameLen = strlen(name);
+  const char* line = strstr(headers, "\r\n");
+  while (line && line[2] != '\r') {
+    line += 2;
+    if (strncasecmp(line, name, nameLen) == 0 && line[nameLen] == ':') {
+      const char* value = line + nameLen + 1;
+      while (*value == ' ') value++;
+      return value;
+    }
+    line = strstr(line, "\r\n");
+  }
+  return nullptr;
+}
+
+// Move as much pending data into rx as fits and open the receive window
+// by the same amount, so the sender is paced by how fast rx is consumed
+static void pullReceived(HttpConnection* conn) {
+  if (!conn->pending) {
+    return;
+  }
+  uint16_t n = min((uint16_t)(HTTP_RX_BUFFER_SIZE - conn->rxLen), conn->pending->tot_len);
+  if (n == 0) {
+    return;
+  }
+  pbuf_copy_partial(conn->pending, conn->rx + conn->rxLen, n, 0);
+  conn->rxLen += n;
+  conn->pending = pbuf_free_header(conn->pending, n);
+  tcp_recved(conn->pcb, n);
+}
+
+// Drop input that arrives after the request (Connection: close)
+static void discardPending(HttpConnection* conn) {
+  if (conn->pending) {
+    tcp_recved(conn->pcb, conn->pending->tot_len);
+    pbuf_free(conn->pending);
+    conn->pending = nullptr;
+  }
+}
+
+// Match the request against the route table. Answers 404/405/401 itself
+// and returns nullptr in those cases.
+static const HttpRoute* findRoute(HttpConnection* conn, const HttpRequest* req) {
+  bool pathFound = false;
+  for (uint8_t i = 0; i < routeTableSize; i++) {
+    const HttpRoute* route = &routeTable[i];
+    if (strcmp(route->path, req->path) != 0) {
+      continue;
+    }
+    pathFound = true;
+    if (route->method != req->method) {
+      continue;
+    }
+
+    if (route->requireAuth && !req->authorized) {
+      httpSendWithHeaders(conn, 401, "text/plain",
+                          "WWW-Authenticate: Basic realm=\"Sat Tracker\"\r\n",
+                          "Authentication required");
+      return nullptr;
+    }
+    return route;
+  }
+
+  if (pathFound) {
+    httpSend(conn, 405, "text/plain", "Method not allowed");
+  } else {
+    httpSend(conn, 404, "text/plain", "Not found");
+  }
+  return nullptr;
+}
+
+static void runHandler(HttpConnection* conn) {
+  uint32_t allocsBefore = getHeapAllocCount();
+  conn->route->handler(conn, &conn->request);
+  lastRequestAllocs = getHeapAllocCount() - allocsBefore;
+  if (lastRequestAllocs) {
+    allocatingRequests++;
+    maxRequestAllocs = max(maxRequestAllocs, lastRequestAllocs);
+  }
+
+  if (conn->state == CONN_READING) {
+    httpSend(conn, 500, "text/plain", "No response");
+  }
+}
+
+// Content-Length value: decimal digits only, up to the end of the line
+static bool parseContentLength(const char* value, uint32_t* length) {
+  if (*value < '0' || *value > '9') {
+    return false;
+  }
+  char* end;
+  errno = 0;
+  unsigned long n = strtoul(value, &end, 10);
+  while (*end == ' ' || *end == '\t') end++;
+  if (errno == ERANGE || n > UINT32_MAX || *end != '\r') {
+    return false;
+  }
+  *length = (uint32_t)n;
+  return true;
+}
+
+// Parse the request line and headers in place (once) and pick the route.
+// Returns false if a response has already been queued.
+static bool parseHeaders(HttpConnection* conn, uint16_t headerLen) {
+  requestCount++;
+
+  HttpRequest& req = conn->request;
+  req.headers = strstr(conn->rx, "\r\n");
+  req.body = "";
+  req.bodyLength = 0;
+
+  const char* auth = findHeader(conn->rx, "Authorization");
+  req.authorized = auth && authToken[0] &&
+                   strncmp(auth, authToken, strlen(authToken)) == 0 &&
+                   (auth[strlen(authToken)] == '\r');
+
+  const char* lengthHeader = findHeader(conn->rx, "Content-Length");
+  conn->bodyRemaining = 0;
+  if (lengthHeader && !parseContentLength(lengthHeader, &conn->bodyRemaining)) {
+    httpSend(conn, 400, "text/plain", "Bad Content-Length");
+    return false;
+  }
+
+  // Request line: METHOD SP TARGET SP VERSION
+  char* line = conn->rx;
+  char* target = strchr(line, ' ');
+  if (!target || target > req.headers) {
+    httpSend(conn, 400, "text/plain", "Bad request");
+    return false;
+  }
+  *target++ = '\0';
+  char* version = strchr(target, ' ');
+  if (!version || version > req.headers) {
+    httpSend(conn, 400, "text/plain", "Bad request");
+    return false;
+  }
+  *version = '\0';
+
+  req.method = strcmp(line, "GET") == 0 ? HTTP_GET :
+               strcmp(line, "POST") == 0 ? HTTP_POST : HTTP_OTHER;
+
+  char* query = strchr(target, '?');
+  if (query) {
+    *query++ = '\0';
+  }
+  req.path = target;
+  req.query = query ? query : "";
+
+  conn->headerLen = headerLen;
+  conn->route = findRoute(conn, &req);
+  if (!conn->route) {
+    return false;
+  }
+
+  if (!conn->route->bodyHandler) {
+    // headerLen <= HTTP_RX_BUFFER_SIZE, so this cannot wrap
+    if (conn->bodyRemaining > (uint32_t)(HTTP_RX_BUFFER_SIZE - headerLen)) {
+      httpSend(conn, 413, "text/plain", "Request too large");
+      return false;
+    }
+    return true;
+  }
+
+  // Streamed body: needs a length up front, and clients that asked may
+  // now send it
+  if (!lengthHeader) {
+    httpSend(conn, 411, "text/plain", "Content-Length required");
+    return false;
+  }
+  const char* expect = findHeader(req.headers, "Expect");
+  if (expect && strncasecmp(expect, "100-continue", 12) == 0) {
+    static const char continueLine[] = "HTTP/1.1 100 Continue\r\n\r\n";
+    tcp_write(conn->pcb, continueLine, sizeof(continueLine) - 1, 0);
+    tcp_output(conn->pcb);
+  }
+
+  conn->route->bodyHandler(conn, &req, nullptr, 0);
+  return conn->state == CONN_READING;
+}
+
+// Pass whatever body bytes are in rx to the route's body handler and free
+// the space; run the handler proper once the whole body has been seen.
+// Returns false while more data is needed.
+static bool streamBody(HttpConnection* conn) {
+  uint16_t available = conn->rxLen - conn->headerLen;
+  uint16_t len = (uint16_t)min((uint32_t)available, conn->bodyRemaining);
+  if (len > 0) {
+    conn->route->bodyHandler(conn, &conn->request, conn->rx + conn->headerLen, len);
+    conn->bodyRemaining -= len;
+    conn->rxLen = conn->headerLen;
+    if (conn->state != CONN_READING) {
+      return true;  // Body handler rejected the upload
+    }
+  }
+
+  if (conn->bodyRemaining > 0) {
+    return false;
+  }
+
+  conn->rx[conn->rxLen] = '\0';
+  runHandler(conn);
+  return true;
+}
+
+// Parse and dispatch the request as it arrives. Returns false while more
+// data is needed.
+static bool parseStep(HttpConnection* conn) {
+  pullReceived(conn);
+  conn->rx[conn->rxLen] = '\0';
+
+  if (conn->headerLen == 0) {
+    uint16_t headerLen = findHeaderEnd(conn->rx, conn->rxLen);
+    if (headerLen == 0) {
+      if (conn->rxLen == HTTP_RX_BUFFER_SIZE) {
+        httpSend(conn, 413, "text/plain", "Request too large");
+        return true;
+      }
+      return false;
+    }
+    if (!parseHeaders(conn, headerLen)) {
+      return true;
+    }
+  }
+
+  if (conn->route->bodyHandler) {
+    return streamBody(conn);
+  }
+
+  if (conn->rxLen < conn->headerLen + conn->bodyRemaining) {
+    return false;
+  }
+
+  // Terminate the body (the rx buffer has one spare byte)
+  conn->request.body = conn->rx + conn->headerLen;
+  conn->request.bodyLength = conn->bodyRemaining;
+  conn->rx[conn->headerLen + conn->bodyRemaining] = '\0';
+
+  runHandler(conn);
+  return true;
+}
+
+// One bounded step of a connection's state machine
+static void serviceConnection(HttpConnection* conn) {
+  if (conn->state != CONN_READING) {
+    discardPending(conn);
+  }
+
+  switch (conn->state) {
+    case CONN_READING:
+      if (!parseStep(conn) && conn->peerClosed && !conn->pending) {
+        closeConnection(conn);
+      }
+      break;
+
+    case CONN_SENDING:
+      sendStep(conn);
+      break;
+
+    case CONN_STREAMING:
+      if (conn->peerClosed) {
+        closeConnection(conn);
+      }
+      break;
+
+    case CONN_CLOSING:
+      closeConnection(conn);
+      break;
+
+    default:
+      break;
+  }
+}
+
+// ============================================================================
+// LWIP CALLBACKS
+// ============================================================================
+
+static void httpErr(void* arg, err_t err) {
+  // The pcb is already freed by lwIP
+  HttpConnection* conn = (HttpConnection*)arg;
+  if (conn) {
+    resetConnection(conn);
+  }
+}
+
+static err_t httpRecv(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err) {
+  HttpConnection* conn = (HttpConnection*)arg;
+
+  if (!p) {
+    conn->peerClosed = true;
+    return ERR_OK;
+  }
+
+  conn->lastActivity = millis();
+  if (conn->startUs == 0) {
+    conn->startUs = micros() | 1;  // 0 means "not started"
+  }
+
+  // Held until pollHttpServer() has room for it; not acknowledging the
+  // data keeps large uploads flowing at the pace they are consumed
+  if (conn->state == CONN_READING) {
+    if (conn->pending) {
+      pbuf_cat(conn->pending, p);
+    } else {
+      conn->pending = p;
+    }
+    return ERR_OK;
+  }
+
+  // Anything after the request is discarded (Connection: close)
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static err_t httpSent(void* arg, struct tcp_pcb* pcb, uint16_t len) {
+  HttpConnection* conn = (HttpConnection*)arg;
+  conn->lastActivity = millis();
+  return ERR_OK;
+}
+
+static err_t httpPoll(void* arg, struct tcp_pcb* pcb) {
+  HttpConnection* conn = (HttpConnection*)arg;
+  if (millis() - conn->lastActivity > HTTP_IDLE_TIMEOUT_MS) {
+    tcp_arg(pcb, nullptr);
+    tcp_err(pcb, nullptr);
+    tcp_abort(pcb);
+    resetConnection(conn);
+    return ERR_ABRT;
+  }
+  return ERR_OK;
+}
+
+static err_t httpAccept(void* arg, struct tcp_pcb* pcb, err_t err) {
+  if (err != ERR_OK || !pcb) {
+    return ERR_VAL;
+  }
+
+  HttpConnection* conn = nullptr;
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    if (connections[i].state == CONN_FREE) {
+      conn = &connections[i];
+      break;
+    }
+  }
+
+  if (!conn) {
+    rejectedCount++;
+    tcp_abort(pcb);
+    return ERR_ABRT;
+  }
+
+  resetConnection(conn);
+  conn->state = CONN_READING;
+  conn->pcb = pcb;
+  conn->lastActivity = millis();
+
+  tcp_arg(pcb, conn);
+  tcp_recv(pcb, httpRecv);
+  tcp_sent(pcb, httpSent);
+  tcp_err(pcb, httpErr);
+  tcp_poll(pcb, httpPoll, 4);  // Every 2 s (units of 500 ms)
+  return ERR_OK;
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+bool startHttpServer(uint16_t port, const HttpRoute* routes, uint8_t routeCount,
+                     const char* username, const char* password) {
+  if (listenPcb) {
+    return true;
+  }
+
+  routeTable = routes;
+  routeTableSize = routeCount;
+
+  char credentials[64];
+  snprintf(credentials, sizeof(credentials), "%s:%s", username, password);
+  strcpy(authToken, "Basic ");
+  base64Encode(credentials, authToken + 6, sizeof(authToken) - 6);
+
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    resetConnection(&connections[i]);
+  }
+
+  LWIPMutex m;
+  struct tcp_pcb* pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  if (!pcb) {
+    Serial.println("ERROR: HTTP server could not allocate pcb");
+    return false;
+  }
+
+  if (tcp_bind(pcb, IP_ANY_TYPE, port) != ERR_OK) {
+    Serial.printf("ERROR: HTTP server could not bind port %d\n", port);
+    tcp_close(pcb);
+    return false;
+  }
+
+  listenPcb = tcp_listen_with_backlog(pcb, HTTP_MAX_CONNECTIONS);
+  if (!listenPcb) {
+    tcp_close(pcb);
+    return false;
+  }
+  tcp_accept(listenPcb, httpAccept);
+
+  Serial.printf("HTTP server listening on port %d (%d connections)\n", port, HTTP_MAX_CONNECTIONS);
+  return true;
+}
+
+void stopHttpServer() {
+  LWIPMutex m;
+
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    if (connections[i].state != CONN_FREE) {
+      closeConnection(&connections[i]);
+    }
+  }
+
+  if (listenPcb) {
+    tcp_close(listenPcb);
+    listenPcb = nullptr;
+  }
+}
+
+bool isHttpServerRunning() {
+  return listenPcb != nullptr;
+}
+
+void pollHttpServer() {
+  if (!listenPcb) {
+    return;
+  }
+
+  uint32_t start = micros();
+
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    if (connections[i].state == CONN_FREE) {
+      continue;
+    }
+    LWIPMutex m;
+    serviceConnection(&connections[i]);
+  }
+
+  uint32_t elapsed = micros() - start;
+  if (elapsed > maxPollUs) maxPollUs = elapsed;
+}
+
+// ============================================================================
+// RESPONSE API
+// ============================================================================
+
+void httpSendWithHeaders(HttpConnection* conn, int status, const char* contentType,
+                         const char* extraHeaders, const char* body) {
+  size_t bodyLen = strlen(body);
+  if (!beginResponse(conn, status, contentType, extraHeaders, bodyLen)) {
+    return;
+  }
+
+  if (conn->txLen + bodyLen > sizeof(conn->tx)) {
+    // Too big for a fixed response - large bodies must be streamed
+    conn->state = CONN_READING;
+    httpSend(conn, 500, "text/plain", "Response too large");
+    return;
+  }
+
+  memcpy(conn->tx + conn->txLen, body, bodyLen);
+  conn->txLen += bodyLen;
+}
+
+void httpSend(HttpConnection* conn, int status, const char* contentType, const char* body) {
+  httpSendWithHeaders(conn, status, contentType, nullptr, body);
+}
+
+char* httpBodyBuffer(HttpConnection* conn, size_t* capacity) {
+  *capacity = sizeof(conn->tx) - HTTP_HEADER_RESERVE;
+  return conn->tx + HTTP_HEADER_RESERVE;
+}
+
+void httpSendBody(HttpConnection* conn, int status, const char* contentType,
+                  const char* extraHeaders, size_t length) {
+  if (length > sizeof(conn->tx) - HTTP_HEADER_RESERVE) {
+    httpSend(conn, 500, "text/plain", "Response too large");
+    return;
+  }
+
+  // Headers must end before the body; then close the gap
+  if (!beginResponse(conn, status, contentType, extraHeaders, length, HTTP_HEADER_RESERVE)) {
+    if (conn->state == CONN_READING) {
+      httpSend(conn, 500, "text/plain", "Headers too large");
+    }
+    return;
+  }
+  memmove(conn->tx + conn->txLen, conn->tx + HTTP_HEADER_RESERVE, length);
+  conn->txLen += length;
+}
+
+void httpSendFile(HttpConnection* conn, int status, const char* contentType,
+                  const char* extraHeaders, File file) {
+  if (!file) {
+    httpSend(conn, 404, "text/plain", "Not found");
+    return;
+  }
+  if (!beginResponse(conn, status, contentType, extraHeaders, file.size())) {
+    file.close();
+    return;
+  }
+  conn->file = file;
+}
+
+void* httpSendChunked(HttpConnection* conn, int status, const char* contentType,
+                      HttpChunkGenerator generator) {
+  if (!beginResponse(conn, status, contentType, nullptr, -1)) {
+    return nullptr;
+  }
+
+  conn->generator = generator;
+  conn->chunked = true;
+  memset(conn->context, 0, sizeof(conn->context));
+  return conn->context;
+}
+
+void httpBeginEventStream(HttpConnection* conn) {
+  if (httpEventStreamCount() >= HTTP_MAX_STREAMS) {
+    httpSend(conn, 503, "text/plain", "Too many event streams");
+    return;
+  }
+
+  if (conn->state != CONN_READING) {
+    return;
+  }
+
+  int n = snprintf(conn->tx, sizeof(conn->tx),
+                   "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                   "Cache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n"
+                   "retry: 2000\n\n");
+  conn->txLen = n;
+  conn->txSent = 0;
+  conn->stream = true;
+  conn->state = CONN_SENDING;
+}
+
+// ============================================================================
+// EVENT STREAMS
+// ============================================================================
+
+uint8_t httpEventStreamCount() {
+  uint8_t count = 0;
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    if (connections[i].state != CONN_FREE && connections[i].stream) {
+      count++;
+    }
+  }
+  return count;
+}
+
+uint8_t httpTakeNewEventStreams() {
+  uint8_t count = streamsOpened;
+  streamsOpened = 0;
+  return count;
+}
+
+uint8_t httpBroadcastEvent(const char* frame, size_t len) {
+  if (!listenPcb) {
+    return 0;
+  }
+
+  LWIPMutex m;
+  uint8_t delivered = 0;
+
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    HttpConnection* conn = &connections[i];
+    if (conn->state != CONN_STREAMING) {
+      continue;
+    }
+
+    // lwIP copies the frame, so one shared buffer serves every client.
+    // A frame is all-or-nothing: partial writes would corrupt the stream.
+    if (tcp_sndbuf(conn->pcb) < len ||
+        tcp_write(conn->pcb, frame, len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+      eventsDropped++;
+      continue;
+    }
+    tcp_output(conn->pcb);
+    conn->lastActivity = millis();
+    eventsSent++;
+    delivered++;
+  }
+
+  return delivered;
+}
+
+// ============================================================================
+// PARAMETERS
+// ============================================================================
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool httpGetHeader(const HttpRequest* req, const char* name, char* out, size_t outSize) {
+  const char* value = findHeader(req->headers, name);
+  if (!value || outSize == 0) {
+    return false;
+  }
+  size_t o = 0;
+  while (value[o] && value[o] != '\r' && o + 1 < outSize) {
+    out[o] = value[o];
+    o++;
+  }
+  out[o] = '\0';
+  return true;
+}
+
+bool httpGetParam(const char* params, const char* name, char* out, size_t outSize) {
+  size_t nameLen = strlen(name);
+  const char* p = params;
+
+  while (p && *p) {
+    if (strncmp(p, name, nameLen) == 0 && p[nameLen] == '=') {
+      p += nameLen + 1;
+      size_t o = 0;
+      while (*p && *p != '&' && o + 1 < outSize) {
+        if (*p == '+') {
+          out[o++] = ' ';
+          p++;
+        } else if (*p == '%' && hexValue(p[1]) >= 0 && hexValue(p[2]) >= 0) {
+          out[o++] = (char)(hexValue(p[1]) << 4 | hexValue(p[2]));
+          p += 3;
+        } else {
+          out[o++] = *p++;
+        }
+      }
+      out[o] = '\0';
+      return true;
+    }
+    p = strchr(p, '&');
+    if (p) p++;
+  }
+  return false;
+}
+
+void printHttpServerStatus() {
+  Serial.println(F("\n=== HTTP SERVER ==="));
+  Serial.printf("Listening: %s\n", listenPcb ? "YES" : "NO");
+
+  static const char* stateNames[] = {"free", "reading", "sending", "streaming", "closing"};
+  for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+    const HttpConnection& conn = connections[i];
+    Serial.printf("  Conn %d: %s", i, stateNames[conn.state]);
+    if (conn.state != CONN_FREE) {
+      Serial.printf(" (rx %u, tx %u/%u)", conn.rxLen, conn.txSent, conn.txLen);
+    }
+    Serial.println();
+  }
+
+  Serial.printf("Requests: %lu, rejected: %lu\n", requestCount, rejectedCount);
+  Serial.printf("Event streams: %u, frames sent: %lu, dropped: %lu\n",
+                httpEventStreamCount(), eventsSent, eventsDropped);
+  Serial.printf("Handler heap allocations: last %lu, max %lu, requests allocating %lu\n",
+                lastRequestAllocs, maxRequestAllocs, allocatingRequests);
+  Serial.printf("Max poll time: %lu us\n", maxPollUs);
+  Serial.println();
+}
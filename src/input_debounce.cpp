@@ -0,0 +1,261 @@
+// ============================================================================
+// input_debounce.cpp - PIO input debouncer implementation
+// ============================================================================
+
+#include "input_debounce.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+
+// Debounce configuration
+#define DEBOUNCE_SAMPLE_US 100    // PIO sampling period
+#define DEBOUNCE_SAMPLES 32       // Stable samples before a change is reported (1-32)
+#define DEBOUNCE_CYCLES 8         // PIO cycles per sample (both loops below)
+#define DEBOUNCE_MAX_GROUPS 6     // One state machine per run of adjacent pins
+#define DEBOUNCE_PIO_COUNT 2
+
+// Pins with their own state machine, so that chatter on a neighbour
+// cannot restart their stable count
+#define DEBOUNCE_ISOLATED_PINS (1u << EMERGENCY_STOP_PIN)
+
+// The PIO can only read a contiguous block of pins, and the mechanical
+// inputs are spread over GPIO 15-29 with SPI, ADC and LED pins between
+// them. Pins are therefore split into runs of adjacent GPIOs, one state
+// machine per run, sharing one IRQ line per PIO. RP2350 IN pin masking
+// (in_count) keeps neighbouring pins out of each run. Runs go on PIO2;
+// once its four state machines are taken the rest go on PIO1 beside the
+// LED driver.
+static PIO debPios[DEBOUNCE_PIO_COUNT] = {pio2, pio1};
+static const uint debIrqs[DEBOUNCE_PIO_COUNT] = {PIO2_IRQ_0, PIO1_IRQ_0};
+static uint debOffsets[DEBOUNCE_PIO_COUNT];
+static bool debLoaded[DEBOUNCE_PIO_COUNT] = {false, false};
+
+struct InputGroup {
+  uint8_t pio;             // Index into debPios
+  int sm;                  // State machine, -1 if unused
+  uint8_t base;            // First GPIO of the run
+  uint8_t count;           // Number of adjacent GPIOs
+};
+
+static InputGroup groups[DEBOUNCE_MAX_GROUPS];
+static uint8_t groupCount = 0;
+
+static InputEdgeHandler pinHandlers[32] = {nullptr};
+static uint32_t inputMask = 0;                 // Pins being debounced
+static volatile uint32_t debouncedState = 0;   // Last clean level of every pin
+static volatile uint32_t reportCount = 0;      // Reports from the PIO
+static volatile uint32_t edgeCount = 0;        // Transitions passed to handlers
+
+// ============================================================================
+// PIO PROGRAM
+// ============================================================================
+// X holds the last reported level of the run. When a sample differs it
+// becomes the candidate, and the OSR shift counter (reset by 'mov osr')
+// counts stable samples up to the OUT threshold. Any change restarts the
+// count; DEBOUNCE_SAMPLES identical samples push the new level. Both
+// loops take DEBOUNCE_CYCLES cycles per sample.
+
+const uint16_t input_debounce_program_instructions[] = {
+    //     .wrap_target
+    0xa040, //  0: mov    y, pins                    ; Sample the run
+    0x00a3, //  1: jmp    x != y, 3                  ; Changed?
+    0x0500, //  2: jmp    0                     [5]
+    0xa022, //  3: mov    x, y                       ; New candidate
+    0xa0e3, //  4: mov    osr, null                  ; Reset stable count
+    0xa040, //  5: mov    y, pins
+    0x00a3, //  6: jmp    x != y, 3                  ; Bounced: restart count
+    0x6061, //  7: out    null, 1                    ; One more stable sample
+    0x04e5, //  8: jmp    !osre, 5              [4]
+    0xa0c1, //  9: mov    isr, x                     ; Stable: report it
+    0x8000, // 10: push   noblock
+    //     .wrap
+};
+
+const struct pio_program input_debounce_program = {
+    .instructions = input_debounce_program_instructions,
+    .length = 11,
+    .origin = -1,
+};
+
+static inline void input_debounce_program_init(PIO pio, uint sm, uint offset, uint base, uint count, float div) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + 0, offset + 10);
+    
+    // Read 'count' pins from 'base'; higher pins read as 0
+    sm_config_set_in_pins(&c, base);
+    sm_config_set_in_pin_count(&c, count);
+    
+    // OUT threshold is the stable sample count (32 is encoded as 0)
+    sm_config_set_out_shift(&c, true, false, DEBOUNCE_SAMPLES);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+    sm_config_set_clkdiv(&c, div);
+    
+    pio_sm_init(pio, sm, offset, &c);
+}
+
+// ============================================================================
+// INTERRUPT HANDLER
+// ============================================================================
+
+// One IRQ for all runs: merge each report into the global pin state and
+// dispatch every pin in the change mask
+static void __not_in_flash_func(inputDebounceIrq)() {
+  uint32_t settledUs = micros() - DEBOUNCE_SAMPLES * DEBOUNCE_SAMPLE_US;
+  
+  for (int g = 0; g < groupCount; g++) {
+    InputGroup& group = groups[g];
+    PIO pio = debPios[group.pio];
+    uint32_t groupMask = ((1u << group.count) - 1) << group.base;
+    
+    while (!pio_sm_is_rx_fifo_empty(pio, group.sm)) {
+      uint32_t sample = (pio_sm_get(pio, group.sm) << group.base) & groupMask;
+      uint32_t changed = (sample ^ debouncedState) & groupMask & inputMask;
+      debouncedState = (debouncedState & ~groupMask) | sample;
+      reportCount++;
+      
+      while (changed) {
+        uint8_t pin = __builtin_ctz(changed);
+        changed &= changed - 1;
+        edgeCount++;
+        if (pinHandlers[pin]) {
+          pinHandlers[pin](pin, (sample >> pin) & 1, settledUs);
+        }
+      }
+    }
+  }
+}
+
+// ============================================================================
+// INTERNAL FUNCTIONS
+// ============================================================================
+
+static void stopDebouncer() {
+  for (int p = 0; p < DEBOUNCE_PIO_COUNT; p++) {
+    if (debLoaded[p]) irq_set_enabled(debIrqs[p], false);
+  }
+  for (int g = 0; g < groupCount; g++) {
+    PIO pio = debPios[groups[g].pio];
+    pio_sm_set_enabled(pio, groups[g].sm, false);
+    pio_set_irq0_source_enabled(pio, (pio_interrupt_source)(pis_sm0_rx_fifo_not_empty + groups[g].sm), false);
+    pio_sm_unclaim(pio, groups[g].sm);
+  }
+  groupCount = 0;
+}
+
+// Claim a state machine for a run, loading the program into a PIO the
+// first time it is used. Returns the PIO index, or -1.
+static int claimDebounceSm(int* sm) {
+  for (int p = 0; p < DEBOUNCE_PIO_COUNT; p++) {
+    PIO pio = debPios[p];
+    if (!debLoaded[p] && !pio_can_add_program(pio, &input_debounce_program)) {
+      continue;
+    }
+    *sm = pio_claim_unused_sm(pio, false);
+    if (*sm < 0) {
+      continue;
+    }
+    if (!debLoaded[p]) {
+      debOffsets[p] = pio_add_program(pio, &input_debounce_program);
+      irq_add_shared_handler(debIrqs[p], inputDebounceIrq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+      debLoaded[p] = true;
+    }
+    return p;
+  }
+  return -1;
+}
+
+// Split the pin set into runs of adjacent GPIOs and start one state
+// machine per run
+static bool startDebouncer() {
+  float div = (clock_get_hz(clk_sys) / 1000000.0f) * DEBOUNCE_SAMPLE_US / DEBOUNCE_CYCLES;
+  
+  // Pins start from their current level so nothing is reported at start
+  debouncedState = 0;
+  for (int pin = 0; pin < 32; pin++) {
+    if (inputMask & (1u << pin)) {
+      debouncedState |= (uint32_t)digitalRead(pin) << pin;
+    }
+  }
+  
+  uint32_t remaining = inputMask;
+  while (remaining) {
+    if (groupCount == DEBOUNCE_MAX_GROUPS) {
+      Serial.println("ERROR: Too many separate input pin runs for the debouncer");
+      return false;
+    }
+    
+    // A run ends at a gap or at an isolated pin, which runs alone
+    uint8_t base = __builtin_ctz(remaining);
+    uint8_t count = 0;
+    do {
+      remaining &= ~(1u << (base + count));
+      count++;
+    } while (base + count < 32 && (remaining & (1u << (base + count))) &&
+             !((DEBOUNCE_ISOLATED_PINS >> base) & 1) &&
+             !((DEBOUNCE_ISOLATED_PINS >> (base + count)) & 1));
+    
+    InputGroup& group = groups[groupCount];
+    int p = claimDebounceSm(&group.sm);
+    if (p < 0) {
+      Serial.println("ERROR: No free PIO state machine for input debouncer");
+      return false;
+    }
+    group.pio = p;
+    group.base = base;
+    group.count = count;
+    groupCount++;
+    
+    PIO pio = debPios[p];
+    input_debounce_program_init(pio, group.sm, debOffsets[p], base, count, div);
+    pio_set_irq0_source_enabled(pio, (pio_interrupt_source)(pis_sm0_rx_fifo_not_empty + group.sm), true);
+  }
+  
+  for (int p = 0; p < DEBOUNCE_PIO_COUNT; p++) {
+    if (debLoaded[p]) irq_set_enabled(debIrqs[p], true);
+  }
+  for (int g = 0; g < groupCount; g++) {
+    pio_sm_set_enabled(debPios[groups[g].pio], groups[g].sm, true);
+  }
+  return true;
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+bool addDebouncedInput(uint8_t pin, InputEdgeHandler handler) {
+  if (pin >= 32) {
+    return false;
+  }
+  
+  stopDebouncer();
+  pinHandlers[pin] = handler;
+  inputMask |= (1u << pin);
+  
+  if (!startDebouncer()) {
+    return false;
+  }
+  
+  Serial.printf("Debounced input: GPIO %d (%d runs active)\n", pin, groupCount);
+  return true;
+}
+
+bool getDebouncedInput(uint8_t pin) {
+  if (pin >= 32 || !(inputMask & (1u << pin))) {
+    return false;
+  }
+  return (debouncedState >> pin) & 1;
+}
+
+void printInputDebounceStatus() {
+  Serial.println(F("\n=== INPUT DEBOUNCER ==="));
+  Serial.printf("Sample period: %d us, stable samples: %d (%d us)\n",
+                DEBOUNCE_SAMPLE_US, DEBOUNCE_SAMPLES, DEBOUNCE_SAMPLE_US * DEBOUNCE_SAMPLES);
+  for (int g = 0; g < groupCount; g++) {
+    Serial.printf("  PIO%d SM %d: GPIO %d-%d\n", groups[g].pio == 0 ? 2 : 1, groups[g].sm,
+                  groups[g].base, groups[g].base + groups[g].count - 1);
+  }
+  Serial.printf("Pin mask: 0x%08lX, state: 0x%08lX\n", inputMask, debouncedState & inputMask);
+  Serial.printf("Reports: %lu, edges: %lu\n", reportCount, edgeCount);
+  Serial.println();
+}
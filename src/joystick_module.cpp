@@ -3,6 +3,26 @@
 // ============================================================================
 
 #include "joystick_module.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+// ADC sampling configuration. The ADC free-runs in round-robin over the two
+// joystick inputs and DMA writes the samples into a ring buffer; each time
+// the ring fills, the DMA IRQ decimates it into one filtered X/Y pair.
+#define JOY_ADC_SAMPLE_HZ 16000      // Total conversions/s (both channels)
+#define JOY_ADC_RING_SAMPLES 128     // Ring length (power of 2, even)
+#define JOY_ADC_RING_BITS 8          // log2 of ring size in bytes
+#define JOY_OVERSAMPLE 64            // Samples per channel per block (4^3)
+#define JOY_EXTRA_BITS 3             // Bits gained: sum of 64 x 12 bits >> 3 = 15 bits
+#define JOY_STARTUP_TIMEOUT_MS 50
+
+#ifndef ADC_BASE_PIN
+#define ADC_BASE_PIN 26
+#endif
+
+static_assert(JOY_ADC_RING_SAMPLES == 2 * JOY_OVERSAMPLE, "ring holds one block per channel");
+static_assert((1 << JOY_ADC_RING_BITS) == JOY_ADC_RING_SAMPLES * sizeof(uint16_t), "ring bits must match ring size");
 
 // Current joystick state (button fields removed)
 static JoystickData currentState = {0, 0, 0.0, 0.0, true};
@@ -28,21 +48,32 @@ static uint16_t calSampleCount = 0;
 // Manual mode state - now controlled externally (not by joystick button)
 static bool manualModeActive = false;
 
+// Stick response curve: fine control near center, full speed at the ends
+static float jogExpo = JOG_EXPO;
+
+// ADC sampler state. The ring must be aligned to its size for DMA wrapping.
+static uint16_t adcRing[JOY_ADC_RING_SAMPLES] __attribute__((aligned(JOY_ADC_RING_SAMPLES * sizeof(uint16_t))));
+static int adcDma = -1;
+static bool xIsFirstInput = false;     // Round-robin order within the ring
+static volatile uint32_t adcFiltered = 0;  // X in high half, Y in low half (15-bit each)
+static volatile uint32_t adcBlocks = 0;    // Decimated blocks produced
+
 // ============================================================================
 // INTERNAL FUNCTIONS
 // ============================================================================
 
-// Apply deadband and normalize value
-static float applyDeadbandAndNormalize(int16_t raw, uint16_t min, uint16_t center, uint16_t max, uint16_t deadbandPercent) {
+// Apply deadband and normalize value. 'raw' is in 12-bit ADC units but
+// keeps the fractional bits gained from oversampling.
+static float applyDeadbandAndNormalize(float raw, uint16_t min, uint16_t center, uint16_t max, uint16_t deadbandPercent) {
   // Calculate deadband threshold
   uint16_t rangeHalf = (max - min) / 2;
   uint16_t deadbandRange = (rangeHalf * deadbandPercent) / 100;
   
   // Convert raw to signed offset from center
-  int16_t offset = raw - center;
+  float offset = raw - center;
   
   // Apply deadband
-  if (abs(offset) < deadbandRange) {
+  if (fabsf(offset) < deadbandRange) {
     return 0.0;
   }
   
@@ -50,16 +81,21 @@ static float applyDeadbandAndNormalize(int16_t raw, uint16_t min, uint16_t cente
   float normalized;
   if (offset > 0) {
     // Positive side
-    normalized = (float)(offset - deadbandRange) / (float)(max - center - deadbandRange);
+    normalized = (offset - deadbandRange) / (float)(max - center - deadbandRange);
   } else {
     // Negative side
-    normalized = (float)(offset + deadbandRange) / (float)(center - min - deadbandRange);
+    normalized = (offset + deadbandRange) / (float)(center - min - deadbandRange);
   }
   
   // Clamp to -1.0 to +1.0
   return constrain(normalized, -1.0, 1.0);
 }
 
+// Blend linear and cubic response: out = (1 - e) * x + e * x^3
+static float applyExpo(float x) {
+  return (1.0f - jogExpo) * x + jogExpo * x * x * x;
+}
+
 // Check if value is in deadband
 static bool isInDeadband(int16_t raw, uint16_t center, uint16_t range, uint16_t deadbandPercent) {
   int16_t offset = abs(raw - center);
@@ -67,10 +103,88 @@ static bool isInDeadband(int16_t raw, uint16_t center, uint16_t range, uint16_t
   return offset < deadbandRange;
 }
 
-// Read raw ADC values (no button)
+// DMA IRQ: the ring has just been filled, decimate it. The channel has
+// already re-triggered itself, so the first few samples may be one block
+// newer - harmless for an average.
+static void joystickDmaIrq() {
+  if (!dma_channel_get_irq1_status(adcDma)) {
+    return;
+  }
+  dma_channel_acknowledge_irq1(adcDma);
+  
+  uint32_t sumFirst = 0, sumSecond = 0;
+  for (int i = 0; i < JOY_ADC_RING_SAMPLES; i += 2) {
+    sumFirst += adcRing[i];
+    sumSecond += adcRing[i + 1];
+  }
+  
+  uint32_t first = sumFirst >> JOY_EXTRA_BITS;
+  uint32_t second = sumSecond >> JOY_EXTRA_BITS;
+  uint32_t x = xIsFirstInput ? first : second;
+  uint32_t y = xIsFirstInput ? second : first;
+  
+  // Single word store so readers always see a matching X/Y pair
+  adcFiltered = (x << 16) | y;
+  adcBlocks++;
+}
+
+// Start the free-running ADC and its DMA ring
+static void startJoystickSampler() {
+  uint xInput = JOYSTICK_X_PIN - ADC_BASE_PIN;
+  uint yInput = JOYSTICK_Y_PIN - ADC_BASE_PIN;
+  xIsFirstInput = xInput < yInput;
+  
+  adc_init();
+  adc_gpio_init(JOYSTICK_X_PIN);
+  adc_gpio_init(JOYSTICK_Y_PIN);
+  
+  // Round-robin starts at the lowest selected input
+  adc_select_input(min(xInput, yInput));
+  adc_set_round_robin((1u << xInput) | (1u << yInput));
+  adc_fifo_setup(true,    // Write conversions to the FIFO
+                 true,    // Raise DREQ for DMA
+                 1,       // DREQ when at least one sample is present
+                 false,   // No error bit (samples stay 12-bit)
+                 false);  // No byte shift
+  adc_set_clkdiv(48000000.0f / JOY_ADC_SAMPLE_HZ - 1.0f);
+  
+  adcDma = dma_claim_unused_channel(true);
+  dma_channel_config c = dma_channel_get_default_config(adcDma);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+  channel_config_set_read_increment(&c, false);
+  channel_config_set_write_increment(&c, true);
+  channel_config_set_ring(&c, true, JOY_ADC_RING_BITS);
+  channel_config_set_dreq(&c, DREQ_ADC);
+  
+  dma_channel_set_irq1_enabled(adcDma, true);
+  irq_add_shared_handler(DMA_IRQ_1, joystickDmaIrq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_1, true);
+  
+  // Self-triggering transfer count (RP2350): the channel restarts itself
+  // after each ring pass, so no CPU or second channel is needed to keep it
+  // running
+  dma_channel_configure(adcDma, &c, adcRing, &adc_hw->fifo,
+                        (DMA_CH0_TRANS_COUNT_MODE_VALUE_TRIGGER_SELF << DMA_CH0_TRANS_COUNT_MODE_LSB) |
+                        JOY_ADC_RING_SAMPLES,
+                        true);
+  
+  adc_fifo_drain();
+  adc_run(true);
+}
+
+// Latest filtered values in 12-bit ADC units, including oversampled fraction
+static void readFilteredJoystick(float* x, float* y) {
+  uint32_t packed = adcFiltered;
+  *x = (packed >> 16) / (float)(1 << JOY_EXTRA_BITS);
+  *y = (packed & 0xFFFF) / (float)(1 << JOY_EXTRA_BITS);
+}
+
+// Read raw ADC values (no button), rounded to 12 bits
 static void readRawJoystick(uint16_t* x, uint16_t* y) {
-  *x = analogRead(JOYSTICK_X_PIN);
-  *y = analogRead(JOYSTICK_Y_PIN);
+  uint32_t packed = adcFiltered;
+  const uint32_t half = 1 << (JOY_EXTRA_BITS - 1);
+  *x = min((uint32_t)4095, ((packed >> 16) + half) >> JOY_EXTRA_BITS);
+  *y = min((uint32_t)4095, ((packed & 0xFFFF) + half) >> JOY_EXTRA_BITS);
 }
 
 // ============================================================================
@@ -80,39 +194,41 @@ static void readRawJoystick(uint16_t* x, uint16_t* y) {
 void initJoystick() {
   Serial.println("Initializing joystick...");
   
-  // Configure analog pins (RP2040/RP2350 has 12-bit ADC)
-  analogReadResolution(12);  // 0-4095 range
-  pinMode(JOYSTICK_X_PIN, INPUT);
-  pinMode(JOYSTICK_Y_PIN, INPUT);
-  
-  // No button pin configuration (button is now E-Stop)
+  // Free-running 12-bit ADC with DMA (no button - button is now E-Stop)
+  startJoystickSampler();
   
-  // Read initial center position
-  uint16_t x, y;
+  // Center position from the first decimated block (already an average
+  // of JOY_OVERSAMPLE samples per axis, ready within ~8 ms)
+  unsigned long start = millis();
+  while (adcBlocks < 2 && millis() - start < JOY_STARTUP_TIMEOUT_MS) {
+    yield();
+  }
   
-  // Average multiple samples for center calibration
-  uint32_t xSum = 0, ySum = 0;
-  for (int i = 0; i < 10; i++) {
+  if (adcBlocks >= 2) {
+    uint16_t x, y;
     readRawJoystick(&x, &y);
-    xSum += x;
-    ySum += y;
-    delay(10);
+    calibration.xCenter = x;
+    calibration.yCenter = y;
+  } else {
+    Serial.println("  WARNING: ADC sampler not running, using default center");
   }
   
-  calibration.xCenter = xSum / 10;
-  calibration.yCenter = ySum / 10;
-  
   Serial.println("Joystick initialized");
   Serial.printf("  X pin: GPIO %d, Center: %d\n", JOYSTICK_X_PIN, calibration.xCenter);
   Serial.printf("  Y pin: GPIO %d, Center: %d\n", JOYSTICK_Y_PIN, calibration.yCenter);
   Serial.printf("  Deadband: %d%%\n", calibration.deadband);
+  Serial.printf("  Sampling: %d Hz/axis, %dx oversampled (%d-bit)\n",
+                JOY_ADC_SAMPLE_HZ / 2, JOY_OVERSAMPLE, 12 + JOY_EXTRA_BITS);
   Serial.println("  Note: Joystick button is now Emergency Stop (GP23)");
 }
 
 JoystickData readJoystick() {
   uint16_t rawX, rawY;
+  float filteredX, filteredY;
   
+  // Constant-time fetch of the latest decimated block
   readRawJoystick(&rawX, &rawY);
+  readFilteredJoystick(&filteredX, &filteredY);
   
   // Update state
   currentState.x = rawX;
@@ -120,7 +236,7 @@ JoystickData readJoystick() {
   
   // Normalize values with deadband
   currentState.xNormalized = applyDeadbandAndNormalize(
-    rawX,
+    filteredX,
     calibration.xMin,
     calibration.xCenter,
     calibration.xMax,
@@ -128,7 +244,7 @@ JoystickData readJoystick() {
   );
   
   currentState.yNormalized = applyDeadbandAndNormalize(
-    rawY,
+    filteredY,
     calibration.yMin,
     calibration.yCenter,
     calibration.yMax,
@@ -162,7 +278,7 @@ float getJoystickAzimuthSpeed() {
   // X axis controls azimuth
   // Right (higher value) = positive speed (clockwise)
   // Left (lower value) = negative speed (counterclockwise)
-  return currentState.xNormalized;
+  return applyExpo(currentState.xNormalized);
 }
 
 float getJoystickElevationSpeed() {
@@ -174,7 +290,16 @@ float getJoystickElevationSpeed() {
   // Y axis controls elevation
   // Up (higher value) = positive speed (up)
   // Down (lower value) = negative speed (down)
-  return currentState.yNormalized;
+  return applyExpo(currentState.yNormalized);
+}
+
+void setJoystickExpo(float expo) {
+  jogExpo = constrain(expo, 0.0f, 1.0f);
+  Serial.printf("Joystick expo: %.2f\n", jogExpo);
+}
+
+float getJoystickExpo() {
+  return jogExpo;
 }
 
 // Manual mode control - called by external systems (display/serial)
@@ -375,6 +500,12 @@ void printJoystickStatus() {
   Serial.print(cal.deadband);
   Serial.println(F("%"));
   
+  Serial.println();
+  Serial.println(F("ADC Sampler:"));
+  Serial.printf("  Rate: %d Hz/axis, %dx oversampled, %d-bit\n",
+                JOY_ADC_SAMPLE_HZ / 2, JOY_OVERSAMPLE, 12 + JOY_EXTRA_BITS);
+  Serial.printf("  Blocks: %lu\n", adcBlocks);
+  
   Serial.println();
   Serial.println(F("Speed Commands:"));
   
@@ -384,29 +515,27 @@ void printJoystickStatus() {
   Serial.print(F("  Elevation: "));
   Serial.println(getJoystickElevationSpeed(), 3);
   
+  Serial.print(F("  Expo:      "));
+  Serial.println(getJoystickExpo(), 2);
+  
   Serial.println();
 }
 
-void printRawJoystickData(int samples) {
+void printRawJoystickHeader(int samples) {
   Serial.println(F("\n=== RAW JOYSTICK DATA ==="));
   Serial.printf("Collecting %d samples...\n", samples);
   Serial.println();
-  Serial.println(F("Sample    X     Y     X_norm  Y_norm  Button"));
-  Serial.println(F("------  ----  ----   ------  ------  ------"));
-  
-  for (int i = 0; i < samples; i++) {
-    JoystickData joy = readJoystick();
-    
-    Serial.printf("%4d    %4d  %4d   %6.3f  %6.3f   %s\n",
-                  i + 1,
-                  joy.x,
-                  joy.y,
-                  joy.xNormalized,
-                  joy.yNormalized);
-//                  joy.buttonPressed ? "PRESS" : "REL");
-    
-    delay(100);
-  }
-  
-  Serial.println();
+  Serial.println(F("Sample    X     Y     X_norm  Y_norm"));
+  Serial.println(F("------  ----  ----   ------  ------"));
+}
+
+void printRawJoystickSample(int index) {
+  JoystickData joy = readJoystick();
+  
+  Serial.printf("%4d    %4d  %4d   %6.3f  %6.3f\n",
+                index + 1,
+                joy.x,
+                joy.y,
+                joy.xNormalized,
+                joy.yNormalized);
 }
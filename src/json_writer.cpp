@@ -0,0 +1,229 @@
+// ============================================================================
+// json_writer.cpp - Allocation-free streaming JSON writer
+// ============================================================================
+
+#include "json_writer.h"
+
+static const uint32_t powersOfTen[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+// ============================================================================
+// INTERNAL FUNCTIONS
+// ============================================================================
+
+static void put(JsonWriter* w, const char* text, size_t len) {
+  if (w->overflow) {
+    return;
+  }
+  if (w->len + len >= w->cap) {
+    w->overflow = true;
+    return;
+  }
+  memcpy(w->buf + w->len, text, len);
+  w->len += len;
+  w->buf[w->len] = '\0';
+}
+
+static void putChar(JsonWriter* w, char c) {
+  put(w, &c, 1);
+}
+
+// Digits of 'value' right-aligned in a small buffer; returns the start
+static char* formatUInt(uint64_t value, char* end) {
+  char* p = end;
+  do {
+    *--p = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+  return p;
+}
+
+// Quoted, escaped string with no separator handling
+static void putString(JsonWriter* w, const char* value) {
+  putChar(w, '"');
+
+  // Copy runs of plain characters in one go
+  const char* run = value;
+  for (const char* p = value; ; p++) {
+    uint8_t c = *p;
+    if (c != 0 && c != '"' && c != '\\' && c >= 0x20) {
+      continue;
+    }
+    put(w, run, p - run);
+    if (c == 0) {
+      break;
+    }
+    if (c == '"' || c == '\\') {
+      char esc[2] = {'\\', (char)c};
+      put(w, esc, 2);
+    } else {
+      static const char hex[] = "0123456789abcdef";
+      char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+      put(w, esc, 6);
+    }
+    run = p + 1;
+  }
+
+  putChar(w, '"');
+}
+
+// Comma and key before a value
+static void beginValue(JsonWriter* w, const char* key) {
+  uint16_t bit = 1u << w->depth;
+  if (w->hasItems & bit) {
+    putChar(w, ',');
+  }
+  w->hasItems |= bit;
+
+  if (key) {
+    putString(w, key);
+    putChar(w, ':');
+  }
+}
+
+static void openContainer(JsonWriter* w, const char* key, char open) {
+  beginValue(w, key);
+  putChar(w, open);
+  if (w->depth + 1 < JSON_MAX_DEPTH) {
+    w->depth++;
+    w->hasItems &= ~(1u << w->depth);
+  } else {
+    w->overflow = true;
+  }
+}
+
+static void closeContainer(JsonWriter* w, char close) {
+  if (w->depth > 0) {
+    w->depth--;
+  }
+  putChar(w, close);
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+void jsonBegin(JsonWriter* w, char* buf, size_t cap) {
+  w->buf = buf;
+  w->cap = cap;
+  w->len = 0;
+  w->overflow = (cap == 0);
+  w->depth = 0;
+  w->hasItems = 0;
+  if (cap) {
+    buf[0] = '\0';
+  }
+}
+
+void jsonObjectBegin(JsonWriter* w, const char* key) {
+  openContainer(w, key, '{');
+}
+
+void jsonObjectEnd(JsonWriter* w) {
+  closeContainer(w, '}');
+}
+
+void jsonArrayBegin(JsonWriter* w, const char* key) {
+  openContainer(w, key, '[');
+}
+
+void jsonArrayEnd(JsonWriter* w) {
+  closeContainer(w, ']');
+}
+
+void jsonString(JsonWriter* w, const char* key, const char* value) {
+  beginValue(w, key);
+  putString(w, value);
+}
+
+void jsonBool(JsonWriter* w, const char* key, bool value) {
+  beginValue(w, key);
+  if (value) {
+    put(w, "true", 4);
+  } else {
+    put(w, "false", 5);
+  }
+}
+
+void jsonNull(JsonWriter* w, const char* key) {
+  beginValue(w, key);
+  put(w, "null", 4);
+}
+
+void jsonUInt(JsonWriter* w, const char* key, uint32_t value) {
+  beginValue(w, key);
+  char digits[12];
+  char* end = digits + sizeof(digits);
+  char* start = formatUInt(value, end);
+  put(w, start, end - start);
+}
+
+void jsonInt(JsonWriter* w, const char* key, int32_t value) {
+  beginValue(w, key);
+  char digits[12];
+  char* end = digits + sizeof(digits);
+  char* start = formatUInt(value < 0 ? -(int64_t)value : value, end);
+  if (value < 0) {
+    *--start = '-';
+  }
+  put(w, start, end - start);
+}
+
+void jsonFixed(JsonWriter* w, const char* key, double value, uint8_t decimals) {
+  char digits[32];
+  size_t len = formatFixed(digits, sizeof(digits), value, decimals);
+  if (len == 0) {
+    jsonNull(w, key);
+    return;
+  }
+  beginValue(w, key);
+  put(w, digits, len);
+}
+
+void jsonRaw(JsonWriter* w, const char* text) {
+  put(w, text, strlen(text));
+}
+
+size_t jsonLength(const JsonWriter* w) {
+  return w->overflow ? 0 : w->len;
+}
+
+size_t formatFixed(char* out, size_t outSize, double value, uint8_t decimals) {
+  if (isnan(value) || isinf(value)) {
+    return 0;
+  }
+  if (decimals > 6) {
+    decimals = 6;
+  }
+
+  bool negative = value < 0;
+  double scaled = (negative ? -value : value) * powersOfTen[decimals] + 0.5;
+  if (scaled >= 1.8e19) {
+    return 0;  // Out of fixed-point range
+  }
+  uint64_t fixed = (uint64_t)scaled;
+
+  // Integer part, point, zero-padded fraction, built right to left
+  char digits[32];
+  char* end = digits + sizeof(digits);
+  char* p = end;
+  if (decimals) {
+    uint32_t frac = fixed % powersOfTen[decimals];
+    for (uint8_t i = 0; i < decimals; i++) {
+      *--p = '0' + (frac % 10);
+      frac /= 10;
+    }
+    *--p = '.';
+  }
+  p = formatUInt(fixed / powersOfTen[decimals], p);
+  if (negative && fixed != 0) {
+    *--p = '-';
+  }
+
+  size_t len = end - p;
+  if (len >= outSize) {
+    return 0;
+  }
+  memcpy(out, p, len);
+  out[len] = '\0';
+  return len;
+}
@@ -3,27 +3,62 @@
 // ============================================================================
 
 #include "led_module.h"
+#include "shared_data.h"
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
 
 // LED configuration
 #define NUM_LEDS 24
+#define LED_MAX_LEDS 50           // Largest ring the render buffers are sized for
 #define LED_BRIGHTNESS_DEFAULT 8  // 0-255, 50% brightness
+#define LED_GAMMA 2.2f            // Perceptual gamma applied before brightness
+#define LED_DITHER_STEPS 4        // Temporal dither cycle length (see ditherOrder)
+#define LED_RESET_US 60           // WS2812 latch time (>50μs low)
+#define LED_FRAME_BUDGET_US 200   // CPU budget per frame (render + encode)
+#define LED_MAX_FRAME_STEP_MS 250 // Clamp on animation step after a stall
+#define LED_BENCH_FRAMES 200      // Frames rendered per benchmark size
+#define LED_TEST_HOLD_TICKS 20    // LEDTEST: ticks per solid colour (1 s)
+#define LED_TEST_SLOW_TICKS 4     // LEDTEST: ticks per LED in the slow chase
+#define LED_TEST_RELEASE_MS 500   // LEDTEST stopped early: resume rendering
+
+// Pointing indicator geometry
+#define LED_RING_AZ_OFFSET 0.0f   // Azimuth of LED 0 (degrees)
+#define LED_RING_CLOCKWISE true   // LED index increases clockwise seen from above
+#define LED_ERROR_FULL_SCALE 10.0f // Pointing error shown as full red (degrees)
 
 // PIO configuration
 static PIO led_pio = pio1;  // Use PIO1 (PIO0 used by encoders)
-static uint led_sm = 0;      // State machine 0
-
-// LED buffer (GRB format for WS2812)
+static uint led_sm = 0;      // Claimed in initLEDs() (PIO1 is shared with the input debouncer)
+static int led_dma = -1;     // DMA channel feeding the TX FIFO
+static uint32_t ledFrameUs = 0;   // Wire time of one frame plus latch
+static uint32_t lastPushUs = 0;
+
+// Frame cost statistics (CPU time spent rendering and encoding)
+static uint32_t lastFrameCostUs = 0;
+static uint32_t maxFrameCostUs = 0;
+static uint32_t frameOverruns = 0;
+
+// LED buffers: composited colours, user colours for LED_MODE_CUSTOM, and
+// the encoded FIFO words (GRB format for WS2812, bit-reversed) last sent
+static RGBColor ledColors[NUM_LEDS];
+static RGBColor customColors[NUM_LEDS];
 static uint32_t ledBuffer[NUM_LEDS];
 static uint8_t globalBrightness = LED_BRIGHTNESS_DEFAULT;
-static LEDMode currentMode = LED_MODE_STEADY_GREEN;
 
 // Animation state
-static unsigned long lastUpdate = 0;
-static bool flashState = false;
-static uint16_t animationFrame = 0;
+static unsigned long lastFrameMs = 0;
+static bool frameDirty = true;   // Push next frame even if unchanged
+static bool testActive = false;  // LEDTEST owns the ring
+static unsigned long testTickMs = 0;
 static float clockDiv = 18.0f;  // gives ~1.2μs per bit
 
+// Frame generation lookup tables
+enum { LED_CH_G = 0, LED_CH_R, LED_CH_B };
+static uint16_t levelLUT[256];        // gamma * brightness, 8.8 fixed point
+static uint32_t encodeLUT[3][256];    // bit-reversed level placed in FIFO word
+static uint8_t ditherFrame = 0;
+static bool ditherActive = false;     // last frame had fractional levels
+
 // ============================================================================
 // WS2812 PIO PROGRAM
 // ============================================================================
@@ -102,21 +137,6 @@ static inline void ws2812_program_init(PIO pio, uint sm, uint offset, uint pin,
 // ============================================================================
 // LOW-LEVEL LED FUNCTIONS
 // ============================================================================
-uint8_t reverse_byte(uint8_t b);
-// Apply gamma correction and brightness
-static uint32_t applyBrightness(uint32_t r, uint32_t g, uint32_t b) {
-  // Apply brightness
-  r = (r * globalBrightness) / 255;
-  g = (g * globalBrightness) / 255;
-  b = (b * globalBrightness) / 255;
-
-  g = reverse_byte(g);
-  r = reverse_byte(r);
-  b = reverse_byte(b);
-
-  // WS2812 uses GRB format, but fifo is shifted out LSB first, so we arrange as BGR
-  return (b << 16) | (r << 8) | g;
-}
 
 // Reverse bits in a byte
 uint8_t reverse_byte(uint8_t b) {
@@ -126,12 +146,106 @@ uint8_t reverse_byte(uint8_t b) {
     return b;
 }
 
-// Send data to LEDs via PIO
+// Rebuild the level table for the current brightness. Each entry holds the
+// gamma-corrected, brightness-scaled output level in 8.8 fixed point; the
+// fractional byte is what temporal dithering spreads across frames.
+static void rebuildLevelLUT() {
+  for (int i = 0; i < 256; i++) {
+    float level = powf(i / 255.0f, LED_GAMMA) * globalBrightness;
+    levelLUT[i] = (uint16_t)(level * 256.0f + 0.5f);
+  }
+}
+
+// Build the per-channel encode tables (bit reversal plus position in the
+// FIFO word). These never change, so they are filled once at init.
+static void buildEncodeLUT() {
+  for (int i = 0; i < 256; i++) {
+    uint32_t rev = reverse_byte((uint8_t)i);
+    // WS2812 uses GRB format, but fifo is shifted out LSB first, so we arrange as BGR
+    encodeLUT[LED_CH_G][i] = rev;
+    encodeLUT[LED_CH_R][i] = rev << 8;
+    encodeLUT[LED_CH_B][i] = rev << 16;
+  }
+}
+
+// Encode one pixel into a FIFO word. 'threshold' is the dither offset for
+// this pixel in this frame (0-255); levelLUT never exceeds 255 << 8, so the
+// sum cannot overflow 16 bits.
+static inline uint32_t encodePixel(RGBColor c, uint8_t threshold) {
+  return encodeLUT[LED_CH_G][(uint16_t)(levelLUT[c.g] + threshold) >> 8] |
+         encodeLUT[LED_CH_R][(uint16_t)(levelLUT[c.r] + threshold) >> 8] |
+         encodeLUT[LED_CH_B][(uint16_t)(levelLUT[c.b] + threshold) >> 8];
+}
+
+// True if any channel of the colour falls between two output levels
+static inline bool needsDither(RGBColor c) {
+  return ((levelLUT[c.r] | levelLUT[c.g] | levelLUT[c.b]) & 0xFF) != 0;
+}
+
+// Threshold order within a dither cycle, bit-reversed so a level is
+// spread over the cycle: 50 % alternates every frame instead of two on,
+// two off
+static const uint8_t ditherOrder[LED_DITHER_STEPS] = {0, 2, 1, 3};
+
+// Convert colours to FIFO words. The dither threshold cycles through
+// LED_DITHER_STEPS evenly spaced values, with a per-LED phase so the ring
+// as a whole does not pulse. Returns true if any LED needed dithering.
+static bool encodeColors(const RGBColor* colors, uint32_t* words, int count) {
+  bool dither = false;
+  for (int i = 0; i < count; i++) {
+    uint8_t step = ditherOrder[(ditherFrame + i) & (LED_DITHER_STEPS - 1)];
+    uint8_t threshold = (uint8_t)(step * (256 / LED_DITHER_STEPS) + (128 / LED_DITHER_STEPS));
+    words[i] = encodePixel(colors[i], threshold);
+    dither |= needsDither(colors[i]);
+  }
+  return dither;
+}
+
+// Encode the colour buffer for this frame
+static void encodeFrame() {
+  ditherActive = encodeColors(ledColors, ledBuffer, NUM_LEDS);
+  ditherFrame++;
+}
+
+// Send data to LEDs via DMA into the PIO TX FIFO. The CPU only encodes the
+// frame; the transfer runs in the background. ledBuffer must not change
+// while the previous frame is still going out, and the next frame must not
+// start before the previous one has latched.
 static void pushToLEDs() {
+  dma_channel_wait_for_finish_blocking(led_dma);
+  encodeFrame();
+  
+  uint32_t elapsed = micros() - lastPushUs;
+  if (elapsed < ledFrameUs) {
+    delayMicroseconds(ledFrameUs - elapsed);
+  }
+  
+  lastPushUs = micros();
+  dma_channel_transfer_from_buffer_now(led_dma, ledBuffer, NUM_LEDS);
+}
+
+// Set up the DMA channel that feeds the WS2812 state machine
+static void setupLEDDMA() {
+  led_dma = dma_claim_unused_channel(true);
+  
+  dma_channel_config c = dma_channel_get_default_config(led_dma);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, pio_get_dreq(led_pio, led_sm, true));
+  
+  dma_channel_configure(led_dma, &c, &led_pio->txf[led_sm], ledBuffer, NUM_LEDS, false);
+  
+  // 24 bits per LED, 10 PIO cycles per bit
+  float bitUs = 10.0f * clockDiv / (clock_get_hz(clk_sys) / 1000000.0f);
+  ledFrameUs = (uint32_t)(NUM_LEDS * 24 * bitUs) + LED_RESET_US;
+}
+
+// Fill the whole colour buffer
+static void fillLEDs(RGBColor color) {
   for (int i = 0; i < NUM_LEDS; i++) {
-      pio_sm_put_blocking(led_pio, led_sm, ledBuffer[i]);
+    ledColors[i] = color;
   }
-  delayMicroseconds(60);  // RES time >50μs}
 }
 
 // ============================================================================
@@ -150,41 +264,126 @@ RGBColor colorPurple() { return {220, 0, 255}; }
 RGBColor colorOff() { return {0, 0, 0}; }
 
 // ============================================================================
-// ANIMATION FUNCTIONS
+// ANIMATION ENGINE
 // ============================================================================
+// Each layer runs one program: either a keyframe list (one colour for the
+// whole ring, held or faded between keyframes) or a procedural renderer
+// that fills per-LED colour and coverage. Programs are advanced by the
+// frame step, never by polling millis(), and the layers are composited
+// bottom to top (status, pointer, alert) with integer alpha blending.
+
+// Layer pixel: premultiplied colour plus coverage (0 = transparent)
+struct LEDPixel {
+  uint8_t r, g, b, a;
+};
 
-void animateSteadyGreen() {
-  RGBColor green = colorGreen();
-  for (int i = 0; i < NUM_LEDS; i++) {
-    ledBuffer[i] = applyBrightness(green.r, green.g, green.b);
-  }
+// Keyframe interpolation to the next keyframe
+enum { KF_STEP = 0, KF_LINEAR };
+
+struct LEDKeyframe {
+  uint16_t timeMs;    // Offset within the program period
+  RGBColor color;
+  uint8_t alpha;
+  uint8_t interp;
+};
+
+typedef void (*LEDRenderFunc)(LEDPixel* out, int count, uint32_t timeMs);
+
+struct LEDProgram {
+  const LEDKeyframe* keyframes;  // Keyframe program...
+  uint8_t keyframeCount;
+  uint16_t periodMs;             // Loop length (0 = free running)
+  LEDRenderFunc render;          // ...or procedural program
+};
+
+struct LEDLayerState {
+  LEDMode mode;
+  uint32_t timeMs;               // Position within the program
+};
+
+static LEDLayerState layers[LED_LAYER_COUNT];
+static LEDPixel layerPixels[LED_MAX_LEDS];   // Scratch for procedural layers
+
+// Alpha 0-255 to a 0-256 blend weight, exact at both ends
+static inline uint16_t alphaWeight(uint8_t a) {
+  return a + (a >> 7);
 }
 
-void animateFlashRed() {
-  RGBColor color = flashState ? colorRed() : colorOff();
-  for (int i = 0; i < NUM_LEDS; i++) {
-    ledBuffer[i] = applyBrightness(color.r, color.g, color.b);
-  }
+static inline uint8_t lerp8(uint8_t from, uint8_t to, uint16_t w) {
+  return from + ((((int)to - from) * w) >> 8);
 }
 
-void animateFlashYellow() {
-  RGBColor color = flashState ? colorYellow() : colorOff();
-  for (int i = 0; i < NUM_LEDS; i++) {
-    ledBuffer[i] = applyBrightness(color.r, color.g, color.b);
+// Composite one premultiplied pixel over an output colour
+static inline void blendPixel(RGBColor& dst, LEDPixel src) {
+  uint16_t keep = 256 - alphaWeight(src.a);
+  dst.r = (uint8_t)min(255, src.r + ((dst.r * keep) >> 8));
+  dst.g = (uint8_t)min(255, src.g + ((dst.g * keep) >> 8));
+  dst.b = (uint8_t)min(255, src.b + ((dst.b * keep) >> 8));
+}
+
+// Add a colour with coverage weight/256 to a layer pixel (markers may overlap)
+static void addToPixel(LEDPixel& px, RGBColor color, uint16_t weight) {
+  px.r = (uint8_t)min(255, px.r + ((color.r * weight) >> 8));
+  px.g = (uint8_t)min(255, px.g + ((color.g * weight) >> 8));
+  px.b = (uint8_t)min(255, px.b + ((color.b * weight) >> 8));
+  px.a = (uint8_t)min(255, px.a + weight);
+}
+
+// Evaluate a keyframe program at a point in its period
+static LEDPixel evalKeyframes(const LEDProgram* prog, uint32_t t) {
+  uint8_t k = 0;
+  while (k + 1 < prog->keyframeCount && prog->keyframes[k + 1].timeMs <= t) {
+    k++;
+  }
+  
+  const LEDKeyframe& from = prog->keyframes[k];
+  RGBColor c = from.color;
+  uint8_t a = from.alpha;
+  
+  if (from.interp == KF_LINEAR && prog->keyframeCount > 1) {
+    bool last = (k + 1 == prog->keyframeCount);
+    const LEDKeyframe& to = prog->keyframes[last ? 0 : k + 1];
+    uint32_t span = (last ? prog->periodMs : to.timeMs) - from.timeMs;
+    uint16_t w = span ? (uint16_t)(((t - from.timeMs) << 8) / span) : 0;
+    c.r = lerp8(c.r, to.color.r, w);
+    c.g = lerp8(c.g, to.color.g, w);
+    c.b = lerp8(c.b, to.color.b, w);
+    a = lerp8(a, to.alpha, w);
   }
+  
+  uint16_t aw = alphaWeight(a);
+  return {(uint8_t)((c.r * aw) >> 8), (uint8_t)((c.g * aw) >> 8), (uint8_t)((c.b * aw) >> 8), a};
 }
 
-void animateFlashBlue() {
-  RGBColor color = flashState ? colorBlue() : colorOff();
-  for (int i = 0; i < NUM_LEDS; i++) {
-    ledBuffer[i] = applyBrightness(color.r, color.g, color.b);
+// Map an azimuth onto a ring of 'count' LEDs as a fixed-point LED position
+// (8 fractional bits)
+static uint32_t azimuthToRingPos(float azimuth, int count) {
+  float rel = azimuth - LED_RING_AZ_OFFSET;
+  if (!LED_RING_CLOCKWISE) {
+    rel = -rel;
   }
+  rel = fmodf(rel, 360.0f);
+  if (rel < 0) rel += 360.0f;
+  return (uint32_t)(rel * (count * 256) / 360.0f) % (count * 256);
 }
 
-void animateRainbow() {
-  for (int i = 0; i < NUM_LEDS; i++) {
-    // Create rainbow effect
-    uint16_t hue = (animationFrame + (i * 65536 / NUM_LEDS)) & 0xFFFF;
+// Draw a marker split between the two nearest LEDs, so it moves smoothly
+// instead of jumping one LED (15° on 24 LEDs) at a time
+static void drawRingMarker(LEDPixel* out, int count, uint32_t pos, RGBColor color) {
+  int i0 = pos >> 8;
+  int i1 = (i0 + 1) % count;
+  uint16_t w1 = pos & 0xFF;
+  addToPixel(out[i0], color, 256 - w1);
+  addToPixel(out[i1], color, w1);
+}
+
+// ---- Procedural programs ----
+
+// Rotating hue wheel, one turn per program period
+static void renderRainbow(LEDPixel* out, int count, uint32_t timeMs) {
+  uint16_t base = (uint16_t)((timeMs * 65536UL) / 12800);
+  for (int i = 0; i < count; i++) {
+    uint16_t hue = base + (uint16_t)(i * 65536UL / count);
     
     // Simple HSV to RGB conversion (hue only, full saturation and value)
     uint8_t sector = hue >> 13;  // 0-7
@@ -200,11 +399,145 @@ void animateRainbow() {
       case 5: r = 255; g = 0; b = 255-offset; break;
       case 6: r = 255; g = offset; b = 0; break;
       case 7: r = 255-offset; g = 255; b = 0; break;
+      default: r = 0; g = 0; b = 0; break;
+    }
+    
+    out[i] = {r, g, b, 255};
+  }
+}
+
+// Live pointing indicator, rendered from the shared pose snapshot:
+//   antenna  - encoder azimuth, green when on target fading to red at
+//              LED_ERROR_FULL_SCALE degrees of error
+//   satellite - current azimuth in blue, brighter the higher it is
+//   next AOS  - dim magenta while the satellite is below the horizon
+// LEDs without a marker stay transparent so the status colour shows.
+static void renderPointing(LEDPixel* out, int count, uint32_t timeMs) {
+  PoseSnapshot pose;
+  getPoseSnapshot(&pose);
+  
+  memset(out, 0, count * sizeof(LEDPixel));
+  
+  if (pose.satellite.valid) {
+    if (pose.satellite.elevation >= 0) {
+      float el = constrain(pose.satellite.elevation, 0.0f, 90.0f);
+      uint8_t v = 64 + (uint8_t)(191.0f * el / 90.0f);
+      drawRingMarker(out, count, azimuthToRingPos(pose.satellite.azimuth, count), RGB(0, v / 2, v));
+    } else if (pose.satellite.aosValid) {
+      drawRingMarker(out, count, azimuthToRingPos(pose.satellite.aosAzimuth, count), RGB(96, 0, 96));
+    }
+  }
+  
+  float error = max(fabsf(pose.antenna.errorAz), fabsf(pose.antenna.errorEl));
+  float t = constrain(error / LED_ERROR_FULL_SCALE, 0.0f, 1.0f);
+  drawRingMarker(out, count, azimuthToRingPos(pose.antenna.azimuth, count),
+                 RGB((uint8_t)(255 * t), (uint8_t)(255 * (1.0f - t)), 0));
+}
+
+// User colours set with setLED()/setAllLEDs()
+static void renderCustom(LEDPixel* out, int count, uint32_t timeMs) {
+  for (int i = 0; i < count; i++) {
+    RGBColor c = customColors[i % NUM_LEDS];
+    out[i] = {c.r, c.g, c.b, 255};
+  }
+}
+
+// ---- Keyframe programs ----
+
+static const LEDKeyframe kfSteadyGreen[] = {
+  {0, {0, 255, 0}, 255, KF_STEP}
+};
+
+static const LEDKeyframe kfSteadyPurple[] = {
+  {0, {220, 0, 255}, 255, KF_STEP}
+};
+
+static const LEDKeyframe kfFlashRed[] = {
+  {0, {255, 0, 0}, 255, KF_STEP},
+  {500, {0, 0, 0}, 255, KF_STEP}
+};
+
+static const LEDKeyframe kfFlashYellow[] = {
+  {0, {255, 255, 0}, 255, KF_STEP},
+  {500, {0, 0, 0}, 255, KF_STEP}
+};
+
+static const LEDKeyframe kfFlashBlue[] = {
+  {0, {0, 0, 255}, 255, KF_STEP},
+  {500, {0, 0, 0}, 255, KF_STEP}
+};
+
+// Program for each LEDMode, indexed by mode
+static const LEDProgram ledPrograms[] = {
+  {nullptr, 0, 0, nullptr},           // LED_MODE_OFF
+  {kfSteadyGreen, 1, 0, nullptr},     // LED_MODE_STEADY_GREEN
+  {kfSteadyPurple, 1, 0, nullptr},    // LED_MODE_STEADY_PURPLE
+  {kfFlashRed, 2, 1000, nullptr},     // LED_MODE_FLASH_RED
+  {kfFlashYellow, 2, 1000, nullptr},  // LED_MODE_FLASH_YELLOW
+  {kfFlashBlue, 2, 1000, nullptr},    // LED_MODE_FLASH_BLUE
+  {nullptr, 0, 12800, renderRainbow}, // LED_MODE_RAINBOW
+  {nullptr, 0, 0, renderPointing},    // LED_MODE_POINTING
+  {nullptr, 0, 0, renderCustom}       // LED_MODE_CUSTOM
+};
+static_assert(sizeof(ledPrograms) / sizeof(ledPrograms[0]) == LED_MODE_CUSTOM + 1,
+              "ledPrograms must have one entry per LEDMode");
+
+// Step every layer by 'stepMs' and composite them into 'out'
+static void renderLayers(RGBColor* out, int count, uint32_t stepMs) {
+  memset(out, 0, count * sizeof(RGBColor));
+  
+  for (int l = 0; l < LED_LAYER_COUNT; l++) {
+    LEDLayerState& layer = layers[l];
+    const LEDProgram* prog = &ledPrograms[layer.mode];
+    if (!prog->keyframes && !prog->render) {
+      continue;
+    }
+    
+    layer.timeMs += stepMs;
+    if (prog->periodMs) {
+      layer.timeMs %= prog->periodMs;
     }
     
-    ledBuffer[i] = applyBrightness(r, g, b);
+    if (prog->render) {
+      prog->render(layerPixels, count, layer.timeMs);
+      for (int i = 0; i < count; i++) {
+        if (layerPixels[i].a) {
+          blendPixel(out[i], layerPixels[i]);
+        }
+      }
+    } else {
+      LEDPixel px = evalKeyframes(prog, layer.timeMs);
+      if (px.a) {
+        for (int i = 0; i < count; i++) {
+          blendPixel(out[i], px);
+        }
+      }
+    }
+  }
+}
+
+static const char* ledModeName(LEDMode mode) {
+  switch(mode) {
+    case LED_MODE_OFF: return "OFF";
+    case LED_MODE_STEADY_GREEN: return "STEADY_GREEN";
+    case LED_MODE_STEADY_PURPLE: return "STEADY_PURPLE";
+    case LED_MODE_FLASH_RED: return "FLASH_RED";
+    case LED_MODE_FLASH_YELLOW: return "FLASH_YELLOW";
+    case LED_MODE_FLASH_BLUE: return "FLASH_BLUE";
+    case LED_MODE_RAINBOW: return "RAINBOW";
+    case LED_MODE_POINTING: return "POINTING";
+    case LED_MODE_CUSTOM: return "CUSTOM";
+    default: return "UNKNOWN";
+  }
+}
+
+static const char* ledLayerName(LEDLayer layer) {
+  switch(layer) {
+    case LED_LAYER_STATUS: return "status";
+    case LED_LAYER_POINTER: return "pointer";
+    case LED_LAYER_ALERT: return "alert";
+    default: return "unknown";
   }
-  animationFrame += 256;  // Rotate hue
 }
 
 // ============================================================================
@@ -223,14 +556,19 @@ void initLEDs() {  Serial.println("Initializing WS2812 LED ring...");
   Serial.println(offset);
   
   // Initialize PIO for WS2812 (800kHz)
+  led_sm = pio_claim_unused_sm(led_pio, true);
   ws2812_program_init(led_pio, led_sm, offset, LED_DATA_PIN, 800000);
   Serial.print("PIO initialized on pin: ");
   Serial.println(LED_DATA_PIN);
   
+  setupLEDDMA();
+  
+  // Build lookup tables before the first frame
+  buildEncodeLUT();
+  rebuildLevelLUT();
+  
   // Clear LED buffer
-  for (int i = 0; i < NUM_LEDS; i++) {
-    ledBuffer[i] = 0x0;
-  }
+  fillLEDs(colorOff());
   pushToLEDs();
   delayMicroseconds(10);
 
@@ -239,30 +577,41 @@ void initLEDs() {  Serial.println("Initializing WS2812 LED ring...");
   Serial.printf("  Data pin: GPIO %d\n", LED_DATA_PIN);
   Serial.printf("  PIO: %d, SM: %d\n", led_pio == pio0 ? 0 : 1, led_sm);
 
-  currentMode = LED_MODE_STEADY_GREEN;  // Initial mode
+  // Initial layer programs
+  for (int l = 0; l < LED_LAYER_COUNT; l++) {
+    layers[l].mode = LED_MODE_OFF;
+    layers[l].timeMs = 0;
+  }
+  layers[LED_LAYER_STATUS].mode = LED_MODE_STEADY_GREEN;
+  lastFrameMs = millis();
+  frameDirty = true;
 }
 
-void setLEDMode(LEDMode mode) {
-  if (currentMode != mode) {
-    currentMode = mode;
-    lastUpdate = 0;  // Force immediate update
-    flashState = false;
-    animationFrame = 0;
-    Serial.print("LED mode: ");
-    switch(mode) {
-      case LED_MODE_OFF: Serial.println("OFF"); break;
-      case LED_MODE_STEADY_GREEN: Serial.println("STEADY GREEN"); break;
-      case LED_MODE_FLASH_RED: Serial.println("FLASH RED"); break;
-      case LED_MODE_FLASH_YELLOW: Serial.println("FLASH YELLOW"); break;
-      case LED_MODE_FLASH_BLUE: Serial.println("FLASH BLUE"); break;
-      case LED_MODE_RAINBOW: Serial.println("RAINBOW"); break;
-      case LED_MODE_CUSTOM: Serial.println("CUSTOM"); break;
-    }
+void setLEDLayerMode(LEDLayer layer, LEDMode mode) {
+  if (layer >= LED_LAYER_COUNT || mode > LED_MODE_CUSTOM) {
+    return;
+  }
+  if (layers[layer].mode != mode) {
+    layers[layer].mode = mode;
+    layers[layer].timeMs = 0;  // Start the program from its first keyframe
+    frameDirty = true;
+    Serial.printf("LED %s layer: %s\n", ledLayerName(layer), ledModeName(mode));
+  }
+}
+
+LEDMode getLEDLayerMode(LEDLayer layer) {
+  if (layer >= LED_LAYER_COUNT) {
+    return LED_MODE_OFF;
   }
+  return layers[layer].mode;
+}
+
+void setLEDMode(LEDMode mode) {
+  setLEDLayerMode(LED_LAYER_STATUS, mode);
 }
 
 LEDMode getLEDMode() {
-  return currentMode;
+  return layers[LED_LAYER_STATUS].mode;
 }
 
 uint32_t* getLEDBuffer() {
@@ -271,86 +620,58 @@ uint32_t* getLEDBuffer() {
 
 void updateLEDs() {
   unsigned long now = millis();
-  bool needUpdate = false;
+  uint32_t startUs = micros();
   
-  switch(currentMode) {
-    case LED_MODE_OFF:
-      if (now - lastUpdate >= 1000) {  // Update once per second
-        for (int i = 0; i < NUM_LEDS; i++) {
-          ledBuffer[i] = 0;
-        }
-        needUpdate = true;
-        lastUpdate = now;
-      }
-      break;
-      
-    case LED_MODE_STEADY_GREEN:
-      if (now - lastUpdate >= 1000) {  // Update once per second
-        animateSteadyGreen();
-        needUpdate = true;
-        lastUpdate = now;
-      }
-      break;
-      
-    case LED_MODE_FLASH_RED:
-      if (now - lastUpdate >= 500) {  // Flash at 1 Hz
-        flashState = !flashState;
-        animateFlashRed();
-        needUpdate = true;
-        lastUpdate = now;
-      }
-      break;
-      
-    case LED_MODE_FLASH_YELLOW:
-      if (now - lastUpdate >= 500) {  // Flash at 1 Hz
-        flashState = !flashState;
-        animateFlashYellow();
-        needUpdate = true;
-        lastUpdate = now;
-      }
-      break;
-      
-    case LED_MODE_FLASH_BLUE:
-      if (now - lastUpdate >= 500) {  // Flash at 1 Hz
-        flashState = !flashState;
-        animateFlashBlue();
-        needUpdate = true;
-        lastUpdate = now;
-      }
-      break;
-      
-    case LED_MODE_RAINBOW:
-      if (now - lastUpdate >= 50) {  // Update at 20 Hz
-        animateRainbow();
-        needUpdate = true;
-        lastUpdate = now;
-      }
-      break;
-      
-    case LED_MODE_CUSTOM:
-      // User controls, no automatic updates
-      break;
+  // Leave the test pattern alone until the test ends or stops ticking
+  if (testActive) {
+    if (now - testTickMs < LED_TEST_RELEASE_MS) {
+      return;
+    }
+    testActive = false;
+    frameDirty = true;
+  }
+  
+  // Animations advance by the time since the previous frame
+  uint32_t stepMs = now - lastFrameMs;
+  lastFrameMs = now;
+  if (stepMs > LED_MAX_FRAME_STEP_MS) {
+    stepMs = LED_MAX_FRAME_STEP_MS;
   }
   
-  if (needUpdate) {
+  RGBColor frame[NUM_LEDS];
+  renderLayers(frame, NUM_LEDS, stepMs);
+  bool changed = memcmp(frame, ledColors, sizeof(frame)) != 0;
+  
+  // Keep refreshing while dithering so fractional levels average out
+  if (changed || ditherActive || frameDirty) {
+    memcpy(ledColors, frame, sizeof(frame));
     pushToLEDs();
+    frameDirty = false;
+    
+    lastFrameCostUs = micros() - startUs;
+    if (lastFrameCostUs > maxFrameCostUs) maxFrameCostUs = lastFrameCostUs;
+    if (lastFrameCostUs > LED_FRAME_BUDGET_US) frameOverruns++;
   }
 }
 
 void setAllLEDs(RGBColor color) {
   for (int i = 0; i < NUM_LEDS; i++) {
-    ledBuffer[i] = applyBrightness(color.r, color.g, color.b);
+    customColors[i] = color;
   }
 }
 
 void setLED(uint8_t index, RGBColor color) {
   if (index < NUM_LEDS) {
-    ledBuffer[index] = applyBrightness(color.r, color.g, color.b);
+    customColors[index] = color;
   }
 }
 
 void setLEDBrightness(uint8_t brightness) {
-  globalBrightness = brightness;
+  if (brightness != globalBrightness) {
+    globalBrightness = brightness;
+    rebuildLevelLUT();
+    frameDirty = true;
+  }
 }
 
 uint8_t getLEDBrightness() {
@@ -358,69 +679,113 @@ uint8_t getLEDBrightness() {
 }
 
 void showLEDs() {
+  renderLayers(ledColors, NUM_LEDS, 0);
   pushToLEDs();
 }
 
-void testLEDs() {
-  Serial.println("\n=== LED Ring Test ===");
-  
-  int numLeds = NUM_LEDS;
-  
-  int brightness  = 255; // Full brightness for test
-  //int brightness  = globalBrightness; // Use current brightness
+int getLEDTestTicks() {
+  return 3 * LED_TEST_HOLD_TICKS + NUM_LEDS + NUM_LEDS * LED_TEST_SLOW_TICKS + 1;
+}
 
-  // Test 1: All red
-  Serial.println("Test 1: All LEDs red");
-  for (int i = 0; i < numLeds; i++) {
-    ledBuffer[i] = applyBrightness(brightness, 0, 0);
-  }
-  pushToLEDs();
-  delay(1000);
+void stepLEDTest(int tick) {
+  testActive = true;
+  testTickMs = millis();
   
-  // Test 2: All green
-  Serial.println("Test 2: All LEDs green");
-  for (int i = 0; i < numLeds; i++) {
-    ledBuffer[i] = applyBrightness(0, brightness, 0);
-  }
-  pushToLEDs();
-  delay(1000);
+  uint8_t brightness = 255; // Full brightness for test
   
-  // Test 3: All blue
-  Serial.println("Test 3: All LEDs blue");
-  for (int i = 0; i < numLeds; i++) {
-    ledBuffer[i] = applyBrightness(0, 0, brightness);
+  // Tests 1-3: all red, green, blue
+  if (tick < 3 * LED_TEST_HOLD_TICKS) {
+    if (tick % LED_TEST_HOLD_TICKS != 0) {
+      return;
+    }
+    static const char* const names[] = {"red", "green", "blue"};
+    int test = tick / LED_TEST_HOLD_TICKS;
+    if (test == 0) {
+      Serial.println("\n=== LED Ring Test ===");
+    }
+    Serial.printf("Test %d: All LEDs %s\n", test + 1, names[test]);
+    fillLEDs(RGB(test == 0 ? brightness : 0, test == 1 ? brightness : 0, test == 2 ? brightness : 0));
+    pushToLEDs();
+    return;
   }
-  pushToLEDs();
-  delay(1000);
+  tick -= 3 * LED_TEST_HOLD_TICKS;
   
-  // Test 4: Chase pattern
-  Serial.println("Test 4: Chase pattern");
-  for (int j = 0; j < numLeds; j++) {
-    for (int i = 0; i < numLeds; i++) {
-      ledBuffer[i] = (i == j) ? applyBrightness(brightness, brightness, brightness) : 0;
+  // Test 4: chase pattern, fast then slow
+  int pos = -1;
+  if (tick < NUM_LEDS) {
+    if (tick == 0) {
+      Serial.println("Test 4: Chase pattern");
     }
-    pushToLEDs();
-    delay(50);
+    pos = tick;
+  } else if (tick - NUM_LEDS < NUM_LEDS * LED_TEST_SLOW_TICKS) {
+    tick -= NUM_LEDS;
+    if (tick % LED_TEST_SLOW_TICKS != 0) {
+      return;
+    }
+    pos = tick / LED_TEST_SLOW_TICKS;
   }
-  for (int j = 0; j < numLeds; j++) {
-    for (int i = 0; i < numLeds; i++) {
-      ledBuffer[i] = (i == j) ? applyBrightness(brightness, brightness, brightness) : 0;
+  if (pos >= 0) {
+    for (int i = 0; i < NUM_LEDS; i++) {
+      ledColors[i] = (i == pos) ? RGB(brightness, brightness, brightness) : colorOff();
     }
     pushToLEDs();
-    delay(200);
+    return;
   }
-
-
+  
   // Test 5: All off
   Serial.println("Test 5: All LEDs off");
-  for (int i = 0; i < numLeds; i++) {
-    ledBuffer[i] = 0;
-  }
+  fillLEDs(colorOff());
   pushToLEDs();
   
+  testActive = false;
+  frameDirty = true;
   Serial.println("LED test complete");
 }
 
+void benchmarkLEDs() {
+  Serial.println(F("\n=== LED Frame Benchmark ==="));
+  Serial.println(F("Layers: status STEADY_GREEN, pointer POINTING, alert FLASH_RED"));
+  Serial.printf("Frames per size: %d, step %d ms\n", LED_BENCH_FRAMES, LED_UPDATE_MS);
+  Serial.println();
+  
+  // Run the engine on a representative three-layer stack, then restore
+  LEDLayerState saved[LED_LAYER_COUNT];
+  memcpy(saved, layers, sizeof(layers));
+  layers[LED_LAYER_STATUS] = {LED_MODE_STEADY_GREEN, 0};
+  layers[LED_LAYER_POINTER] = {LED_MODE_POINTING, 0};
+  layers[LED_LAYER_ALERT] = {LED_MODE_FLASH_RED, 0};
+  
+  static RGBColor colors[LED_MAX_LEDS];
+  static uint32_t words[LED_MAX_LEDS];
+  const int sizes[] = {NUM_LEDS, LED_MAX_LEDS};
+  
+  for (int s = 0; s < 2; s++) {
+    int count = sizes[s];
+    
+    uint32_t start = micros();
+    for (int f = 0; f < LED_BENCH_FRAMES; f++) {
+      renderLayers(colors, count, LED_UPDATE_MS);
+    }
+    uint32_t renderUs = micros() - start;
+    
+    start = micros();
+    for (int f = 0; f < LED_BENCH_FRAMES; f++) {
+      encodeColors(colors, words, count);
+    }
+    uint32_t encodeUs = micros() - start;
+    
+    Serial.printf("%2d LEDs: render %.1f us, encode %.1f us, total %.1f us/frame\n",
+                  count,
+                  (float)renderUs / LED_BENCH_FRAMES,
+                  (float)encodeUs / LED_BENCH_FRAMES,
+                  (float)(renderUs + encodeUs) / LED_BENCH_FRAMES);
+  }
+  
+  memcpy(layers, saved, sizeof(layers));
+  frameDirty = true;
+  Serial.println();
+}
+
 void printLedStatus() {
   Serial.println(F("\n=== LED Ring Status ==="));
   Serial.print("Brightness: ");
@@ -428,18 +793,11 @@ void printLedStatus() {
   Serial.print("Buffer[0]: 0x");
   uint32_t bufferZero = getLEDBuffer()[0];
   Serial.println(bufferZero, HEX);
-    Serial.print(F("Current mode: "));
-    Serial.println((int)getLEDMode());
-    Serial.print(F("Mode name: "));
-    switch(getLEDMode()) {
-      case LED_MODE_OFF: Serial.println(F("OFF")); break;
-      case LED_MODE_STEADY_GREEN: Serial.println(F("STEADY_GREEN")); break;
-      case LED_MODE_STEADY_PURPLE: Serial.println(F("STEADY_PURPLE")); break;
-      case LED_MODE_FLASH_RED: Serial.println(F("FLASH_RED")); break;
-      case LED_MODE_FLASH_YELLOW: Serial.println(F("FLASH_YELLOW")); break;
-      case LED_MODE_FLASH_BLUE: Serial.println(F("FLASH_BLUE")); break;
-      case LED_MODE_RAINBOW: Serial.println(F("RAINBOW")); break;
-      default: Serial.println(F("UNKNOWN")); break;
-    }
-    Serial.println();
+  for (int l = 0; l < LED_LAYER_COUNT; l++) {
+    LEDMode mode = getLEDLayerMode((LEDLayer)l);
+    Serial.printf("Layer %-8s %d (%s)\n", ledLayerName((LEDLayer)l), (int)mode, ledModeName(mode));
+  }
+  Serial.printf("Frame cost: last %lu us, max %lu us (budget %d us, %lu over)\n",
+                lastFrameCostUs, maxFrameCostUs, LED_FRAME_BUDGET_US, frameOverruns);
+  Serial.println();
 }
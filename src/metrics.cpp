@@ -0,0 +1,314 @@
+// ============================================================================
+// metrics.cpp - Metrics registry and Prometheus text export
+// ============================================================================
+
+#include "metrics.h"
+#include <malloc.h>
+#include "json_writer.h"
+#include "gps_module.h"
+#include "http_server.h"
+
+volatile uint32_t metricValues[METRIC_COUNT];
+MetricHistogramData metricHistograms[HISTOGRAM_COUNT];
+
+static const uint32_t controlJitterBounds[] = {50, 100, 250, 500, 1000, 2500, 5000, 10000};
+static const uint32_t httpLatencyBounds[] = {1000, 5000, 10000, 25000, 50000, 100000, 250000, 1000000};
+
+const uint32_t* const metricHistogramBounds[HISTOGRAM_COUNT] = {
+  controlJitterBounds,
+  httpLatencyBounds
+};
+
+const uint8_t metricHistogramBucketCount[HISTOGRAM_COUNT] = {
+  sizeof(controlJitterBounds) / sizeof(uint32_t),
+  sizeof(httpLatencyBounds) / sizeof(uint32_t)
+};
+
+// Stack painting (pico-sdk linker symbols for the per-core stacks)
+extern uint32_t __StackBottom;
+extern uint32_t __StackOneBottom;
+
+#define STACK_PAINT 0xA5A5A5A5
+#define STACK_PAINT_MARGIN 256     // Bytes left below the caller's frame
+#define STACK_MAX_PAINT 8192       // Refuse to paint anything larger
+
+static uint32_t* stackBottom[2] = {nullptr, nullptr};
+static uint32_t* stackPaintTop[2] = {nullptr, nullptr};
+
+// ============================================================================
+// METRIC DEFINITIONS
+// ============================================================================
+
+typedef enum {
+  METRIC_TYPE_COUNTER = 0,
+  METRIC_TYPE_GAUGE
+} MetricType;
+
+typedef int32_t (*MetricSampler)();
+
+struct MetricDef {
+  const char* name;
+  const char* labels;      // "" or key="value"
+  MetricType type;
+  uint8_t decimals;        // Raw value is in units of 10^-decimals
+  int8_t id;               // MetricId, or -1 if sampled at scrape time
+  MetricSampler sample;
+  const char* help;
+};
+
+struct HistogramDef {
+  const char* name;
+  uint8_t decimals;        // Bounds and sum in units of 10^-decimals
+  const char* help;
+};
+
+// Whole seconds from the 64-bit microsecond timer: millis() would go
+// negative in a signed gauge after 24.8 days and wrap after 49.7
+static int32_t sampleUptime() {
+  return (int32_t)(time_us_64() / 1000000ULL);
+}
+
+static int32_t sampleGpsFix() {
+  return trackerState.gpsValid ? 1 : 0;
+}
+
+static int32_t sampleGpsFixAge() {
+  return getGpsFixAgeMs();
+}
+
+static int32_t sampleHeapFree() {
+  return rp2040.getFreeHeap();
+}
+
+// Never-used space above the arena plus the free top chunk. Holes inside
+// the arena may be larger, so this is a lower bound.
+static int32_t sampleHeapLargest() {
+  struct mallinfo info = mallinfo();
+  return rp2040.getTotalHeap() - info.arena + info.keepcost;
+}
+
+static int32_t stackFree(int core) {
+  uint32_t* p = stackBottom[core];
+  if (!p) {
+    return -1;
+  }
+  while (p < stackPaintTop[core] && *p == STACK_PAINT) {
+    p++;
+  }
+  return (p - stackBottom[core]) * sizeof(uint32_t);
+}
+
+static int32_t sampleStackCore0() {
+  return stackFree(0);
+}
+
+static int32_t sampleStackCore1() {
+  return stackFree(1);
+}
+
+static const MetricDef metricDefs[] = {
+  {"tracker_uptime_seconds", "", METRIC_TYPE_GAUGE, 0, -1, sampleUptime,
+   "Time since boot"},
+  {"tracker_control_loop_iterations_total", "", METRIC_TYPE_COUNTER, 0, METRIC_CONTROL_LOOPS, nullptr,
+   "Motor control loop iterations"},
+  {"tracker_tracking_error_rms_degrees", "", METRIC_TYPE_GAUGE, 3, METRIC_TRACKING_ERROR_RMS, nullptr,
+   "RMS pointing error over the current or last tracked pass"},
+  {"tracker_passes_tracked_total", "", METRIC_TYPE_COUNTER, 0, METRIC_PASSES_TRACKED, nullptr,
+   "Satellite passes tracked above the horizon"},
+  {"tracker_encoder_invalid_transitions_total", "axis=\"el\"", METRIC_TYPE_COUNTER, 0, METRIC_ENCODER_INVALID_EL, nullptr,
+   "Quadrature samples where both channels changed at once"},
+  {"tracker_encoder_invalid_transitions_total", "axis=\"az\"", METRIC_TYPE_COUNTER, 0, METRIC_ENCODER_INVALID_AZ, nullptr,
+   nullptr},
+  {"tracker_gps_fix", "", METRIC_TYPE_GAUGE, 0, -1, sampleGpsFix,
+   "1 while the GPS has a valid fix"},
+  {"tracker_gps_fix_age_seconds", "", METRIC_TYPE_GAUGE, 3, -1, sampleGpsFixAge,
+   "Time since the last valid fix (since boot if none yet)"},
+  {"tracker_heap_free_bytes", "", METRIC_TYPE_GAUGE, 0, -1, sampleHeapFree,
+   "Free heap"},
+  {"tracker_heap_largest_free_block_bytes", "", METRIC_TYPE_GAUGE, 0, -1, sampleHeapLargest,
+   "Contiguous free heap at the top of the arena (lower bound on the largest block)"},
+  {"tracker_stack_free_min_bytes", "core=\"0\"", METRIC_TYPE_GAUGE, 0, -1, sampleStackCore0,
+   "Stack never touched since boot (-1 if not painted)"},
+  {"tracker_stack_free_min_bytes", "core=\"1\"", METRIC_TYPE_GAUGE, 0, -1, sampleStackCore1,
+   nullptr},
+  {"tracker_sgp4_evaluations_total", "", METRIC_TYPE_COUNTER, 0, METRIC_SGP4_EVALUATIONS, nullptr,
+   "SGP4 position evaluations for live tracking"},
+  {"tracker_pass_searches_total", "", METRIC_TYPE_COUNTER, 0, METRIC_PASS_SEARCHES, nullptr,
+   "Pass predictions computed for the pass cache"},
+  {"tracker_sgp4_inits_total", "source=\"text\"", METRIC_TYPE_COUNTER, 0, METRIC_SGP4_INITS, nullptr,
+   "SGP4 predictor set-ups, by where the initialised state came from"},
+  {"tracker_sgp4_inits_total", "source=\"cache\"", METRIC_TYPE_COUNTER, 0, METRIC_SGP4_CACHE_HITS, nullptr,
+   nullptr},
+  {"tracker_pass_satellites_screened_total", "", METRIC_TYPE_COUNTER, 0, METRIC_PASS_SATELLITES_SCREENED, nullptr,
+   "Watched satellites skipped because their orbit never rises at the site"}
+};
+
+#define METRIC_DEF_COUNT (sizeof(metricDefs) / sizeof(metricDefs[0]))
+
+static const HistogramDef histogramDefs[HISTOGRAM_COUNT] = {
+  {"tracker_control_loop_jitter_seconds", 6,
+   "Deviation of the control loop period from TRACKING_UPDATE_MS"},
+  {"tracker_http_request_duration_seconds", 6,
+   "Time from the first request byte until the response is handed to TCP"}
+};
+
+// ============================================================================
+// INTERNAL FUNCTIONS
+// ============================================================================
+
+// Position in the exposition, kept in the chunk generator context
+struct MetricsCursor {
+  uint8_t section;         // 0 = metrics, 1 = histograms, 2 = done
+  uint8_t index;
+  uint8_t line;
+  uint32_t cumulative;     // Histogram buckets counted so far
+};
+
+static_assert(sizeof(MetricsCursor) <= HTTP_CONTEXT_SIZE, "MetricsCursor too large");
+
+#define METRICS_LINE_SIZE 320   // HELP + TYPE + sample of the longest entry
+
+static size_t formatValue(char* out, size_t size, uint32_t raw, bool isSigned, uint8_t decimals) {
+  static const uint32_t scales[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+  if (decimals == 0) {
+    return snprintf(out, size, isSigned ? "%ld" : "%lu", (long)raw);
+  }
+  double value = isSigned ? (double)(int32_t)raw : (double)raw;
+  return formatFixed(out, size, value / scales[decimals], decimals);
+}
+
+static size_t formatHeader(char* out, size_t size, const char* name, const char* type, const char* help) {
+  return snprintf(out, size, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// Counter/gauge sample, preceded by HELP/TYPE for the first of a family.
+// Returns 0 when the entry is finished.
+static size_t formatMetricLine(const MetricsCursor* c, char* out, size_t size) {
+  const MetricDef& def = metricDefs[c->index];
+  if (c->line > 0) {
+    return 0;
+  }
+
+  size_t n = 0;
+  if (def.help) {
+    n = formatHeader(out, size, def.name, def.type == METRIC_TYPE_COUNTER ? "counter" : "gauge", def.help);
+  }
+
+  uint32_t raw = def.sample ? (uint32_t)def.sample() : metricValues[def.id];
+  bool isSigned = def.type == METRIC_TYPE_GAUGE;
+
+  n += snprintf(out + n, size - n, def.labels[0] ? "%s{%s} " : "%s%s ", def.name, def.labels);
+  n += formatValue(out + n, size - n, raw, isSigned, def.decimals);
+  out[n++] = '\n';
+  out[n] = '\0';
+  return n;
+}
+
+// Next line of a histogram; '*cumulative' is updated for bucket lines
+static size_t formatHistogramLine(const MetricsCursor* c, char* out, size_t size, uint32_t* cumulative) {
+  const HistogramDef& def = histogramDefs[c->index];
+  const MetricHistogramData& data = metricHistograms[c->index];
+  uint8_t buckets = metricHistogramBucketCount[c->index];
+
+  if (c->line == 0) {
+    return formatHeader(out, size, def.name, "histogram", def.help);
+  }
+
+  uint8_t i = c->line - 1;
+  size_t n;
+  if (i < buckets) {
+    *cumulative += data.counts[i];
+    n = snprintf(out, size, "%s_bucket{le=\"", def.name);
+    n += formatValue(out + n, size - n, metricHistogramBounds[c->index][i], false, def.decimals);
+    n += snprintf(out + n, size - n, "\"} %lu\n", (unsigned long)*cumulative);
+  } else if (i == buckets) {
+    *cumulative += data.counts[buckets];
+    n = snprintf(out, size, "%s_bucket{le=\"+Inf\"} %lu\n", def.name, (unsigned long)*cumulative);
+  } else if (i == buckets + 1) {
+    n = snprintf(out, size, "%s_sum ", def.name);
+    n += formatValue(out + n, size - n, data.sum, false, def.decimals);
+    out[n++] = '\n';
+    out[n] = '\0';
+  } else if (i == buckets + 2) {
+    // Same total as the +Inf bucket, so the two always agree
+    n = snprintf(out, size, "%s_count %lu\n", def.name, (unsigned long)*cumulative);
+  } else {
+    n = 0;
+  }
+  return n;
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+void initStackWatermark() {
+  int core = rp2040.cpuid();
+  uint32_t* bottom = core ? &__StackOneBottom : &__StackBottom;
+  uint32_t marker;
+  uint32_t* top = (uint32_t*)((uintptr_t)&marker - STACK_PAINT_MARGIN);
+
+  // Only paint what is plausibly this core's own stack
+  if (top <= bottom || (uintptr_t)top - (uintptr_t)bottom > STACK_MAX_PAINT) {
+    Serial.printf("Core %d: stack not at the expected address, watermark disabled\n", core);
+    return;
+  }
+
+  noInterrupts();
+  for (uint32_t* p = bottom; p < top; p++) {
+    *p = STACK_PAINT;
+  }
+  interrupts();
+
+  stackBottom[core] = bottom;
+  stackPaintTop[core] = top;
+}
+
+size_t metricsChunk(char* buf, size_t cap, void* context) {
+  MetricsCursor* c = (MetricsCursor*)context;
+  char line[METRICS_LINE_SIZE];
+  size_t len = 0;
+
+  while (c->section < 2) {
+    uint32_t cumulative = c->cumulative;
+    size_t n = c->section == 0 ? formatMetricLine(c, line, sizeof(line))
+                               : formatHistogramLine(c, line, sizeof(line), &cumulative);
+
+    if (n == 0) {
+      // Entry finished: next entry, or next section
+      c->index++;
+      c->line = 0;
+      c->cumulative = 0;
+      uint8_t count = c->section == 0 ? METRIC_DEF_COUNT : HISTOGRAM_COUNT;
+      if (c->index >= count) {
+        c->section++;
+        c->index = 0;
+      }
+      continue;
+    }
+
+    if (len + n > cap) {
+      if (len > 0) {
+        break;  // Goes out in the next chunk
+      }
+      n = cap;  // Never fits: truncate rather than end the response early
+    }
+    memcpy(buf + len, line, n);
+    len += n;
+    c->cumulative = cumulative;
+    c->line++;
+  }
+
+  return len;
+}
+
+void printMetrics() {
+  char buf[METRICS_LINE_SIZE];
+  MetricsCursor cursor;
+  memset(&cursor, 0, sizeof(cursor));
+
+  size_t n;
+  while ((n = metricsChunk(buf, sizeof(buf), &cursor)) > 0) {
+    Serial.write((const uint8_t*)buf, n);
+  }
+}
@@ -0,0 +1,58 @@
+// ============================================================================
+// motion_profile.cpp - Acceleration-limited velocity profiler
+// ============================================================================
+
+#include "motion_profile.h"
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+void initAxisProfile(AxisProfile* profile, float position, float maxAccel,
+                     float minPosition, float maxPosition, bool limited) {
+  profile->maxAccel = maxAccel;
+  profile->minPosition = minPosition;
+  profile->maxPosition = maxPosition;
+  profile->limited = limited;
+  resetAxisProfile(profile, position);
+}
+
+void resetAxisProfile(AxisProfile* profile, float position) {
+  if (profile->limited) {
+    position = constrain(position, profile->minPosition, profile->maxPosition);
+  }
+  profile->position = position;
+  profile->velocity = 0.0f;
+}
+
+float updateAxisProfile(AxisProfile* profile, float commandVelocity, float dt) {
+  float target = commandVelocity;
+  
+  // Never command more speed toward a limit than can be braked away
+  // before reaching it: v^2 = 2 * a * distance
+  if (profile->limited) {
+    float upRoom = max(0.0f, profile->maxPosition - profile->position);
+    float downRoom = max(0.0f, profile->position - profile->minPosition);
+    float upMax = sqrtf(2.0f * profile->maxAccel * upRoom);
+    float downMax = sqrtf(2.0f * profile->maxAccel * downRoom);
+    target = constrain(target, -downMax, upMax);
+  }
+  
+  // Slew velocity toward the command within the acceleration limit
+  float maxStep = profile->maxAccel * dt;
+  profile->velocity += constrain(target - profile->velocity, -maxStep, maxStep);
+  
+  profile->position += profile->velocity * dt;
+  
+  if (profile->limited) {
+    if (profile->position >= profile->maxPosition) {
+      profile->position = profile->maxPosition;
+      profile->velocity = min(profile->velocity, 0.0f);
+    } else if (profile->position <= profile->minPosition) {
+      profile->position = profile->minPosition;
+      profile->velocity = max(profile->velocity, 0.0f);
+    }
+  }
+  
+  return profile->position;
+}
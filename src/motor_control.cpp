@@ -3,6 +3,10 @@
 // ============================================================================
 
 #include "motor_control.h"
+#include "motion_profile.h"
+#include "joystick_module.h"
+#include "input_debounce.h"
+#include "metrics.h"
 
 PIO pioEncoder = pio0;
 uint smElevation;
@@ -11,6 +15,24 @@ uint smAzimuth;
 // Emergency stop flag
 volatile bool emergencyStop = false;
 
+// Time each index sensor last triggered (micros, from the debouncer)
+static volatile uint32_t indexETimeUs = 0;
+static volatile uint32_t indexATimeUs = 0;
+
+// Manual jog profiles (joystick velocity mode)
+static AxisProfile jogAz;
+static AxisProfile jogEl;
+static bool jogActive = false;
+
+// Per-pass pointing error (metrics). A pass starts when the tracked
+// satellite rises above the horizon.
+static float passErrorSqSum = 0.0;
+static uint32_t passErrorSamples = 0;
+static bool passActive = false;
+
+// Invalid encoder transitions already reported to the metrics registry
+static uint32_t encoderInvalidSeen[2] = {0, 0};
+
 void setupPIOEncoders() {
   // Load PIO program
   uint offset = pio_add_program(pioEncoder, &quadrature_encoder_program);
@@ -27,6 +49,14 @@ void setupPIOEncoders() {
 int32_t readPIOEncoder(uint sm) {
   quadrature_encoder_request_count(pioEncoder, sm);
   while (pio_sm_is_rx_fifo_empty(pioEncoder, sm));
+  
+  uint32_t invalid = quadrature_encoder_fetch_invalid(pioEncoder, sm);
+  if (sm < 2 && invalid != encoderInvalidSeen[sm]) {
+    metricAdd(sm == smElevation ? METRIC_ENCODER_INVALID_EL : METRIC_ENCODER_INVALID_AZ,
+              invalid - encoderInvalidSeen[sm]);
+    encoderInvalidSeen[sm] = invalid;
+  }
+  
   return quadrature_encoder_fetch_count(pioEncoder, sm);
 }
 
@@ -58,6 +88,24 @@ void __not_in_flash_func(emergencyStop_ISR)() {
   trackerState.tracking = false;
 }
 
+// Clean transitions from the PIO debouncer. Index sensors and e-stop are
+// active low; only the falling edge matters.
+static void __not_in_flash_func(motorInputEdge)(uint8_t pin, bool level, uint32_t timeUs) {
+  if (level) {
+    return;
+  }
+  
+  if (pin == INDEX_E) {
+    indexETimeUs = timeUs;
+    indexE_ISR();
+  } else if (pin == INDEX_A) {
+    indexATimeUs = timeUs;
+    indexA_ISR();
+  } else if (pin == EMERGENCY_STOP_PIN) {
+    emergencyStop_ISR();
+  }
+}
+
 void resetEmergencyStop() {
   emergencyStop = false;
   Serial.println("Emergency stop reset");
@@ -131,22 +179,115 @@ float pidControl(float error, float &errorIntegral, float &lastError, float dt)
   return constrain(output, -255, 255);
 }
 
+// Measured antenna position in degrees, azimuth normalized to 0-360
+static void readAntennaPosition(float* azimuth, float* elevation) {
+  motorPos.elevation = readPIOEncoder(smElevation);
+  motorPos.azimuth = readPIOEncoder(smAzimuth);
+  
+  *elevation = motorPos.elevation * DEGREES_PER_PULSE;
+  *azimuth = motorPos.azimuth * DEGREES_PER_PULSE;
+  while (*azimuth < 0) *azimuth += 360.0;
+  while (*azimuth >= 360) *azimuth -= 360.0;
+}
+
+// Target minus measured position; azimuth takes the shortest way round
+static void computePointingError(float currentAz, float currentEl, float* errorAz, float* errorEl) {
+  float targetEl = constrain(targetPos.elevation, MIN_ELEVATION, MAX_ELEVATION);
+  *errorEl = targetEl - currentEl;
+  *errorAz = targetPos.azimuth - currentAz;
+  if (*errorAz > 180) *errorAz -= 360;
+  if (*errorAz < -180) *errorAz += 360;
+}
+
+void readEncoderSample(int32_t* countEl, int32_t* countAz, float* errorAz, float* errorEl) {
+  float currentAz, currentEl;
+  readAntennaPosition(&currentAz, &currentEl);
+  *countEl = motorPos.elevation;
+  *countAz = motorPos.azimuth;
+  computePointingError(currentAz, currentEl, errorAz, errorEl);
+}
+
+// Joystick jog: stick deflection is a velocity command, profiled over the
+// measured loop period into a smooth target for the position loop. The
+// profile starts from the measured position so engaging the jog never jumps.
+void updateManualJog(float dt) {
+  if (emergencyStop || !isJoystickManualMode()) {
+    jogActive = false;
+    return;
+  }
+  
+  // A stalled loop (flash write, blocking command) must not turn into one
+  // large step of the target
+  if (dt <= 0.0f) return;
+  if (dt > JOG_MAX_DT) dt = JOG_MAX_DT;
+  
+  readJoystick();  // Constant-time fetch of the latest filtered sample
+  float azVel = getJoystickAzimuthSpeed() * JOG_MAX_SPEED_AZ;
+  float elVel = getJoystickElevationSpeed() * JOG_MAX_SPEED_EL;
+  
+  if (azVel != 0.0f || elVel != 0.0f) {
+    trackerState.tracking = false;  // Disable tracking when manually controlled
+  } else if (trackerState.tracking) {
+    jogActive = false;  // Stick idle, leave the target to the tracker
+    return;
+  }
+  
+  if (!jogActive) {
+    float currentAz, currentEl;
+    readAntennaPosition(&currentAz, &currentEl);
+    initAxisProfile(&jogAz, currentAz, JOG_ACCEL_AZ, 0.0f, 0.0f, false);
+    initAxisProfile(&jogEl, currentEl, JOG_ACCEL_EL, MIN_ELEVATION, MAX_ELEVATION, true);
+    jogActive = true;
+  }
+  
+  float az = updateAxisProfile(&jogAz, azVel, dt);
+  float el = updateAxisProfile(&jogEl, elVel, dt);
+  
+  // Azimuth is continuous; keep the profile position in 0-360
+  if (az < 0) az += 360.0;
+  if (az >= 360) az -= 360.0;
+  jogAz.position = az;
+  
+  targetPos.azimuth = az;
+  targetPos.elevation = el;
+  targetPos.valid = true;
+}
+
+// Accumulate the pointing error of the pass being tracked. Azimuth error
+// is scaled by cos(elevation) to measure it along the sky.
+static void updateTrackingErrorStats(float errorA, float errorE, float elevation) {
+  PoseSnapshot pose;
+  getPoseSnapshot(&pose);
+  bool up = trackerState.tracking && pose.satellite.valid && pose.satellite.elevation > 0.0f;
+  
+  if (up && !passActive) {
+    passErrorSqSum = 0.0;
+    passErrorSamples = 0;
+    metricInc(METRIC_PASSES_TRACKED);
+  }
+  passActive = up;
+  if (!up) {
+    return;
+  }
+  
+  float crossAz = errorA * cosf(elevation * (float)PI / 180.0f);
+  passErrorSqSum += crossAz * crossAz + errorE * errorE;
+  passErrorSamples++;
+  metricSet(METRIC_TRACKING_ERROR_RMS, (int32_t)(sqrtf(passErrorSqSum / passErrorSamples) * 1000.0f));
+}
+
 void updateMotorControl() {
+  metricInc(METRIC_CONTROL_LOOPS);
+  
   // Check emergency stop first
   if (emergencyStop) {
     stopAllMotors();
+    jogActive = false;
     return;
   }
   
-  motorPos.elevation = readPIOEncoder(smElevation);
-  motorPos.azimuth = readPIOEncoder(smAzimuth);
-  
-  float currentElevation = motorPos.elevation * DEGREES_PER_PULSE;
-  float currentAzimuth = motorPos.azimuth * DEGREES_PER_PULSE;
-  
-  // Normalize azimuth to 0-360
-  while (currentAzimuth < 0) currentAzimuth += 360.0;
-  while (currentAzimuth >= 360) currentAzimuth -= 360.0;
+  float currentAzimuth, currentElevation;
+  readAntennaPosition(&currentAzimuth, &currentElevation);
   
   // Safety check: Elevation limits with margin
   if (currentElevation < (MIN_ELEVATION - 5.0) || 
@@ -155,18 +296,17 @@ void updateMotorControl() {
     Serial.println(currentElevation);
     stopAllMotors();
     trackerState.tracking = false;
+    jogActive = false;
     return;
   }
   
-  float targetEl = constrain(targetPos.elevation, MIN_ELEVATION, MAX_ELEVATION);
-  float targetAz = targetPos.azimuth;
-  
-  float errorE = targetEl - currentElevation;
-  float errorA = targetAz - currentAzimuth;
+  float errorA, errorE;
+  computePointingError(currentAzimuth, currentElevation, &errorA, &errorE);
   
-  // Handle azimuth wraparound (find shortest path)
-  if (errorA > 180) errorA -= 360;
-  if (errorA < -180) errorA += 360;
+  // Share the measured pose with the display/LED side
+  AntennaPose pose = {currentAzimuth, currentElevation, errorA, errorE};
+  publishAntennaPose(pose);
+  updateTrackingErrorStats(errorA, errorE, currentElevation);
   
   float controlE = 0, controlA = 0;
   
@@ -188,66 +328,122 @@ void updateMotorControl() {
   setMotorSpeed(MOTOR_A_PWM_FWD, MOTOR_A_PWM_REV, MOTOR_A_ENABLE, (int)controlA);
 }
 
-void homeAxes() {
+// ============================================================================
+// HOMING
+// ============================================================================
+// Homing runs as a state machine so it can be driven from a polled job
+// (web) as well as the blocking homeAxes() used by the serial console.
+
+#define HOMING_SPEED -80
+#define HOMING_TIMEOUT_MS 30000
+#define HOMING_SETTLE_MS 500
+
+static HomingState homingState = HOMING_IDLE;
+static unsigned long homingStepStart = 0;
+
+static void failHoming(const char* reason) {
+  Serial.println(reason);
+  homingState = HOMING_FAILED;
+}
+
+bool beginHoming() {
+  if (homingState == HOMING_ELEVATION || homingState == HOMING_AZIMUTH ||
+      homingState == HOMING_SETTLING) {
+    return false;  // Already running
+  }
+  
   Serial.println("Homing axes...");
   trackerState.tracking = false;
   
   // Reset emergency stop if needed
   if (emergencyStop) {
-    Serial.println("Cannot home - emergency stop active");
-    return;
+    failHoming("Cannot home - emergency stop active");
+    return false;
   }
   
   // Home elevation axis
   motorPos.elevationIndexFound = false;
-  setMotorSpeed(MOTOR_E_PWM_FWD, MOTOR_E_PWM_REV, MOTOR_E_ENABLE, -80);
-  unsigned long startTime = millis();
-  
-  while (!motorPos.elevationIndexFound && 
-         (millis() - startTime) < 30000 && 
-         !emergencyStop) {
-    delay(10);
-  }
-  setMotorSpeed(MOTOR_E_PWM_FWD, MOTOR_E_PWM_REV, MOTOR_E_ENABLE, 0);
-  
-  if (emergencyStop) {
-    Serial.println("Homing aborted - emergency stop");
-    return;
-  }
-  
-  if (motorPos.elevationIndexFound) {
-    Serial.println("Elevation homed");
-  } else {
-    Serial.println("ERROR: Elevation home timeout");
-    return;
+  setMotorSpeed(MOTOR_E_PWM_FWD, MOTOR_E_PWM_REV, MOTOR_E_ENABLE, HOMING_SPEED);
+  homingStepStart = millis();
+  homingState = HOMING_ELEVATION;
+  return true;
+}
+
+HomingState updateHoming() {
+  unsigned long elapsed = millis() - homingStepStart;
+  
+  switch (homingState) {
+    case HOMING_ELEVATION:
+      if (emergencyStop) {
+        setMotorSpeed(MOTOR_E_PWM_FWD, MOTOR_E_PWM_REV, MOTOR_E_ENABLE, 0);
+        failHoming("Homing aborted - emergency stop");
+      } else if (motorPos.elevationIndexFound) {
+        setMotorSpeed(MOTOR_E_PWM_FWD, MOTOR_E_PWM_REV, MOTOR_E_ENABLE, 0);
+        Serial.println("Elevation homed");
+        
+        // Home azimuth axis
+        motorPos.azimuthIndexFound = false;
+        setMotorSpeed(MOTOR_A_PWM_FWD, MOTOR_A_PWM_REV, MOTOR_A_ENABLE, HOMING_SPEED);
+        homingStepStart = millis();
+        homingState = HOMING_AZIMUTH;
+      } else if (elapsed >= HOMING_TIMEOUT_MS) {
+        setMotorSpeed(MOTOR_E_PWM_FWD, MOTOR_E_PWM_REV, MOTOR_E_ENABLE, 0);
+        failHoming("ERROR: Elevation home timeout");
+      }
+      break;
+      
+    case HOMING_AZIMUTH:
+      if (emergencyStop) {
+        setMotorSpeed(MOTOR_A_PWM_FWD, MOTOR_A_PWM_REV, MOTOR_A_ENABLE, 0);
+        failHoming("Homing aborted - emergency stop");
+      } else if (motorPos.azimuthIndexFound) {
+        setMotorSpeed(MOTOR_A_PWM_FWD, MOTOR_A_PWM_REV, MOTOR_A_ENABLE, 0);
+        Serial.println("Azimuth homed");
+        homingStepStart = millis();
+        homingState = HOMING_SETTLING;
+      } else if (elapsed >= HOMING_TIMEOUT_MS) {
+        setMotorSpeed(MOTOR_A_PWM_FWD, MOTOR_A_PWM_REV, MOTOR_A_ENABLE, 0);
+        failHoming("ERROR: Azimuth home timeout");
+      }
+      break;
+      
+    case HOMING_SETTLING:
+      if (elapsed >= HOMING_SETTLE_MS) {
+        Serial.println("Homing complete");
+        homingState = HOMING_DONE;
+      }
+      break;
+      
+    default:
+      break;
   }
   
-  // Home azimuth axis
-  motorPos.azimuthIndexFound = false;
-  setMotorSpeed(MOTOR_A_PWM_FWD, MOTOR_A_PWM_REV, MOTOR_A_ENABLE, -80);
-  startTime = millis();
-  
-  while (!motorPos.azimuthIndexFound && 
-         (millis() - startTime) < 30000 && 
-         !emergencyStop) {
-    delay(10);
+  return homingState;
+}
+
+HomingState getHomingState() {
+  return homingState;
+}
+
+bool cancelHoming() {
+  if (homingState != HOMING_ELEVATION && homingState != HOMING_AZIMUTH &&
+      homingState != HOMING_SETTLING) {
+    return false;
   }
+  setMotorSpeed(MOTOR_E_PWM_FWD, MOTOR_E_PWM_REV, MOTOR_E_ENABLE, 0);
   setMotorSpeed(MOTOR_A_PWM_FWD, MOTOR_A_PWM_REV, MOTOR_A_ENABLE, 0);
-  
-  if (emergencyStop) {
-    Serial.println("Homing aborted - emergency stop");
+  failHoming("Homing aborted");
+  return true;
+}
+
+void homeAxes() {
+  if (!beginHoming()) {
     return;
   }
   
-  if (motorPos.azimuthIndexFound) {
-    Serial.println("Azimuth homed");
-  } else {
-    Serial.println("ERROR: Azimuth home timeout");
-    return;
+  while (updateHoming() != HOMING_DONE && homingState != HOMING_FAILED) {
+    delay(10);
   }
-  
-  delay(500);
-  Serial.println("Homing complete");
 }
 
 void initMotorControl() {
@@ -273,15 +469,15 @@ void initMotorControl() {
   
   stopAllMotors();
   
-  // Setup index pins
+  // Setup index pins (debounced in PIO, no GPIO interrupts)
   pinMode(INDEX_E, INPUT_PULLUP);
   pinMode(INDEX_A, INPUT_PULLUP);
-  attachInterrupt(digitalPinToInterrupt(INDEX_E), indexE_ISR, FALLING);
-  attachInterrupt(digitalPinToInterrupt(INDEX_A), indexA_ISR, FALLING);
+  addDebouncedInput(INDEX_E, motorInputEdge);
+  addDebouncedInput(INDEX_A, motorInputEdge);
   
   // Setup emergency stop pin
   pinMode(EMERGENCY_STOP_PIN, INPUT_PULLUP);
-  attachInterrupt(digitalPinToInterrupt(EMERGENCY_STOP_PIN), emergencyStop_ISR, FALLING);
+  addDebouncedInput(EMERGENCY_STOP_PIN, motorInputEdge);
   
   emergencyStop = false;
   
@@ -321,6 +517,12 @@ void printMotorStatus() {
   Serial.printf("Index Found:\n");
   Serial.printf("  Azimuth:   %s\n", motorPos.azimuthIndexFound ? "YES" : "NO");
   Serial.printf("  Elevation: %s\n", motorPos.elevationIndexFound ? "YES" : "NO");
+  if (motorPos.azimuthIndexFound) {
+    Serial.printf("  Azimuth index seen %lu ms ago\n", (micros() - indexATimeUs) / 1000);
+  }
+  if (motorPos.elevationIndexFound) {
+    Serial.printf("  Elevation index seen %lu ms ago\n", (micros() - indexETimeUs) / 1000);
+  }
   
   Serial.println();
   Serial.printf("Emergency Stop: %s\n", isEmergencyStop() ? "ACTIVE" : "OK");
@@ -0,0 +1,531 @@
+// ============================================================================
+// pass_cache.cpp - Pass schedule cache
+// ============================================================================
+
+#include "pass_cache.h"
+#include <Sgp4.h>
+#include "sgp4_cache.h"
+#include "shared_data.h"
+#include "gps_module.h"
+#include "metrics.h"
+
+// Core 1 predicts every pass of the watched satellites over the next
+// PASS_CACHE_HOURS into the back buffer, sorts it by (AOS, NORAD ID) and
+// flips it to the front. Core 0 answers queries from the front buffer by
+// binary search. The generation counter doubles as a seqlock: a reader
+// that sees it change while copying retries, since the old front buffer
+// is the next build's target.
+
+#define PASS_LOOKBACK_S 1800      // Start predicting early to catch a pass in progress
+#define PASS_ITERATIONS 20        // nextpass() refinement steps
+#define PASS_SITE_TOLERANCE 0.01  // Degrees of GPS drift before a rebuild
+#define PASS_ALTITUDE_TOLERANCE 100.0
+#define PASS_SCREEN_MARGIN 2.0    // Degrees of latitude allowed for perturbations
+
+#define EARTH_RADIUS_KM 6378.135  // WGS-72, as used by SGP4
+#define EARTH_MU_KM3_S2 398600.8
+
+struct PassBuffer {
+  PassEntry passes[PASS_CACHE_SIZE];
+  uint16_t count;
+  uint16_t dropped;
+  uint8_t screened;        // Satellites that cannot rise at the site
+  uint32_t start;
+  uint32_t end;
+  uint32_t maxDuration;    // Longest pass, bounds the query lookback
+  uint32_t buildMs;
+};
+
+// Cache (written by Core 1)
+static PassBuffer buffers[2];
+static volatile uint32_t cacheGeneration = 0;   // Front = generation & 1; 0 = none yet
+
+// Watch list (written by Core 0, read by Core 1 under watchSeq)
+static TleRecord watchList[PASS_WATCH_MAX];
+static uint8_t watchCount = 0;
+static volatile uint32_t watchSeq = 0;          // Odd while being rewritten
+
+// Core 0 only
+static uint32_t watchIds[PASS_WATCH_MAX];       // Requested NORAD IDs
+static uint8_t watchIdCount = 0;
+static uint32_t resolvedCatalogGeneration = 0;
+static char resolvedTrackedLine1[TLE_LINE_LENGTH + 1] = "";
+
+// Build state (Core 1 only)
+typedef enum {
+  BUILD_IDLE = 0,
+  BUILD_NEXT_SATELLITE,
+  BUILD_PASSES
+} BuildState;
+
+static BuildState buildState = BUILD_IDLE;
+static Sgp4 predictor;
+static uint32_t buildWatchSeq = 0;
+static uint8_t buildWatchCount = 0;
+static uint8_t buildIndex = 0;
+static uint32_t buildNorad = 0;
+static uint32_t buildLastAos = 0;       // Guards against a predictor that stops advancing
+static uint32_t buildStart = 0;
+static uint32_t buildEnd = 0;
+static unsigned long buildStartMs = 0;
+static double buildLat = 0.0, buildLon = 0.0, buildAlt = 0.0;
+static bool built = false;
+static uint32_t builtWatchSeq = 0;
+static uint32_t builtStart = 0;
+
+// ============================================================================
+// INTERNAL FUNCTIONS
+// ============================================================================
+
+static double unixToJulian(uint32_t t) {
+  return t / 86400.0 + 2440587.5;
+}
+
+static uint32_t julianToUnix(double jd) {
+  return (uint32_t)((jd - 2440587.5) * 86400.0 + 0.5);
+}
+
+static uint16_t toTenths(double degrees) {
+  while (degrees < 0.0) degrees += 360.0;
+  return (uint16_t)(degrees * 10.0 + 0.5) % 3600;
+}
+
+static int comparePasses(const void* a, const void* b) {
+  const PassEntry* pa = (const PassEntry*)a;
+  const PassEntry* pb = (const PassEntry*)b;
+  if (pa->aos != pb->aos) return pa->aos < pb->aos ? -1 : 1;
+  if (pa->noradId != pb->noradId) return pa->noradId < pb->noradId ? -1 : 1;
+  return 0;
+}
+
+// First pass ordered after (aos, noradId)
+static uint16_t upperBound(const PassBuffer& buf, uint32_t aos, uint32_t noradId) {
+  uint16_t lo = 0;
+  uint16_t hi = buf.count;
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    const PassEntry& e = buf.passes[mid];
+    if (e.aos < aos || (e.aos == aos && e.noradId <= noradId)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static bool matchesQuery(const PassQuery* query, uint32_t noradId) {
+  if (query->satCount == 0) {
+    return true;
+  }
+  for (uint8_t i = 0; i < query->satCount; i++) {
+    if (query->sats[i] == noradId) return true;
+  }
+  return false;
+}
+
+// Rebuild the watch table from the requested IDs and the tracked TLE
+// (Core 0). Core 1 skips its work while watchSeq is odd.
+static uint8_t resolveWatchList() {
+  watchSeq = watchSeq + 1;
+  __dmb();
+
+  uint8_t count = 0;
+  uint8_t found = 0;
+  uint32_t trackedId = 0;
+
+  resolvedTrackedLine1[0] = '\0';
+  if (trackerState.tleValid) {
+    TleRecord& record = watchList[count++];
+    trackedId = tleCatalogNumber(tleLine1);
+    record.noradId = trackedId;
+    record.epoch = tleEpoch(tleLine1);
+    if (!parseTleElements(tleLine1, tleLine2, &record.elements)) {
+      memset(&record.elements, 0, sizeof(record.elements));  // Never screened out
+    }
+    strncpy(record.name, satelliteName, sizeof(record.name) - 1);
+    record.name[sizeof(record.name) - 1] = '\0';
+    strncpy(record.line1, tleLine1, sizeof(record.line1) - 1);
+    record.line1[sizeof(record.line1) - 1] = '\0';
+    strncpy(record.line2, tleLine2, sizeof(record.line2) - 1);
+    record.line2[sizeof(record.line2) - 1] = '\0';
+    strcpy(resolvedTrackedLine1, record.line1);
+  }
+
+  for (uint8_t i = 0; i < watchIdCount && count < PASS_WATCH_MAX; i++) {
+    if (watchIds[i] == trackedId) {
+      found++;
+    } else if (findCatalogRecord(watchIds[i], &watchList[count])) {
+      count++;
+      found++;
+    }
+  }
+
+  watchCount = count;
+  resolvedCatalogGeneration = getCatalogGeneration();
+
+  __dmb();
+  watchSeq = watchSeq + 1;
+  return found;
+}
+
+// Copy one watch entry (Core 1). Fails if Core 0 is rewriting the list
+// or has changed it since the build started.
+static bool copyWatchEntry(uint8_t index, TleRecord* out) {
+  uint32_t seq = watchSeq;
+  __dmb();
+  if (seq != buildWatchSeq) {
+    return false;
+  }
+  *out = watchList[index];
+  __dmb();
+  return seq == watchSeq;
+}
+
+// Whether the orbit can ever bring the satellite above PASS_MIN_ELEVATION
+// at latitude 'lat'. The ground track reaches latitude i (180 - i when
+// retrograde) and the satellite is visible up to a central angle lambda
+// beyond it, widest at apogee. Saves a pass search that would scan the
+// whole window for nothing.
+static bool canRise(const TleElements& el, double lat) {
+  if (el.meanMotion <= 0.0f) {
+    return true;  // No parsed elements
+  }
+
+  double n = el.meanMotion * 2.0 * PI / 86400.0;
+  double apogee = cbrt(EARTH_MU_KM3_S2 / (n * n)) * (1.0 + el.eccentricity);
+  if (apogee <= EARTH_RADIUS_KM) {
+    return true;  // Decayed; leave it to SGP4
+  }
+
+  double minEl = PASS_MIN_ELEVATION * PI / 180.0;
+  double lambda = (acos(EARTH_RADIUS_KM / apogee * cos(minEl)) - minEl) * 180.0 / PI;
+  double reach = el.inclination <= 90.0f ? el.inclination : 180.0f - el.inclination;
+  return fabs(lat) <= reach + lambda + PASS_SCREEN_MARGIN;
+}
+
+static bool siteMoved() {
+  return fabs(trackerState.latitude - buildLat) > PASS_SITE_TOLERANCE ||
+         fabs(trackerState.longitude - buildLon) > PASS_SITE_TOLERANCE ||
+         fabs(trackerState.altitude - buildAlt) > PASS_ALTITUDE_TOLERANCE;
+}
+
+static bool rebuildNeeded(uint32_t now) {
+  uint32_t seq = watchSeq;
+  if (seq & 1) {
+    return false;  // Core 0 is mid-update
+  }
+  return !built || seq != builtWatchSeq || siteMoved() ||
+         now - builtStart >= PASS_CACHE_REFRESH_HOURS * 3600UL;
+}
+
+static void startBuild(uint32_t now) {
+  buildWatchSeq = watchSeq;
+  __dmb();
+  buildWatchCount = watchCount;
+  __dmb();
+  if (buildWatchSeq != watchSeq || (buildWatchSeq & 1)) {
+    return;  // Try again next call
+  }
+
+  PassBuffer& back = buffers[(cacheGeneration + 1) & 1];
+  back.count = 0;
+  back.dropped = 0;
+  back.screened = 0;
+  back.maxDuration = 0;
+  back.start = now;
+  back.end = now + PASS_CACHE_HOURS * 3600UL;
+
+  buildLat = trackerState.latitude;
+  buildLon = trackerState.longitude;
+  buildAlt = trackerState.altitude;
+  buildStart = back.start;
+  buildEnd = back.end;
+  buildIndex = 0;
+  buildStartMs = millis();
+  buildState = BUILD_NEXT_SATELLITE;
+}
+
+static void finishBuild() {
+  PassBuffer& back = buffers[(cacheGeneration + 1) & 1];
+  qsort(back.passes, back.count, sizeof(PassEntry), comparePasses);
+  back.buildMs = millis() - buildStartMs;
+
+  __dmb();
+  cacheGeneration = cacheGeneration + 1;
+
+  built = true;
+  builtWatchSeq = buildWatchSeq;
+  builtStart = buildStart;
+  buildState = BUILD_IDLE;
+
+  Serial.printf("Core 1: Pass cache built: %u passes, %u satellites, %lu ms\n",
+                back.count, buildWatchCount, back.buildMs);
+}
+
+// One unit of build work: set up a satellite or predict one pass.
+// Returns false when the build finished or had to stop.
+static bool buildStep() {
+  PassBuffer& back = buffers[(cacheGeneration + 1) & 1];
+
+  if (buildState == BUILD_NEXT_SATELLITE) {
+    if (buildIndex >= buildWatchCount) {
+      finishBuild();
+      return false;
+    }
+
+    TleRecord record;
+    if (!copyWatchEntry(buildIndex, &record)) {
+      buildState = BUILD_IDLE;  // List changed; restart from scratch
+      return false;
+    }
+    buildIndex++;
+
+    if (!canRise(record.elements, buildLat)) {
+      back.screened++;
+      metricInc(METRIC_PASS_SATELLITES_SCREENED);
+      return true;
+    }
+    if (!initSatellite(&predictor, record.name, record.line1, record.line2)) {
+      return true;
+    }
+    predictor.site(buildLat, buildLon, buildAlt);
+    predictor.initpredpoint(unixToJulian(buildStart - PASS_LOOKBACK_S), PASS_MIN_ELEVATION);
+    buildNorad = record.noradId;
+    buildLastAos = 0;
+    buildState = BUILD_PASSES;
+    return true;
+  }
+
+  passinfo pass;
+  metricInc(METRIC_PASS_SEARCHES);
+  if (!predictor.nextpass(&pass, PASS_ITERATIONS)) {
+    buildState = BUILD_NEXT_SATELLITE;
+    return true;
+  }
+
+  uint32_t aos = julianToUnix(pass.jdstart);
+  uint32_t los = julianToUnix(pass.jdstop);
+  if (aos >= buildEnd || (buildLastAos && aos <= buildLastAos)) {
+    buildState = BUILD_NEXT_SATELLITE;
+    return true;
+  }
+  buildLastAos = aos;
+  if (los <= buildStart) {
+    return true;  // Ended before the window
+  }
+
+  if (back.count >= PASS_CACHE_SIZE) {
+    back.dropped++;
+    return true;
+  }
+
+  PassEntry& entry = back.passes[back.count++];
+  entry.aos = aos;
+  entry.los = los;
+  entry.noradId = buildNorad;
+  entry.aosAz = toTenths(pass.azstart);
+  entry.maxAz = toTenths(pass.azmax);
+  entry.losAz = toTenths(pass.azstop);
+  entry.maxEl = (int16_t)(pass.maxelevation * 10.0 + 0.5);
+  back.maxDuration = max(back.maxDuration, los - aos);
+  return true;
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+void initPassCache() {
+  buildState = BUILD_IDLE;
+  built = false;
+}
+
+void updatePassCache() {
+  uint32_t now = getGpsUnixTime();
+  if (now == 0) {
+    return;  // No fix: keep serving the last cache
+  }
+
+  if (buildState == BUILD_IDLE) {
+    if (!rebuildNeeded(now)) {
+      return;
+    }
+    startBuild(now);
+    if (buildState == BUILD_IDLE) {
+      return;
+    }
+  }
+
+  uint32_t sliceStart = micros();
+  while (buildStep() && micros() - sliceStart < PASS_BUILD_SLICE_US) {
+  }
+}
+
+uint8_t setPassWatchList(const uint32_t* ids, uint8_t count) {
+  watchIdCount = min(count, (uint8_t)PASS_WATCH_MAX);
+  memcpy(watchIds, ids, watchIdCount * sizeof(uint32_t));
+  return resolveWatchList();
+}
+
+void pollPassCache() {
+  static unsigned long lastCheck = 0;
+  unsigned long now = millis();
+  if (now - lastCheck < 1000) {
+    return;
+  }
+  lastCheck = now;
+
+  bool trackedChanged = trackerState.tleValid ?
+      strcmp(resolvedTrackedLine1, tleLine1) != 0 : resolvedTrackedLine1[0] != '\0';
+  if (trackedChanged || getCatalogGeneration() != resolvedCatalogGeneration) {
+    resolveWatchList();
+  }
+}
+
+const char* getPassWatchName(uint32_t noradId) {
+  for (uint8_t i = 0; i < watchCount; i++) {
+    if (watchList[i].noradId == noradId) {
+      return watchList[i].name;
+    }
+  }
+  return "";
+}
+
+uint8_t getPassWatchList(uint32_t* ids, uint8_t maxIds) {
+  uint8_t count = min(watchCount, maxIds);
+  for (uint8_t i = 0; i < count; i++) {
+    ids[i] = watchList[i].noradId;
+  }
+  return count;
+}
+
+uint8_t parseNoradList(const char* text, uint32_t* ids, uint8_t maxIds) {
+  uint8_t count = 0;
+  while (*text && count < maxIds) {
+    if (*text >= '0' && *text <= '9') {
+      uint32_t id = 0;
+      while (*text >= '0' && *text <= '9') {
+        id = id * 10 + (*text++ - '0');
+      }
+      if (id) ids[count++] = id;
+    } else if (*text == ',' || *text == ' ') {
+      text++;
+    } else {
+      return 0;
+    }
+  }
+  return count;
+}
+
+void passCursorBegin(const PassQuery* query, PassCursor* cursor) {
+  uint32_t gen;
+  uint32_t lookback;
+  do {
+    gen = cacheGeneration;
+    __dmb();
+    lookback = buffers[gen & 1].maxDuration;
+    __dmb();
+  } while (gen != cacheGeneration);
+
+  cursor->aos = query->from > lookback ? query->from - lookback : 0;
+  cursor->noradId = 0;
+  cursor->done = false;
+}
+
+uint16_t queryPasses(const PassQuery* query, PassCursor* cursor, PassEntry* out, uint16_t maxOut) {
+  if (cursor->done) {
+    return 0;
+  }
+
+  uint16_t n;
+  PassCursor next;
+  uint32_t gen;
+
+  // Retry if Core 1 flipped buffers during the copy
+  do {
+    gen = cacheGeneration;
+    __dmb();
+    const PassBuffer& buf = buffers[gen & 1];
+    n = 0;
+    next = *cursor;
+
+    uint16_t i = upperBound(buf, cursor->aos, cursor->noradId);
+    for (; i < buf.count && n < maxOut; i++) {
+      const PassEntry& entry = buf.passes[i];
+      if (entry.aos >= query->to) {
+        next.done = true;
+        break;
+      }
+      next.aos = entry.aos;
+      next.noradId = entry.noradId;
+      if (entry.los > query->from && matchesQuery(query, entry.noradId)) {
+        out[n++] = entry;
+      }
+    }
+    if (i >= buf.count) {
+      next.done = true;
+    }
+    __dmb();
+  } while (gen != cacheGeneration);
+
+  *cursor = next;
+  return n;
+}
+
+void getPassCacheInfo(PassCacheInfo* info) {
+  uint32_t gen;
+  do {
+    gen = cacheGeneration;
+    __dmb();
+    const PassBuffer& buf = buffers[gen & 1];
+    info->ready = gen > 0;
+    info->start = buf.start;
+    info->end = buf.end;
+    info->count = buf.count;
+    info->dropped = buf.dropped;
+    info->screened = buf.screened;
+    info->buildMs = buf.buildMs;
+    __dmb();
+  } while (gen != cacheGeneration);
+}
+
+void printPassCacheStatus(uint8_t maxPasses) {
+  Serial.println(F("\n=== PASS CACHE ==="));
+
+  Serial.printf("Watching %u satellite(s):\n", watchCount);
+  for (uint8_t i = 0; i < watchCount; i++) {
+    Serial.printf("  %5lu  %s\n", watchList[i].noradId, watchList[i].name);
+  }
+
+  PassCacheInfo info;
+  getPassCacheInfo(&info);
+  if (!info.ready) {
+    Serial.println(F("Cache: not built (needs a GPS fix)"));
+    Serial.println();
+    return;
+  }
+  Serial.printf("Cache: %u passes (%u dropped), %lu..%lu, built in %lu ms\n",
+                info.count, info.dropped, info.start, info.end, info.buildMs);
+  if (info.screened > 0) {
+    Serial.printf("%u satellite(s) never rise at this site\n", info.screened);
+  }
+  printSgp4CacheStatus();
+
+  uint32_t now = getGpsUnixTime();
+  PassQuery query;
+  query.from = now ? now : info.start;
+  query.to = info.end;
+  query.satCount = 0;
+
+  PassCursor cursor;
+  passCursorBegin(&query, &cursor);
+  PassEntry pass;
+  for (uint8_t shown = 0; shown < maxPasses && queryPasses(&query, &cursor, &pass, 1) == 1; shown++) {
+    long inMinutes = ((long)pass.aos - (long)query.from) / 60;
+    Serial.printf("  %-24s AOS %+5ld min  %3u s  Az %5.1f -> %5.1f  Max El %4.1f\n",
+                  getPassWatchName(pass.noradId), inMinutes, (unsigned)(pass.los - pass.aos),
+                  pass.aosAz / 10.0, pass.losAz / 10.0, pass.maxEl / 10.0);
+  }
+  Serial.println();
+}
@@ -0,0 +1,436 @@
+// ============================================================================
+// rotator_protocol.cpp - GS-232A/B and EasyComm II serial rotator protocols
+// ============================================================================
+
+#include "rotator_protocol.h"
+#include "shared_data.h"
+#include "motor_control.h"
+#include "serial_interface.h"
+#include "json_writer.h"
+
+// Bytes go through a small table-driven lexer (state x character class ->
+// next state + action) that assembles lines; each line is then matched
+// against the active protocol's command table. Replies are formatted on
+// the stack from the shared pose snapshot, so a position poll costs a few
+// microseconds and 10 Hz streaming from the PC is no load at all.
+//
+// GS-232A/B (one command per CR-terminated line):
+//   C / B / C2     report azimuth / elevation / both
+//   Maaa           move azimuth        Waaa eee   move both
+//   S / A / E      stop all / azimuth / elevation
+// EasyComm II (space-separated tokens, line ends with CR or LF):
+//   AZ / EL        report              AZx.x / ELx.x   move
+//   SA / SE        stop azimuth / elevation           VE   version
+
+// ============================================================================
+// LEXER
+// ============================================================================
+
+typedef enum {
+  LEX_IDLE = 0,          // Between lines
+  LEX_LINE,              // Collecting a line
+  LEX_DISCARD,           // Line too long, skip to its end
+  LEX_STATE_COUNT
+} LexState;
+
+typedef enum {
+  CH_TERMINATOR = 0,     // CR or LF
+  CH_PRINTABLE,
+  CH_OTHER,              // Other control characters (ignored)
+  CH_CLASS_COUNT
+} CharClass;
+
+typedef enum {
+  ACT_NONE = 0,
+  ACT_APPEND,
+  ACT_EXECUTE,
+  ACT_REJECT             // End of an over-long line
+} LexAction;
+
+struct LexTransition {
+  uint8_t next;
+  uint8_t action;
+};
+
+static const LexTransition lexTable[LEX_STATE_COUNT][CH_CLASS_COUNT] = {
+  //                 CH_TERMINATOR             CH_PRINTABLE              CH_OTHER
+  /* LEX_IDLE    */ {{LEX_IDLE, ACT_NONE},     {LEX_LINE, ACT_APPEND},    {LEX_IDLE, ACT_NONE}},
+  /* LEX_LINE    */ {{LEX_IDLE, ACT_EXECUTE},  {LEX_LINE, ACT_APPEND},    {LEX_LINE, ACT_NONE}},
+  /* LEX_DISCARD */ {{LEX_IDLE, ACT_REJECT},   {LEX_DISCARD, ACT_NONE},   {LEX_DISCARD, ACT_NONE}}
+};
+
+static CharClass classifyChar(char c) {
+  if (c == '\r' || c == '\n') return CH_TERMINATOR;
+  if (c >= 32 && c <= 126) return CH_PRINTABLE;
+  return CH_OTHER;
+}
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static RotatorProtocol activeProtocol = ROTATOR_PROTOCOL_NONE;
+static LexState lexState = LEX_IDLE;
+static char line[ROTATOR_LINE_SIZE];
+static uint8_t lineLen = 0;
+static uint8_t escapeMatched = 0;
+
+// Counters
+static uint32_t commandCount = 0;
+static uint32_t errorCount = 0;
+static uint32_t maxCommandUs = 0;
+
+static const char* protocolNames[ROTATOR_PROTOCOL_COUNT] = {
+  "CLI", "GS232A", "GS232B", "EASYCOMM"
+};
+
+// ============================================================================
+// POSITION HELPERS
+// ============================================================================
+
+static void getAntennaPosition(float* az, float* el) {
+  PoseSnapshot pose;
+  getPoseSnapshot(&pose);
+  *az = pose.antenna.azimuth;
+  *el = pose.antenna.elevation;
+}
+
+// Move one or both axes; NAN keeps the current target for that axis
+static bool moveTo(float az, float el) {
+  if (isEmergencyStop()) {
+    return false;
+  }
+  if (isnan(az)) az = targetPos.azimuth;
+  if (isnan(el)) el = targetPos.elevation;
+
+  if (az < 0.0f || az > 450.0f || el < MIN_ELEVATION || el > MAX_ELEVATION) {
+    return false;
+  }
+  if (az >= 360.0f) az -= 360.0f;  // GS-232 overlap range
+
+  setManualPosition(az, el);
+  return true;
+}
+
+// Hold the current position on the selected axes
+static void stopAxes(bool azimuth, bool elevation) {
+  float az, el;
+  getAntennaPosition(&az, &el);
+  if (azimuth && elevation) {
+    stopAllMotors();
+  }
+  setManualPosition(azimuth ? az : targetPos.azimuth, elevation ? el : targetPos.elevation);
+}
+
+// ============================================================================
+// GS-232A/B
+// ============================================================================
+
+typedef bool (*RotatorHandler)(const float* args, char* reply, size_t replySize);
+
+struct RotatorCommand {
+  const char* name;
+  uint8_t argCount;
+  RotatorHandler handler;
+};
+
+static int gsDegrees(float value) {
+  return constrain((int)lroundf(value), 0, 450);
+}
+
+static bool gsReportAz(const float* args, char* reply, size_t replySize) {
+  float az, el;
+  getAntennaPosition(&az, &el);
+  snprintf(reply, replySize, activeProtocol == ROTATOR_PROTOCOL_GS232A ? "+0%03d" : "AZ=%03d",
+           gsDegrees(az));
+  return true;
+}
+
+static bool gsReportEl(const float* args, char* reply, size_t replySize) {
+  float az, el;
+  getAntennaPosition(&az, &el);
+  snprintf(reply, replySize, activeProtocol == ROTATOR_PROTOCOL_GS232A ? "+0%03d" : "EL=%03d",
+           gsDegrees(el));
+  return true;
+}
+
+static bool gsReportBoth(const float* args, char* reply, size_t replySize) {
+  float az, el;
+  getAntennaPosition(&az, &el);
+  snprintf(reply, replySize,
+           activeProtocol == ROTATOR_PROTOCOL_GS232A ? "+0%03d+0%03d" : "AZ=%03d  EL=%03d",
+           gsDegrees(az), gsDegrees(el));
+  return true;
+}
+
+static bool gsMoveAz(const float* args, char* reply, size_t replySize) {
+  return moveTo(args[0], NAN);
+}
+
+static bool gsMoveBoth(const float* args, char* reply, size_t replySize) {
+  return moveTo(args[0], args[1]);
+}
+
+static bool gsStop(const float* args, char* reply, size_t replySize) {
+  stopAxes(true, true);
+  return true;
+}
+
+static bool gsStopAz(const float* args, char* reply, size_t replySize) {
+  stopAxes(true, false);
+  return true;
+}
+
+static bool gsStopEl(const float* args, char* reply, size_t replySize) {
+  stopAxes(false, true);
+  return true;
+}
+
+// Longer names first: matching is by prefix
+static const RotatorCommand gs232Commands[] = {
+  {"C2", 0, gsReportBoth},
+  {"C",  0, gsReportAz},
+  {"B",  0, gsReportEl},
+  {"W",  2, gsMoveBoth},
+  {"M",  1, gsMoveAz},
+  {"S",  0, gsStop},
+  {"A",  0, gsStopAz},
+  {"E",  0, gsStopEl}
+};
+
+#define GS232_COMMAND_COUNT (sizeof(gs232Commands) / sizeof(gs232Commands[0]))
+
+// Unsigned integer argument (GS-232 uses plain 3-digit degrees)
+static bool parseInteger(const char** text, float* value) {
+  const char* p = *text;
+  while (*p == ' ') p++;
+  if (*p < '0' || *p > '9') {
+    return false;
+  }
+  int result = 0;
+  while (*p >= '0' && *p <= '9' && result < 1000) {
+    result = result * 10 + (*p++ - '0');
+  }
+  *value = result;
+  *text = p;
+  return true;
+}
+
+static void executeGs232(const char* text) {
+  char reply[24] = "";
+  bool ok = false;
+
+  for (size_t i = 0; i < GS232_COMMAND_COUNT; i++) {
+    const RotatorCommand& command = gs232Commands[i];
+    size_t nameLen = strlen(command.name);
+    if (strncasecmp(text, command.name, nameLen) != 0) {
+      continue;
+    }
+
+    const char* p = text + nameLen;
+    float args[2];
+    ok = true;
+    for (uint8_t a = 0; a < command.argCount && ok; a++) {
+      ok = parseInteger(&p, &args[a]);
+    }
+    if (ok) {
+      ok = command.handler(args, reply, sizeof(reply));
+    }
+    break;
+  }
+
+  if (!ok) {
+    errorCount++;
+    Serial.print("?>\r\n");
+  } else if (reply[0]) {
+    Serial.print(reply);
+    Serial.print("\r\n");
+  }
+}
+
+// ============================================================================
+// EASYCOMM II
+// ============================================================================
+
+// Decimal number as sent by EasyComm clients ("123.4", "-0.5")
+static bool parseDecimal(const char* text, float* value) {
+  const char* p = text;
+  bool negative = (*p == '-');
+  if (*p == '-' || *p == '+') p++;
+
+  float result = 0.0f;
+  bool digits = false;
+  while (*p >= '0' && *p <= '9') {
+    result = result * 10.0f + (*p++ - '0');
+    digits = true;
+  }
+  if (*p == '.') {
+    p++;
+    float scale = 0.1f;
+    while (*p >= '0' && *p <= '9') {
+      result += (*p++ - '0') * scale;
+      scale *= 0.1f;
+      digits = true;
+    }
+  }
+  if (!digits || *p != '\0') {
+    return false;
+  }
+  *value = negative ? -result : result;
+  return true;
+}
+
+static void appendToken(char* reply, size_t replySize, const char* name, float value) {
+  size_t len = strlen(reply);
+  if (len && len + 1 < replySize) {
+    reply[len++] = ' ';
+    reply[len] = '\0';
+  }
+  char number[16];
+  if (formatFixed(number, sizeof(number), value, 1) == 0) {
+    strcpy(number, "0.0");
+  }
+  snprintf(reply + len, replySize - len, "%s%s", name, number);
+}
+
+static void executeEasyComm(char* text) {
+  char reply[48] = "";
+  float moveAz = NAN;
+  float moveEl = NAN;
+  bool ok = true;
+  float az, el;
+  getAntennaPosition(&az, &el);
+
+  for (char* token = strtok(text, " "); token; token = strtok(nullptr, " ")) {
+    if (strncasecmp(token, "AZ", 2) == 0) {
+      if (token[2] == '\0') {
+        appendToken(reply, sizeof(reply), "AZ", az);
+      } else {
+        ok &= parseDecimal(token + 2, &moveAz);
+      }
+    } else if (strncasecmp(token, "EL", 2) == 0) {
+      if (token[2] == '\0') {
+        appendToken(reply, sizeof(reply), "EL", el);
+      } else {
+        ok &= parseDecimal(token + 2, &moveEl);
+      }
+    } else if (strcasecmp(token, "SA") == 0) {
+      stopAxes(true, false);
+    } else if (strcasecmp(token, "SE") == 0) {
+      stopAxes(false, true);
+    } else if (strcasecmp(token, "VE") == 0) {
+      strncpy(reply, "VESatTracker", sizeof(reply) - 1);
+    } else {
+      ok = false;  // Unsupported token (UP/DN/DM...): skip, keep going
+    }
+  }
+
+  // One move for "AZx ELy" on the same line
+  if (!isnan(moveAz) || !isnan(moveEl)) {
+    while (!isnan(moveAz) && moveAz < 0.0f) moveAz += 360.0f;
+    ok &= moveTo(moveAz, moveEl);
+  }
+
+  if (!ok) {
+    errorCount++;
+  }
+  if (reply[0]) {
+    Serial.print(reply);
+    Serial.print("\n");
+  }
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+void setRotatorProtocol(RotatorProtocol protocol) {
+  if (protocol >= ROTATOR_PROTOCOL_COUNT) {
+    return;
+  }
+  activeProtocol = protocol;
+  lexState = LEX_IDLE;
+  lineLen = 0;
+  escapeMatched = 0;
+}
+
+RotatorProtocol getRotatorProtocol() {
+  return activeProtocol;
+}
+
+bool parseRotatorProtocol(const char* name, RotatorProtocol* protocol) {
+  for (int i = 0; i < ROTATOR_PROTOCOL_COUNT; i++) {
+    if (strcasecmp(name, protocolNames[i]) == 0) {
+      *protocol = (RotatorProtocol)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* rotatorProtocolName(RotatorProtocol protocol) {
+  return protocol < ROTATOR_PROTOCOL_COUNT ? protocolNames[protocol] : "?";
+}
+
+void feedRotatorProtocol(char c) {
+  if (activeProtocol == ROTATOR_PROTOCOL_NONE) {
+    return;
+  }
+
+  // Escape sequence back to the CLI
+  if (c == ROTATOR_ESCAPE[escapeMatched]) {
+    if (++escapeMatched == strlen(ROTATOR_ESCAPE)) {
+      setRotatorProtocol(ROTATOR_PROTOCOL_NONE);
+      Serial.println(F("\nCLI mode"));
+      Serial.print(F("> "));
+      return;
+    }
+  } else {
+    escapeMatched = (c == ROTATOR_ESCAPE[0]) ? 1 : 0;
+  }
+
+  const LexTransition& t = lexTable[lexState][classifyChar(c)];
+  lexState = (LexState)t.next;
+
+  switch (t.action) {
+    case ACT_APPEND:
+      if (lineLen < sizeof(line) - 1) {
+        line[lineLen++] = c;
+      } else {
+        lexState = LEX_DISCARD;
+      }
+      break;
+
+    case ACT_EXECUTE: {
+      line[lineLen] = '\0';
+      uint32_t start = micros();
+      if (activeProtocol == ROTATOR_PROTOCOL_EASYCOMM2) {
+        executeEasyComm(line);
+      } else {
+        executeGs232(line);
+      }
+      uint32_t elapsed = micros() - start;
+      if (elapsed > maxCommandUs) maxCommandUs = elapsed;
+      commandCount++;
+      lineLen = 0;
+      break;
+    }
+
+    case ACT_REJECT:
+      errorCount++;
+      lineLen = 0;
+      break;
+
+    default:
+      break;
+  }
+}
+
+void printRotatorProtocolStatus() {
+  Serial.println(F("\n=== ROTATOR PROTOCOL ==="));
+  Serial.printf("Mode: %s\n", rotatorProtocolName(activeProtocol));
+  Serial.printf("Commands: %lu, errors: %lu\n", commandCount, errorCount);
+  Serial.printf("Max command time: %lu us\n", maxCommandUs);
+  Serial.println(F("Protocols: CLI, GS232A, GS232B, EASYCOMM (exit with " ROTATOR_ESCAPE ")"));
+  Serial.println();
+}
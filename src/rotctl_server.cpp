@@ -0,0 +1,619 @@
+// ============================================================================
+// rotctl_server.cpp - Hamlib rotctld-compatible TCP rotator server
+// ============================================================================
+
+#include "rotctl_server.h"
+#include "shared_data.h"
+#include "motor_control.h"
+#include "json_writer.h"
+#include "heap_stats.h"
+#include <lwip/tcp.h>
+#include <LWIPMutex.h>
+
+// Same model as the HTTP server: lwIP callbacks only queue received
+// pbufs; pollRotctlServer() moves what fits into the line buffer, splits
+// lines, runs commands from a table and writes replies under the lwIP
+// lock. Data is acknowledged as it is moved, so a client that sends
+// faster than commands run is held back by the TCP window. Replies
+// are formatted on the stack with fixed-point numbers, so a command never
+// touches the heap.
+//
+// Protocol (as rotctld): one command per line, short form ("P 180 45")
+// or long form ("\set_pos 180 45"). Commands that return data print one
+// value per line; others print "RPRT <status>". A leading '+' selects
+// the extended reply format ("get_pos:\nAzimuth: ...\nRPRT 0\n").
+
+// Hamlib status codes (negated on the wire)
+#define RIG_OK 0
+#define RIG_EINVAL 1      // Invalid parameter
+#define RIG_ENIMPL 4      // Command not implemented
+#define RIG_ERJCTED 9     // Command rejected (emergency stop)
+
+#define ROTCTLD_PROT_VER 1
+#define ROTCTL_ROT_MODEL 2          // Hamlib "NET rotctl"
+#define ROTCTL_MAX_ARGS 2
+
+struct RotctlClient {
+  struct tcp_pcb* pcb;      // nullptr = slot free
+  unsigned long lastActivity;
+  bool peerClosed;
+  bool rxOverflow;          // Line longer than the buffer, skip to newline
+  struct pbuf* pending;     // Received, not yet in rx (window stays closed)
+  char rx[ROTCTL_RX_BUFFER_SIZE];
+  uint16_t rxLen;
+};
+
+// Reply being built for one command
+struct RotctlReply {
+  char text[ROTCTL_REPLY_SIZE];
+  size_t len;
+  bool extended;
+  bool hasValues;           // Command printed data (no RPRT on success)
+};
+
+typedef int (*RotctlHandler)(const float* args, RotctlReply* reply);
+
+struct RotctlCommand {
+  char shortName;           // 0 = long form only
+  const char* longName;
+  uint8_t argCount;
+  RotctlHandler handler;
+};
+
+static RotctlClient clients[ROTCTL_MAX_CLIENTS];
+static struct tcp_pcb* listenPcb = nullptr;
+
+// Counters
+static uint32_t commandCount = 0;
+static uint32_t errorCount = 0;
+static uint32_t rejectedCount = 0;       // No free client slot
+static uint32_t maxCommandUs = 0;
+static uint32_t allocatingCommands = 0;  // Should stay 0
+
+// ============================================================================
+// REPLY FORMATTING
+// ============================================================================
+
+static void replyText(RotctlReply* reply, const char* text) {
+  size_t len = strlen(text);
+  if (reply->len + len < sizeof(reply->text)) {
+    memcpy(reply->text + reply->len, text, len);
+    reply->len += len;
+  }
+}
+
+// One value line: "value\n", or "Label: value\n" in extended mode
+static void replyValue(RotctlReply* reply, const char* label, const char* value) {
+  if (reply->extended && label) {
+    replyText(reply, label);
+    replyText(reply, ": ");
+  }
+  replyText(reply, value);
+  replyText(reply, "\n");
+  reply->hasValues = true;
+}
+
+static void replyNumber(RotctlReply* reply, const char* label, float value) {
+  char number[24];
+  if (formatFixed(number, sizeof(number), value, 6) == 0) {
+    strcpy(number, "0.000000");
+  }
+  replyValue(reply, label, number);
+}
+
+static void replyInt(RotctlReply* reply, const char* label, int value) {
+  char number[12];
+  snprintf(number, sizeof(number), "%d", value);
+  replyValue(reply, label, number);
+}
+
+static void replyStatus(RotctlReply* reply, int status) {
+  char line[16];
+  snprintf(line, sizeof(line), "RPRT %d\n", -status);
+  replyText(reply, line);
+}
+
+// ============================================================================
+// COMMAND HANDLERS
+// ============================================================================
+
+static void holdPosition(float az, float el) {
+  trackerState.tracking = false;
+  targetPos.azimuth = az;
+  targetPos.elevation = el;
+  targetPos.valid = true;
+}
+
+static int cmdSetPos(const float* args, RotctlReply* reply) {
+  float az = args[0];
+  float el = args[1];
+
+  if (az < -180.0f || az > 450.0f || el < MIN_ELEVATION || el > MAX_ELEVATION) {
+    return RIG_EINVAL;
+  }
+  if (isEmergencyStop()) {
+    return RIG_ERJCTED;
+  }
+
+  // Clients may use -180..180 or 0..360; the motion layer uses 0..360
+  while (az < 0.0f) az += 360.0f;
+  while (az >= 360.0f) az -= 360.0f;
+
+  holdPosition(az, el);
+  return RIG_OK;
+}
+
+static int cmdGetPos(const float* args, RotctlReply* reply) {
+  PoseSnapshot pose;
+  getPoseSnapshot(&pose);
+  replyNumber(reply, "Azimuth", pose.antenna.azimuth);
+  replyNumber(reply, "Elevation", pose.antenna.elevation);
+  return RIG_OK;
+}
+
+static int cmdStop(const float* args, RotctlReply* reply) {
+  PoseSnapshot pose;
+  getPoseSnapshot(&pose);
+  stopAllMotors();
+  holdPosition(pose.antenna.azimuth, pose.antenna.elevation);
+  return RIG_OK;
+}
+
+static int cmdPark(const float* args, RotctlReply* reply) {
+  if (isEmergencyStop()) {
+    return RIG_ERJCTED;
+  }
+  holdPosition(PARK_AZIMUTH, PARK_ELEVATION);
+  return RIG_OK;
+}
+
+static int cmdGetInfo(const float* args, RotctlReply* reply) {
+  replyValue(reply, "Info", "Satellite Tracker RP2350");
+  return RIG_OK;
+}
+
+// Capabilities read by NET rotctl clients when they connect
+static int cmdDumpState(const float* args, RotctlReply* reply) {
+  replyInt(reply, nullptr, ROTCTLD_PROT_VER);
+  replyInt(reply, nullptr, ROTCTL_ROT_MODEL);
+  replyNumber(reply, "Minimum Azimuth", 0.0f);
+  replyNumber(reply, "Maximum Azimuth", 360.0f);
+  replyNumber(reply, "Minimum Elevation", MIN_ELEVATION);
+  replyNumber(reply, "Maximum Elevation", MAX_ELEVATION);
+  return RIG_OK;
+}
+
+static const RotctlCommand commandTable[] = {
+  {'P', "set_pos",    2, cmdSetPos},
+  {'p', "get_pos",    0, cmdGetPos},
+  {'S', "stop",       0, cmdStop},
+  {'K', "park",       0, cmdPark},
+  {'_', "get_info",   0, cmdGetInfo},
+  {0,   "dump_state", 0, cmdDumpState}
+};
+
+#define COMMAND_COUNT (sizeof(commandTable) / sizeof(commandTable[0]))
+
+// ============================================================================
+// PARSING
+// ============================================================================
+
+// Decimal number with optional sign, fraction and exponent. Used instead
+// of strtod(), which allocates in newlib.
+static bool parseNumber(const char** text, float* value) {
+  const char* p = *text;
+  bool negative = false;
+  if (*p == '+' || *p == '-') {
+    negative = (*p == '-');
+    p++;
+  }
+
+  double result = 0.0;
+  bool digits = false;
+  while (*p >= '0' && *p <= '9') {
+    result = result * 10.0 + (*p++ - '0');
+    digits = true;
+  }
+  if (*p == '.' || *p == ',') {
+    p++;
+    double scale = 0.1;
+    while (*p >= '0' && *p <= '9') {
+      result += (*p++ - '0') * scale;
+      scale *= 0.1;
+      digits = true;
+    }
+  }
+  if (!digits) {
+    return false;
+  }
+  if (*p == 'e' || *p == 'E') {
+    const char* exp = p + 1;
+    bool expNegative = (*exp == '-');
+    if (*exp == '+' || *exp == '-') exp++;
+    if (*exp >= '0' && *exp <= '9') {
+      int e = 0;
+      while (*exp >= '0' && *exp <= '9') {
+        if (e < 99) e = e * 10 + (*exp - '0');
+        exp++;
+      }
+      while (e--) {
+        result = expNegative ? result * 0.1 : result * 10.0;
+      }
+      p = exp;
+    }
+  }
+
+  *value = negative ? -result : result;
+  *text = p;
+  return true;
+}
+
+static const char* skipSpaces(const char* p) {
+  while (*p == ' ' || *p == '\t') p++;
+  return p;
+}
+
+static const RotctlCommand* findCommand(const char** text) {
+  const char* p = *text;
+
+  if (*p == '\\') {
+    p++;
+    size_t len = 0;
+    while (p[len] && p[len] != ' ' && p[len] != '\t') len++;
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+      const char* name = commandTable[i].longName;
+      if (strlen(name) == len && strncmp(name, p, len) == 0) {
+        *text = p + len;
+        return &commandTable[i];
+      }
+    }
+    return nullptr;
+  }
+
+  for (size_t i = 0; i < COMMAND_COUNT; i++) {
+    if (commandTable[i].shortName && commandTable[i].shortName == *p) {
+      *text = p + 1;
+      return &commandTable[i];
+    }
+  }
+  return nullptr;
+}
+
+// Run one command line and build its reply. Returns false for quit.
+static bool executeLine(const char* line, RotctlReply* reply) {
+  reply->len = 0;
+  reply->hasValues = false;
+  reply->extended = false;
+
+  const char* p = skipSpaces(line);
+  if (*p == '+') {
+    reply->extended = true;
+    p++;
+  }
+  if (*p == 'q' || *p == 'Q') {
+    return false;
+  }
+
+  const RotctlCommand* command = findCommand(&p);
+  if (!command) {
+    errorCount++;
+    replyStatus(reply, RIG_ENIMPL);
+    return true;
+  }
+
+  float args[ROTCTL_MAX_ARGS];
+  const char* argText = skipSpaces(p);
+  int status = RIG_OK;
+  for (uint8_t i = 0; i < command->argCount; i++) {
+    p = skipSpaces(p);
+    if (!parseNumber(&p, &args[i])) {
+      status = RIG_EINVAL;
+      break;
+    }
+  }
+
+  if (reply->extended) {
+    replyText(reply, command->longName);
+    replyText(reply, ":");
+    if (command->argCount && *argText) {
+      replyText(reply, " ");
+      replyText(reply, argText);
+    }
+    replyText(reply, "\n");
+  }
+
+  if (status == RIG_OK) {
+    status = command->handler(args, reply);
+  }
+  if (status != RIG_OK) {
+    errorCount++;
+  }
+
+  // Data commands answer with their values alone unless extended or failed
+  if (reply->extended || status != RIG_OK || !reply->hasValues) {
+    replyStatus(reply, status);
+  }
+
+  return true;
+}
+
+// ============================================================================
+// CONNECTION HANDLING
+// ============================================================================
+
+static void freePending(RotctlClient* client) {
+  if (client->pending) {
+    pbuf_free(client->pending);
+    client->pending = nullptr;
+  }
+}
+
+// Move as much pending data into rx as fits and open the receive window
+// by the same amount
+static void pullReceived(RotctlClient* client) {
+  if (!client->pending) {
+    return;
+  }
+  uint16_t n = min((uint16_t)(ROTCTL_RX_BUFFER_SIZE - client->rxLen), client->pending->tot_len);
+  if (n == 0) {
+    return;
+  }
+  pbuf_copy_partial(client->pending, client->rx + client->rxLen, n, 0);
+  client->rxLen += n;
+  client->pending = pbuf_free_header(client->pending, n);
+  tcp_recved(client->pcb, n);
+}
+
+static void closeClient(RotctlClient* client) {
+  freePending(client);
+  struct tcp_pcb* pcb = client->pcb;
+  if (pcb) {
+    tcp_arg(pcb, nullptr);
+    tcp_recv(pcb, nullptr);
+    tcp_err(pcb, nullptr);
+    tcp_poll(pcb, nullptr, 0);
+    if (tcp_close(pcb) != ERR_OK) {
+      tcp_abort(pcb);
+    }
+  }
+  client->pcb = nullptr;
+}
+
+// Execute up to ROTCTL_MAX_LINES_PER_POLL complete lines
+static void serviceClient(RotctlClient* client) {
+  pullReceived(client);
+
+  for (int n = 0; n < ROTCTL_MAX_LINES_PER_POLL; n++) {
+    char* end = (char*)memchr(client->rx, '\n', client->rxLen);
+    if (!end) {
+      if (client->rxLen < ROTCTL_RX_BUFFER_SIZE) {
+        break;
+      }
+      // One line fills the buffer: discard it and report it when it ends
+      client->rxOverflow = true;
+      client->rxLen = 0;
+      pullReceived(client);
+      continue;
+    }
+    // Wait for send space rather than drop a reply
+    if (tcp_sndbuf(client->pcb) < ROTCTL_REPLY_SIZE) {
+      break;
+    }
+
+    size_t lineLen = end - client->rx;
+    *end = '\0';
+    if (lineLen && client->rx[lineLen - 1] == '\r') {
+      client->rx[lineLen - 1] = '\0';
+    }
+
+    uint32_t start = micros();
+    uint32_t allocsBefore = getHeapAllocCount();
+
+    RotctlReply reply;
+    bool keepOpen = true;
+    if (client->rxOverflow) {
+      client->rxOverflow = false;
+      reply.len = 0;
+      replyStatus(&reply, RIG_EINVAL);
+    } else if (client->rx[0] != '\0') {
+      keepOpen = executeLine(client->rx, &reply);
+      commandCount++;
+    } else {
+      reply.len = 0;
+    }
+
+    if (getHeapAllocCount() != allocsBefore) {
+      allocatingCommands++;
+    }
+
+    // Drop the line from the buffer
+    size_t consumed = lineLen + 1;
+    memmove(client->rx, client->rx + consumed, client->rxLen - consumed);
+    client->rxLen -= consumed;
+    pullReceived(client);
+
+    if (!keepOpen) {
+      closeClient(client);
+      return;
+    }
+
+    if (reply.len) {
+      if (tcp_write(client->pcb, reply.text, reply.len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+        closeClient(client);
+        return;
+      }
+      tcp_output(client->pcb);
+    }
+
+    uint32_t elapsed = micros() - start;
+    if (elapsed > maxCommandUs) maxCommandUs = elapsed;
+  }
+
+  if (client->peerClosed && !client->pending && !memchr(client->rx, '\n', client->rxLen)) {
+    closeClient(client);
+  }
+}
+
+// ============================================================================
+// LWIP CALLBACKS
+// ============================================================================
+
+static void rotctlErr(void* arg, err_t err) {
+  // The pcb is already freed by lwIP
+  RotctlClient* client = (RotctlClient*)arg;
+  if (client) {
+    freePending(client);
+    client->pcb = nullptr;
+  }
+}
+
+static err_t rotctlRecv(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err) {
+  RotctlClient* client = (RotctlClient*)arg;
+
+  if (!p) {
+    client->peerClosed = true;
+    return ERR_OK;
+  }
+
+  // Held until pollRotctlServer() has room for it
+  if (client->pending) {
+    pbuf_cat(client->pending, p);
+  } else {
+    client->pending = p;
+  }
+  client->lastActivity = millis();
+  return ERR_OK;
+}
+
+static err_t rotctlPoll(void* arg, struct tcp_pcb* pcb) {
+  RotctlClient* client = (RotctlClient*)arg;
+  if (millis() - client->lastActivity > ROTCTL_IDLE_TIMEOUT_MS) {
+    tcp_arg(pcb, nullptr);
+    tcp_err(pcb, nullptr);
+    tcp_abort(pcb);
+    freePending(client);
+    client->pcb = nullptr;
+    return ERR_ABRT;
+  }
+  return ERR_OK;
+}
+
+static err_t rotctlAccept(void* arg, struct tcp_pcb* pcb, err_t err) {
+  if (err != ERR_OK || !pcb) {
+    return ERR_VAL;
+  }
+
+  RotctlClient* client = nullptr;
+  for (int i = 0; i < ROTCTL_MAX_CLIENTS; i++) {
+    if (!clients[i].pcb) {
+      client = &clients[i];
+      break;
+    }
+  }
+
+  if (!client) {
+    rejectedCount++;
+    tcp_abort(pcb);
+    return ERR_ABRT;
+  }
+
+  client->pcb = pcb;
+  client->lastActivity = millis();
+  client->peerClosed = false;
+  client->rxOverflow = false;
+  client->pending = nullptr;
+  client->rxLen = 0;
+
+  tcp_arg(pcb, client);
+  tcp_recv(pcb, rotctlRecv);
+  tcp_err(pcb, rotctlErr);
+  tcp_poll(pcb, rotctlPoll, 10);  // Every 5 s
+  tcp_nagle_disable(pcb);         // Replies are tiny; send them at once
+  return ERR_OK;
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+bool startRotctlServer(uint16_t port) {
+  if (listenPcb) {
+    return true;
+  }
+
+  LWIPMutex m;
+  struct tcp_pcb* pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  if (!pcb) {
+    Serial.println("ERROR: rotctl server could not allocate pcb");
+    return false;
+  }
+
+  if (tcp_bind(pcb, IP_ANY_TYPE, port) != ERR_OK) {
+    Serial.printf("ERROR: rotctl server could not bind port %d\n", port);
+    tcp_close(pcb);
+    return false;
+  }
+
+  listenPcb = tcp_listen_with_backlog(pcb, ROTCTL_MAX_CLIENTS);
+  if (!listenPcb) {
+    tcp_close(pcb);
+    return false;
+  }
+  tcp_accept(listenPcb, rotctlAccept);
+
+  Serial.printf("rotctl server listening on port %d\n", port);
+  return true;
+}
+
+void stopRotctlServer() {
+  LWIPMutex m;
+
+  for (int i = 0; i < ROTCTL_MAX_CLIENTS; i++) {
+    if (clients[i].pcb) {
+      closeClient(&clients[i]);
+    }
+  }
+
+  if (listenPcb) {
+    tcp_close(listenPcb);
+    listenPcb = nullptr;
+  }
+}
+
+bool isRotctlServerRunning() {
+  return listenPcb != nullptr;
+}
+
+void pollRotctlServer() {
+  if (!listenPcb) {
+    return;
+  }
+
+  for (int i = 0; i < ROTCTL_MAX_CLIENTS; i++) {
+    if (!clients[i].pcb) {
+      continue;
+    }
+    LWIPMutex m;
+    serviceClient(&clients[i]);
+  }
+}
+
+void printRotctlServerStatus() {
+  Serial.println(F("\n=== ROTCTL SERVER ==="));
+  Serial.printf("Listening: %s\n", listenPcb ? "YES" : "NO");
+
+  for (int i = 0; i < ROTCTL_MAX_CLIENTS; i++) {
+    const RotctlClient& client = clients[i];
+    if (client.pcb) {
+      Serial.printf("  Client %d: connected, idle %lu ms\n", i, millis() - client.lastActivity);
+    } else {
+      Serial.printf("  Client %d: free\n", i);
+    }
+  }
+
+  Serial.printf("Commands: %lu, errors: %lu, rejected clients: %lu\n",
+                commandCount, errorCount, rejectedCount);
+  Serial.printf("Max command time: %lu us\n", maxCommandUs);
+  Serial.printf("Commands that allocated: %lu\n", allocatingCommands);
+  Serial.println();
+}
@@ -3,6 +3,14 @@
 // ============================================================================
 
 #include "serial_interface.h"
+#include "input_debounce.h"
+#include "http_server.h"
+#include "heap_stats.h"
+#include "rotator_protocol.h"
+#include "tle_catalog.h"
+#include "pass_cache.h"
+#include "metrics.h"
+#include "binary_link.h"
 
 // External references to shared data
 extern MotorPosition motorPos;
@@ -22,284 +30,322 @@ extern LEDMode getLEDMode();
 static char cmdBuffer[SERIAL_BUFFER_SIZE];
 static uint8_t cmdBufferPos = 0;
 
-// Mode flags
-static bool streamingGPS = false;
-static unsigned long streamStartTime = 0;
-static unsigned long streamDuration = 0;
+// CLI session state. Prompts, streams and uploads are modal states that
+// updateSerialInterface() advances a little per call; nothing in here
+// waits for input or sleeps.
+typedef enum {
+  CLI_COMMAND = 0,         // Line editor, lines are commands
+  CLI_PROMPT,              // Line editor, next line answers a prompt
+  CLI_STREAM,              // Periodic output until done or any key
+  CLI_CATALOG_LOAD         // Raw 3LE upload
+} CliState;
+
+// Answer to a prompt; nullptr when it timed out
+typedef void (*PromptHandler)(const char* line);
+
+// One row of periodic output
+typedef void (*StreamTick)(int index);
+
+#define SERIAL_MAX_CHARS_PER_UPDATE 64   // Bounds the time spent per call
+#define CONFIRM_TIMEOUT_MS 10000
+#define TLE_PROMPT_TIMEOUT_MS 30000
+
+static CliState cliState = CLI_COMMAND;
+
+static PromptHandler promptHandler = nullptr;
+static unsigned long promptStart = 0;
+static unsigned long promptTimeout = 0;
+
+// Yes/no confirmation (built on the prompt)
+static void (*confirmAction)() = nullptr;
+static bool confirmFullYes = false;      // Only "YES" accepted, not "Y"
+
+static StreamTick streamTick = nullptr;
+static int streamIndex = 0;
+static int streamCount = 0;
+static unsigned long streamInterval = 0;
+static unsigned long streamLast = 0;
+static const char* streamDoneText = nullptr;
+
+// SETTLE: name and line 1 held while line 2 is prompted for
+static char pendingTleName[25];
+static char pendingTleLine1[70];
+
+// Catalog upload (CATLOAD): raw 3LE text until Ctrl-D or a pause
+#define CATALOG_LOAD_END 0x04            // Ctrl-D
+#define CATALOG_LOAD_IDLE_MS 3000        // Pause that ends the upload
+#define CATALOG_LOAD_START_MS 60000      // Wait for the first byte
+#define CATALOG_BUILD_POLL_MS 100        // Then poll the build job
+#define CATALOG_BUILD_POLL_LIMIT 3000    // Stop waiting after 5 minutes
+static bool catalogLoadData = false;
+static unsigned long catalogLoadLast = 0;
 
 // ============================================================================
 // INTERNAL FUNCTIONS
 // ============================================================================
 
-// Parse command line into command and arguments
-static bool parseCommand(const char* input, SerialCommand* cmd) {
-  memset(cmd, 0, sizeof(SerialCommand));
-  
-  // Find first space or end of string
-  const char* space = strchr(input, ' ');
-  
-  if (space) {
-    // Command with arguments
-    size_t cmdLen = space - input;
-    if (cmdLen >= sizeof(cmd->command)) cmdLen = sizeof(cmd->command) - 1;
-    
-    strncpy(cmd->command, input, cmdLen);
-    cmd->command[cmdLen] = '\0';
+// Parse one argument of type 'type' (upper-case schema letter)
+static bool parseArg(char type, const char* text, CommandArg* arg) {
+  char* end;
+  arg->s = text;
+  switch (type) {
+    case 'I':
+      arg->i = strtol(text, &end, 10);
+      arg->f = arg->i;
+      return end != text && *end == '\0';
+    case 'F':
+      arg->f = strtod(text, &end);
+      arg->i = (long)arg->f;
+      return end != text && *end == '\0';
+    default:
+      return true;
+  }
+}
+
+// Split 'args' in place according to the command's schema. Returns false
+// on a missing, malformed or surplus argument.
+static bool parseArgs(const char* schema, char* args, CommandArgs* out) {
+  memset(out, 0, sizeof(CommandArgs));
+  char* p = args;
+  
+  for (const char* t = schema; *t; t++) {
+    while (*p == ' ') p++;
+    if (*p == '\0') {
+      return islower(*t);  // Only optional arguments may be left out
+    }
     
-    // Skip leading spaces in arguments
-    space++;
-    while (*space == ' ') space++;
+    char type = toupper(*t);
+    char* token = p;
+    if (type == 'T') {
+      // Rest of the line, trailing spaces trimmed
+      p += strlen(p);
+      while (p > token && p[-1] == ' ') p--;
+      *p = '\0';
+    } else {
+      while (*p && *p != ' ') p++;
+      if (*p) *p++ = '\0';
+    }
     
-    strncpy(cmd->args, space, sizeof(cmd->args) - 1);
-    cmd->args[sizeof(cmd->args) - 1] = '\0';
-  } else {
-    // Command without arguments
-    strncpy(cmd->command, input, sizeof(cmd->command) - 1);
-    cmd->command[sizeof(cmd->command) - 1] = '\0';
+    if (!parseArg(type, token, &out->arg[out->count])) {
+      return false;
+    }
+    out->count++;
   }
   
-  return true;
+  while (*p == ' ') p++;
+  return *p == '\0';
 }
 
-// Convert string to uppercase
-static void toUpperCase(char* str) {
-  while (*str) {
-    *str = toupper(*str);
-    str++;
+static void processCommand(char* input);
+
+// Next line of input goes to 'handler' (or nullptr after 'timeoutMs')
+static void beginPrompt(PromptHandler handler, unsigned long timeoutMs) {
+  promptHandler = handler;
+  promptStart = millis();
+  promptTimeout = timeoutMs;
+  cliState = CLI_PROMPT;
+}
+
+static void confirmAnswer(const char* line) {
+  bool yes = line && (strcasecmp(line, "YES") == 0 ||
+                      (!confirmFullYes && strcasecmp(line, "Y") == 0));
+  if (yes) {
+    confirmAction();
+  } else {
+    Serial.println(line ? F("Cancelled") : F("Cancelled (no answer)"));
   }
 }
 
-// Check if strings match (case insensitive)
-static bool commandMatches(const char* cmd, const char* match) {
-  char temp[32];
-  strncpy(temp, cmd, sizeof(temp) - 1);
-  temp[sizeof(temp) - 1] = '\0';
-  toUpperCase(temp);
-  return strcmp(temp, match) == 0;
+// Ask 'question'; 'action' runs if the answer is YES (or Y unless
+// 'fullYes')
+static void beginConfirm(const char* question, bool fullYes, void (*action)()) {
+  Serial.println(question);
+  confirmAction = action;
+  confirmFullYes = fullYes;
+  beginPrompt(confirmAnswer, CONFIRM_TIMEOUT_MS);
 }
 
-// ============================================================================
-// COMMAND HANDLERS
-// ============================================================================
+// Call 'tick' 'count' times, 'intervalMs' apart, starting now
+static void beginStream(StreamTick tick, int count, unsigned long intervalMs, const char* doneText) {
+  streamTick = tick;
+  streamIndex = 0;
+  streamCount = count;
+  streamInterval = intervalMs;
+  streamLast = millis() - intervalMs;
+  streamDoneText = doneText;
+  cliState = CLI_STREAM;
+}
 
-static void handleHelpCommand() {
-  Serial.println(F("\n=== AVAILABLE COMMANDS ==="));
-  Serial.println();
-  
-  Serial.println(F("System Status:"));
-  Serial.println(F("  STATUS       - Full system status"));
-  Serial.println(F("  GPS          - GPS status and data"));
-  Serial.println(F("  COMPASS      - Compass status and heading"));
-  Serial.println(F("  JOYSTICK     - Joystick status and values"));
-  Serial.println(F("  MOTORS       - Motor positions and status"));
-  Serial.println(F("  WIFI         - WiFi status"));
-  Serial.println(F("  STORAGE      - Storage info"));
-  Serial.println();
-  
-  Serial.println(F("WiFi Configuration:"));
-  Serial.println(F("  SETWIFI <ssid> <password>  - Set WiFi credentials"));
-  Serial.println(F("  Example: SETWIFI MyNetwork MyPassword123"));
-  Serial.println();
-  
-  Serial.println(F("Calibration:"));
-  Serial.println(F("  CALCMP       - Start compass calibration"));
-  Serial.println(F("  CALSTOP      - Stop compass calibration"));
-  Serial.println(F("  CALJOY       - Start joystick calibration"));
-  Serial.println(F("  CALJOYSTOP   - Stop joystick calibration"));
-  Serial.println();
-  
-  Serial.println(F("Configuration:"));
-  Serial.println(F("  SAVE         - Save config to storage"));
-  Serial.println(F("  LOAD         - Load config from storage"));
-  Serial.println(F("  ERASE        - Erase stored config"));
-  Serial.println();
+// Lets a tick finish its stream before 'count' ticks
+static void endStream() {
+  streamCount = 0;
+}
+
+static void updateStream() {
+  // Any key stops the stream early (not the LF of the command's CRLF)
+  bool stop = false;
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c != '\r' && c != '\n') {
+      stop = true;
+    }
+  }
   
-  Serial.println(F("Control:"));
-  Serial.println(F("  HOME         - Home all axes"));
-  Serial.println(F("  STOP         - Stop tracking"));
-  Serial.println(F("  ESTOP        - Emergency stop"));
-  Serial.println(F("  RESET        - Reset emergency stop"));
-  Serial.println(F("  GOTO <az> <el>  - Move to position (deg)"));
-  Serial.println(F("  Example: GOTO 180 45"));
-  Serial.println();
+  if (!stop && millis() - streamLast >= streamInterval) {
+    streamLast = millis();
+    streamTick(streamIndex++);
+  }
   
-  Serial.println(F("TLE Management:"));
-  Serial.println(F("  SHOWTLE      - Display current TLE"));
-  Serial.println(F("  SETTLE <name>  - Enter TLE (next 2 lines)"));
-  Serial.println(F("  Example: SETTLE ISS"));
-  Serial.println(F("           1 25544U 98067A   ...(line 1)"));
-  Serial.println(F("           2 25544  51.6416 ...(line 2)"));
-  Serial.println();
+  if (stop || streamIndex >= streamCount) {
+    cliState = CLI_COMMAND;
+    if (streamDoneText) {
+      Serial.println(streamDoneText);
+    }
+    Serial.println();
+    Serial.print(F("> "));
+  }
+}
+
+// Hand a finished input line to the command dispatcher or the prompt
+static void processLine(char* line) {
+  if (cliState != CLI_PROMPT) {
+    processCommand(line);
+    return;
+  }
   
-  Serial.println(F("Diagnostics:"));
-  Serial.println(F("  RAWCMP <n>   - Print n compass readings"));
-  Serial.println(F("  RAWJOY <n>   - Print n joystick readings"));
-  Serial.println(F("  ENCODER      - Print encoder counts"));
-  Serial.println(F("  STREAM <sec> - Stream GPS data for n seconds"));
-  Serial.println(F("  LEDTEST      - Run LED ring test sequence"));
-  Serial.println(F("  LEDMODE <n>  - Set LED mode (0-6)"));
-  Serial.println(F("  LEDINFO      - Show LED status"));
-  Serial.println();
+  // Trim the answer
+  while (*line == ' ') line++;
+  size_t len = strlen(line);
+  while (len > 0 && line[len - 1] == ' ') line[--len] = '\0';
   
-  Serial.println(F("Other:"));
-  Serial.println(F("  HELP         - This help message"));
-  Serial.println(F("  BANNER       - System banner"));
-  Serial.println();
+  // The handler may open the next prompt
+  cliState = CLI_COMMAND;
+  promptHandler(line);
 }
 
-static void handleStatusCommand() {
+// ============================================================================
+// COMMAND HANDLERS
+// ============================================================================
+
+static void handleHelpCommand(const CommandArgs* args);
+
+static void handleStatusCommand(const CommandArgs* args) {
   printSystemStatus();
 }
 
-static void handleGPSCommand(const char* args) {
-  if (args != nullptr && strlen(args) > 0) {
-    unsigned long duration = atoi(args);
-    if (duration == 0) {
-      Serial.println(F("ERROR: Invalid duration for STREAM command"));
-    }
-    connectionTest();
-  } else {
+// First tick starts the connection test, the last one reports it
+static void gpsTestTick(int index) {
+  if (index == 0) {
+    beginConnectionTest();
+  } else if (index == streamCount - 1) {
+    endConnectionTest();
+  }
+}
+
+static void handleGPSCommand(const CommandArgs* args) {
+  if (args->count == 0) {
     printGPSStatus();
+    return;
+  }
+  if (args->arg[0].i <= 0) {
+    Serial.println(F("ERROR: Invalid duration for GPS test"));
+    return;
   }
   
-  
-
+  int seconds = constrain(args->arg[0].i, 1, 60);
+  beginStream(gpsTestTick, seconds + 1, 1000, nullptr);
 }
 
-static void handleCompassCommand() {
+static void handleCompassCommand(const CommandArgs* args) {
   printCompassStatus();
 }
 
-static void handleJoystickCommand() {
+static void handleJoystickCommand(const CommandArgs* args) {
   printJoystickStatus();
 }
 
-static void handleMotorsCommand() {
+static void handleMotorsCommand(const CommandArgs* args) {
   printMotorStatus();
 }
 
-static void handleWiFiCommand() {
+static void handleWiFiCommand(const CommandArgs* args) {
   printWiFiStatus();
 }
 
-static void handleStorageCommand() {
+static void handleStorageCommand(const CommandArgs* args) {
   printStorageStatus();
 }
 
-static void handleSetWiFiCommand(const char* args) {
-  // Parse SSID and password from arguments
-  char ssid[32] = "";
-  char password[64] = "";
-  
-  // Find first space (separates SSID from password)
-  const char* space = strchr(args, ' ');
-  
-  if (!space) {
-    Serial.println(F("ERROR: Usage: SETWIFI <ssid> <password>"));
-    return;
-  }
-  
-  size_t ssidLen = space - args;
-  if (ssidLen >= sizeof(ssid)) ssidLen = sizeof(ssid) - 1;
-  
-  strncpy(ssid, args, ssidLen);
-  ssid[ssidLen] = '\0';
-  
-  // Skip spaces
-  space++;
-  while (*space == ' ') space++;
-  
-  strncpy(password, space, sizeof(password) - 1);
-  password[sizeof(password) - 1] = '\0';
-  
-  if (strlen(ssid) == 0 || strlen(password) == 0) {
-    Serial.println(F("ERROR: SSID and password cannot be empty"));
-    return;
-  }
-  
-  setWiFiCredentials(ssid, password);
-  Serial.println(F("WiFi credentials updated"));
-  Serial.println(F("Use SAVE to persist, or restart to apply"));
+static void handleSetWiFiCommand(const CommandArgs* args) {
+  // Password is the rest of the line, so it may contain spaces
+  setWiFiCredentials(args->arg[0].s, args->arg[1].s);
+  reconnectWiFi();
+  Serial.println(F("WiFi credentials updated, connecting in the background"));
+  Serial.println(F("Use SAVE to persist"));
 }
 
-static void handleSaveCommand() {
+static void handleSaveCommand(const CommandArgs* args) {
   saveConfiguration();
 }
 
-static void handleLoadCommand() {
+static void handleSyncCommand(const CommandArgs* args) {
+  if (!isConfigDirty()) {
+    Serial.println(F("No pending configuration changes"));
+  } else if (flushConfig()) {
+    Serial.println(F("Configuration written to flash"));
+  } else {
+    Serial.println(F("ERROR: Failed to write configuration"));
+  }
+}
+
+static void handleLoadCommand(const CommandArgs* args) {
   loadConfiguration();
 }
 
-static void handleEraseCommand() {
+static void handleEraseCommand(const CommandArgs* args) {
   Serial.println(F("WARNING: This will erase all stored configuration!"));
-  Serial.println(F("Type 'YES' to confirm:"));
-  
-  unsigned long timeout = millis() + 10000; // 10 second timeout
-  String response = "";
-  
-  while (millis() < timeout) {
-    if (Serial.available()) {
-      char c = Serial.read();
-      if (c == '\n' || c == '\r') {
-        break;
-      }
-      response += c;
-    }
-  }
-  
-  response.trim();
-  if (response.equalsIgnoreCase("YES")) {
-    eraseConfiguration();
-    Serial.println(F("Configuration erased"));
-  } else {
-    Serial.println(F("Cancelled"));
-  }
+  beginConfirm("Type 'YES' to confirm:", true, eraseConfiguration);
 }
 
-static void handleCalCmpCommand() {
+static void handleCalCmpCommand(const CommandArgs* args) {
   beginCompassCalibration();
 }
 
-static void handleCalStopCommand() {
+static void handleCalStopCommand(const CommandArgs* args) {
   endCompassCalibration();
 }
 
-static void handleCalJoyCommand() {
+static void handleCalJoyCommand(const CommandArgs* args) {
   beginJoystickCalibration();
 }
 
-static void handleCalJoyStopCommand() {
-  stopJoystickCalibration();
+static void handleCalJoyStopCommand(const CommandArgs* args) {
+  endJoystickCalibration();
 }
 
-static void handleHomeCommand() {
+static void handleHomeCommand(const CommandArgs* args) {
   Serial.println(F("Homing axes..."));
   beginHomeAxes();
 }
 
-static void handleStopCommand() {
+static void handleStopCommand(const CommandArgs* args) {
   Serial.println(F("Stopping tracking..."));
   endTracking();
 }
 
-static void handleEStopCommand() {
+static void handleEStopCommand(const CommandArgs* args) {
   Serial.println(F("EMERGENCY STOP ACTIVATED"));
   beginEmergencyStop();
 }
 
-static void handleResetCommand() {
+static void handleResetCommand(const CommandArgs* args) {
   Serial.println(F("Resetting emergency stop..."));
   beginResetEmergencyStop();
 }
 
-static void handleGotoCommand(const char* args) {
-  float az, el;
-  
-  if (sscanf(args, "%f %f", &az, &el) != 2) {
-    Serial.println(F("ERROR: Usage: GOTO <azimuth> <elevation>"));
-    Serial.println(F("Example: GOTO 180 45"));
-    return;
-  }
+static void handleGotoCommand(const CommandArgs* args) {
+  float az = args->arg[0].f;
+  float el = args->arg[1].f;
   
   if (az < 0 || az >= 360) {
     Serial.println(F("ERROR: Azimuth must be 0-359.99"));
@@ -315,211 +361,609 @@ static void handleGotoCommand(const char* args) {
   Serial.printf("Moving to Az=%.2f El=%.2f\n", az, el);
 }
 
-static void handleShowTLECommand() {
+static void handleShowTLECommand(const CommandArgs* args) {
   printTLE();
 }
 
-static void handleSetTLECommand(const char* args) {
-  if (strlen(args) == 0) {
-    Serial.println(F("ERROR: Usage: SETTLE <satellite name>"));
-    Serial.println(F("Then enter TLE line 1 and line 2"));
+static void settleLine2(const char* line) {
+  if (!line) {
+    Serial.println(F("ERROR: Timed out waiting for TLE line 2"));
     return;
   }
-  
-  char name[25];
-  strncpy(name, args, sizeof(name) - 1);
-  name[sizeof(name) - 1] = '\0';
-  
-  Serial.println(F("Enter TLE Line 1:"));
-  
-  // Wait for line 1
-  unsigned long timeout = millis() + 30000;
-  String line1 = "";
-  while (millis() < timeout && line1.length() == 0) {
-    if (Serial.available()) {
-      line1 = Serial.readStringUntil('\n');
-      line1.trim();
-    }
-  }
-  
-  if (line1.length() != 69) {
-    Serial.println(F("ERROR: TLE line 1 must be exactly 69 characters"));
+  if (strlen(line) != 69) {
+    Serial.println(F("ERROR: TLE line 2 must be exactly 69 characters"));
     return;
   }
   
-  Serial.println(F("Enter TLE Line 2:"));
-  
-  // Wait for line 2
-  timeout = millis() + 30000;
-  String line2 = "";
-  while (millis() < timeout && line2.length() == 0) {
-    if (Serial.available()) {
-      line2 = Serial.readStringUntil('\n');
-      line2.trim();
-    }
+  char error[64];
+  if (!validateTle(pendingTleLine1, line, error, sizeof(error))) {
+    Serial.printf("ERROR: %s\n", error);
+    return;
   }
   
-  if (line2.length() != 69) {
-    Serial.println(F("ERROR: TLE line 2 must be exactly 69 characters"));
+  setTLE(pendingTleName, pendingTleLine1, line);
+  Serial.println(F("TLE updated"));
+}
+
+static void settleLine1(const char* line) {
+  if (!line) {
+    Serial.println(F("ERROR: Timed out waiting for TLE line 1"));
     return;
   }
-  
-  if (line1[0] != '1' || line2[0] != '2') {
-    Serial.println(F("ERROR: Invalid TLE format"));
+  if (strlen(line) != 69) {
+    Serial.println(F("ERROR: TLE line 1 must be exactly 69 characters"));
     return;
   }
   
-  setTLE(name, line1.c_str(), line2.c_str());
-  Serial.println(F("TLE updated"));
+  strcpy(pendingTleLine1, line);
+  Serial.println(F("Enter TLE Line 2:"));
+  beginPrompt(settleLine2, TLE_PROMPT_TIMEOUT_MS);
 }
 
-static void handleRawCmpCommand(const char* args) {
-  int samples = 10;
-  if (strlen(args) > 0) {
-    samples = atoi(args);
-  }
-  samples = constrain(samples, 1, 1000);
+static void handleSetTLECommand(const CommandArgs* args) {
+  strncpy(pendingTleName, args->arg[0].s, sizeof(pendingTleName) - 1);
+  pendingTleName[sizeof(pendingTleName) - 1] = '\0';
   
-  printRawCompassData(samples);
+  Serial.println(F("Enter TLE Line 1:"));
+  beginPrompt(settleLine1, TLE_PROMPT_TIMEOUT_MS);
 }
 
-static void handleRawJoyCommand(const char* args) {
-  int samples = 10;
-  if (strlen(args) > 0) {
-    samples = atoi(args);
-  }
-  samples = constrain(samples, 1, 1000);
+static void handleRawCmpCommand(const CommandArgs* args) {
+  int samples = args->count > 0 ? constrain(args->arg[0].i, 1, 1000) : 10;
   
-  printRawJoystickData(samples);
+  printRawCompassHeader(samples);
+  beginStream(printRawCompassSample, samples, 100, nullptr);
 }
 
-static void handleEncoderCommand() {
-  printEncoderCounts();
+static void handleRawJoyCommand(const CommandArgs* args) {
+  int samples = args->count > 0 ? constrain(args->arg[0].i, 1, 1000) : 10;
+  
+  printRawJoystickHeader(samples);
+  beginStream(printRawJoystickSample, samples, 100, nullptr);
 }
 
-static void handleStreamCommand(const char* args) {
-  unsigned long duration = 10; // Default 10 seconds
-  if (strlen(args) > 0) {
-    duration = atoi(args);
+static void handleJogExpoCommand(const CommandArgs* args) {
+  if (args->count == 0) {
+    Serial.printf("Joystick expo: %.2f\n", getJoystickExpo());
+    return;
   }
-  duration = constrain(duration, 1, 300); // Max 5 minutes
-  
-  streamGPSData(duration);
+  setJoystickExpo(args->arg[0].f);
 }
 
-// Process a complete command
-static void processCommand(const char* input) {
-  SerialCommand cmd;
-  if (!parseCommand(input, &cmd)) {
+static void handleProtocolCommand(const CommandArgs* args) {
+  if (args->count == 0) {
+    printRotatorProtocolStatus();
     return;
   }
   
-  // Convert command to uppercase for comparison
-  toUpperCase(cmd.command);
-  
-  // Dispatch to appropriate handler
-  if (commandMatches(cmd.command, "HELP") || commandMatches(cmd.command, "?")) {
-    handleHelpCommand();
-  }
-  else if (commandMatches(cmd.command, "BANNER")) {
-    printBanner();
-  }
-  else if (commandMatches(cmd.command, "STATUS")) {
-    handleStatusCommand();
-  }
-  else if (commandMatches(cmd.command, "GPS")) {
-    handleGPSCommand(cmd.args);
-  }
-  else if (commandMatches(cmd.command, "COMPASS")) {
-    handleCompassCommand();
-  }
-  else if (commandMatches(cmd.command, "JOYSTICK")) {
-    handleJoystickCommand();
-  }
-  else if (commandMatches(cmd.command, "MOTORS")) {
-    handleMotorsCommand();
-  }
-  else if (commandMatches(cmd.command, "WIFI")) {
-    handleWiFiCommand();
+  RotatorProtocol protocol;
+  if (!parseRotatorProtocol(args->arg[0].s, &protocol)) {
+    Serial.println(F("ERROR: Usage: PROTOCOL <GS232A|GS232B|EASYCOMM>"));
+    return;
   }
-  else if (commandMatches(cmd.command, "STORAGE")) {
-    handleStorageCommand();
+  
+  if (protocol != ROTATOR_PROTOCOL_NONE) {
+    Serial.printf("%s mode - send %s to return to the CLI\n",
+                  rotatorProtocolName(protocol), ROTATOR_ESCAPE);
   }
-  else if (commandMatches(cmd.command, "SETWIFI")) {
-    handleSetWiFiCommand(cmd.args);
+  setRotatorProtocol(protocol);
+}
+
+static void handleCatalogLoadCommand(const CommandArgs* args) {
+  if (!beginCatalogIngest()) {
+    Serial.println(F("ERROR: Catalog upload already running or storage unavailable"));
+    return;
   }
-  else if (commandMatches(cmd.command, "SAVE")) {
-    handleSaveCommand();
+  cliState = CLI_CATALOG_LOAD;
+  catalogLoadData = false;
+  catalogLoadLast = millis();
+  Serial.println(F("Send the 3LE file now; end with Ctrl-D or a 3 s pause"));
+}
+
+static void printIngestSummary(const CatalogIngestStats& stats) {
+  Serial.printf("Catalog: %lu entries stored, %lu bad checksum, %lu bad format, %lu dropped, %lu duplicate\n",
+                stats.entries, stats.badChecksum, stats.badFormat, stats.dropped, stats.duplicates);
+  Serial.printf("%lu lines, %lu bytes in %lu ms (%.1f entries/s)\n",
+                stats.lines, stats.bytes, stats.elapsedMs, stats.entriesPerSec);
+}
+
+// The web interface steps the build as its "catalog" job; report it here
+// once it has finished
+static void catalogBuildTick(int index) {
+  if (isCatalogBuildActive()) {
+    return;
   }
-  else if (commandMatches(cmd.command, "LOAD")) {
-    handleLoadCommand();
+  CatalogIngestStats stats;
+  if (getLastIngestStats(&stats)) {
+    printIngestSummary(stats);
   }
-  else if (commandMatches(cmd.command, "ERASE")) {
-    handleEraseCommand();
+  Serial.println(getCatalogBuildMessage());
+  endStream();
+}
+
+// Feed the ingest from the port; bounded per call so the loop keeps running
+static void updateCatalogLoad() {
+  char buf[128];
+  bool done = false;
+
+  for (int pass = 0; pass < 4 && !done && Serial.available() > 0; pass++) {
+    size_t len = 0;
+    while (len < sizeof(buf) && Serial.available() > 0) {
+      char c = Serial.read();
+      if (c == CATALOG_LOAD_END) {
+        done = true;
+        break;
+      }
+      buf[len++] = c;
+    }
+    if (len > 0) {
+      feedCatalogIngest(buf, len);
+      catalogLoadData = true;
+      catalogLoadLast = millis();
+    }
   }
-  else if (commandMatches(cmd.command, "CALCMP")) {
-    handleCalCmpCommand();
+
+  unsigned long idleLimit = catalogLoadData ? CATALOG_LOAD_IDLE_MS : CATALOG_LOAD_START_MS;
+  if (!done && millis() - catalogLoadLast < idleLimit) {
+    return;
   }
-  else if (commandMatches(cmd.command, "CALSTOP")) {
-    handleCalStopCommand();
+
+  cliState = CLI_COMMAND;
+  CatalogIngestStats stats;
+  if (endCatalogIngest(&stats)) {
+    Serial.printf("\nBuilding catalog from %lu entries (any key stops waiting, see CATALOG)\n",
+                  stats.entries);
+    beginStream(catalogBuildTick, CATALOG_BUILD_POLL_LIMIT, CATALOG_BUILD_POLL_MS, nullptr);
+    return;
   }
-  else if (commandMatches(cmd.command, "CALJOY")) {
-    handleCalJoyCommand();
+
+  Serial.println();
+  printIngestSummary(stats);
+  Serial.println(F("Catalog unchanged"));
+  Serial.print(F("> "));
+}
+
+static void handlePassWatchCommand(const CommandArgs* args) {
+  if (args->count > 0) {
+    uint32_t ids[PASS_WATCH_MAX];
+    uint8_t count = parseNoradList(args->arg[0].s, ids, PASS_WATCH_MAX);
+    if (count == 0) {
+      Serial.println(F("ERROR: Usage: PASSWATCH <norad id>[,<norad id>...]"));
+      return;
+    }
+    uint8_t found = setPassWatchList(ids, count);
+    Serial.printf("%u of %u satellites found in the catalog\n", found, count);
   }
-  else if (commandMatches(cmd.command, "CALJOYSTOP")) {
-    handleCalJoyStopCommand();
+  printPassCacheStatus(0);
+}
+
+static void handleTelemetryCommand(const CommandArgs* args) {
+  if (args->count > 0) {
+    setTelemetryRate(constrain(args->arg[0].i, 0, TELEMETRY_MAX_HZ));
   }
-  else if (commandMatches(cmd.command, "HOME")) {
-    handleHomeCommand();
+  Serial.printf("Telemetry rate: %u Hz\n", getTelemetryRate());
+}
+
+static void handleJsonCommand(const CommandArgs* args) {
+  char buf[384];
+  JsonWriter w;
+  jsonBegin(&w, buf, sizeof(buf));
+  writeStatusJson(&w);
+  Serial.println(buf);
+}
+
+static void handleEncoderCommand(const CommandArgs* args) {
+  printEncoderCounts();
+}
+
+static void gpsStreamTick(int index) {
+  dumpGPSData();
+}
+
+static void handleStreamCommand(const CommandArgs* args) {
+  // Default 10 seconds, max 5 minutes
+  unsigned long duration = args->count > 0 ? constrain(args->arg[0].i, 1, 300) : 10;
+  
+  streamGPSData(duration);
+}
+
+// Thin adapters for commands that map straight onto a module function
+static void handleBannerCommand(const CommandArgs* args) {
+  printBanner();
+}
+
+static void handleCatalogCommand(const CommandArgs* args) {
+  printCatalogStatus();
+}
+
+static void handlePassesCommand(const CommandArgs* args) {
+  printPassCacheStatus(args->count > 0 ? constrain(args->arg[0].i, 1, 50) : 10);
+}
+
+static void handleInputsCommand(const CommandArgs* args) {
+  printInputDebounceStatus();
+}
+
+static void handleHttpCommand(const CommandArgs* args) {
+  printHttpServerStatus();
+}
+
+static void handleRotctlCommand(const CommandArgs* args) {
+  printRotctlServerStatus();
+}
+
+static void handleHeapCommand(const CommandArgs* args) {
+  printHeapStats();
+}
+
+static void handleMetricsCommand(const CommandArgs* args) {
+  printMetrics();
+}
+
+#define CATFIND_MAX_RESULTS 20
+
+static bool isCatalogNumber(const char* text) {
+  if (!*text) {
+    return false;
   }
-  else if (commandMatches(cmd.command, "STOP")) {
-    handleStopCommand();
+  for (const char* p = text; *p; p++) {
+    if (!isdigit((unsigned char)*p)) return false;
   }
-  else if (commandMatches(cmd.command, "ESTOP")) {
-    handleEStopCommand();
+  return true;
+}
+
+static void printCatalogEntry(const TleRecord& record) {
+  Serial.printf("%6lu  %-24s  i %5.1f  %6.1f min  epoch %.14s\n", record.noradId, record.name,
+                record.elements.inclination, 1440.0f / record.elements.meanMotion, record.line1 + 18);
+}
+
+static void handleCatalogFindCommand(const CommandArgs* args) {
+  const char* query = args->arg[0].s;
+  TleRecord record;
+
+  if (isCatalogNumber(query)) {
+    if (findCatalogRecord(strtoul(query, nullptr, 10), &record)) {
+      printCatalogEntry(record);
+    } else {
+      Serial.println(F("Not in catalog"));
+    }
+    return;
   }
-  else if (commandMatches(cmd.command, "RESET")) {
-    handleResetCommand();
+
+  uint32_t indices[CATFIND_MAX_RESULTS];
+  uint32_t found = findCatalogByName(query, indices, CATFIND_MAX_RESULTS);
+  for (uint32_t i = 0; i < found; i++) {
+    if (readCatalogRecord(indices[i], &record)) {
+      printCatalogEntry(record);
+    }
   }
-  else if (commandMatches(cmd.command, "GOTO")) {
-    handleGotoCommand(cmd.args);
+  if (found == 0) {
+    Serial.println(F("No matching names"));
+  } else if (found == CATFIND_MAX_RESULTS) {
+    Serial.printf("(first %d matches shown)\n", CATFIND_MAX_RESULTS);
   }
-  else if (commandMatches(cmd.command, "SHOWTLE")) {
-    handleShowTLECommand();
+}
+
+static void handleCatalogSelectCommand(const CommandArgs* args) {
+  const char* query = args->arg[0].s;
+  TleRecord record;
+  uint32_t start = micros();
+  bool found;
+
+  if (isCatalogNumber(query)) {
+    found = findCatalogRecord(strtoul(query, nullptr, 10), &record);
+  } else {
+    uint32_t indices[2];
+    uint32_t matches = findCatalogByName(query, indices, 2);
+    if (matches > 1) {
+      Serial.println(F("ERROR: Name is ambiguous - use CATFIND, then select by NORAD ID"));
+      return;
+    }
+    found = matches == 1 && readCatalogRecord(indices[0], &record);
   }
-  else if (commandMatches(cmd.command, "SETTLE")) {
-    handleSetTLECommand(cmd.args);
+  uint32_t elapsed = micros() - start;
+
+  if (!found) {
+    Serial.println(F("ERROR: Not in catalog"));
+    return;
   }
-  else if (commandMatches(cmd.command, "RAWCMP")) {
-    handleRawCmpCommand(cmd.args);
+
+  setTLE(record.name, record.line1, record.line2);
+  Serial.printf("Tracking %s (%lu), loaded in %lu us\n", record.name, record.noradId, elapsed);
+}
+
+static void handleBinaryCommand(const CommandArgs* args) {
+  Serial.println(F("Binary mode - send an EXIT command frame to return to the CLI"));
+  Serial.flush();
+  beginBinaryLink();
+}
+
+static void handleBinLinkCommand(const CommandArgs* args) {
+  printBinaryLinkStatus();
+}
+
+static void handleLedTestCommand(const CommandArgs* args) {
+  Serial.println(F("Running LED test..."));
+  handleLedTest();
+}
+
+static void handleLedModeCommand(const CommandArgs* args) {
+  handleLedMode(args->arg[0].i);
+}
+
+static void handleLedInfoCommand(const CommandArgs* args) {
+  printLedStatus();
+}
+
+static void handleLedBenchCommand(const CommandArgs* args) {
+  benchmarkLEDs();
+}
+
+// ============================================================================
+// COMMAND TABLE
+// ============================================================================
+// One entry per command, in help order. The schema has one letter per
+// argument: I = integer, F = number, W = word, T = rest of the line;
+// lower case marks an optional argument. Lookup goes through an index
+// sorted at compile time, so dispatch is a binary search on the name.
+
+enum CommandGroup : uint8_t {
+  GROUP_STATUS,
+  GROUP_WIFI,
+  GROUP_CALIBRATION,
+  GROUP_CONFIG,
+  GROUP_CONTROL,
+  GROUP_TLE,
+  GROUP_DIAGNOSTICS,
+  GROUP_OTHER,
+  GROUP_COUNT
+};
+
+static const char* const commandGroupTitles[GROUP_COUNT] = {
+  "System Status:",
+  "WiFi Configuration:",
+  "Calibration:",
+  "Configuration:",
+  "Control:",
+  "TLE Management:",
+  "Diagnostics:",
+  "Other:"
+};
+
+typedef void (*CommandHandler)(const CommandArgs* args);
+
+struct CommandDef {
+  const char* name;        // Upper case
+  const char* schema;      // Argument types, see above
+  const char* usage;       // Argument names for help and errors
+  CommandHandler handler;
+  CommandGroup group;
+  const char* help;        // nullptr hides the command from HELP
+  const char* detail;      // Extra help lines, or nullptr
+};
+
+static constexpr CommandDef commands[] = {
+  {"STATUS",     "",   nullptr, handleStatusCommand,     GROUP_STATUS, "Full system status", nullptr},
+  {"GPS",        "i",  "<sec>",   handleGPSCommand,      GROUP_STATUS, "GPS status, or UART test for n seconds", nullptr},
+  {"COMPASS",    "",   nullptr, handleCompassCommand,    GROUP_STATUS, "Compass status and heading", nullptr},
+  {"JOYSTICK",   "",   nullptr, handleJoystickCommand,   GROUP_STATUS, "Joystick status and values", nullptr},
+  {"MOTORS",     "",   nullptr, handleMotorsCommand,     GROUP_STATUS, "Motor positions and status", nullptr},
+  {"WIFI",       "",   nullptr, handleWiFiCommand,       GROUP_STATUS, "WiFi status", nullptr},
+  {"STORAGE",    "",   nullptr, handleStorageCommand,    GROUP_STATUS, "Storage info", nullptr},
+
+  {"SETWIFI",    "WT", "<ssid> <password>", handleSetWiFiCommand, GROUP_WIFI, "Set WiFi credentials",
+   "  Example: SETWIFI MyNetwork MyPassword123"},
+
+  {"CALCMP",     "",   nullptr, handleCalCmpCommand,     GROUP_CALIBRATION, "Start compass calibration", nullptr},
+  {"CALSTOP",    "",   nullptr, handleCalStopCommand,    GROUP_CALIBRATION, "Stop compass calibration", nullptr},
+  {"CALJOY",     "",   nullptr, handleCalJoyCommand,     GROUP_CALIBRATION, "Start joystick calibration", nullptr},
+  {"CALJOYSTOP", "",   nullptr, handleCalJoyStopCommand, GROUP_CALIBRATION, "Stop joystick calibration", nullptr},
+
+  {"SAVE",       "",   nullptr, handleSaveCommand,       GROUP_CONFIG, "Save config to storage", nullptr},
+  {"SYNC",       "",   nullptr, handleSyncCommand,       GROUP_CONFIG, "Write pending config to flash now", nullptr},
+  {"LOAD",       "",   nullptr, handleLoadCommand,       GROUP_CONFIG, "Load config from storage", nullptr},
+  {"ERASE",      "",   nullptr, handleEraseCommand,      GROUP_CONFIG, "Erase stored config", nullptr},
+
+  {"HOME",       "",   nullptr, handleHomeCommand,       GROUP_CONTROL, "Home all axes", nullptr},
+  {"STOP",       "",   nullptr, handleStopCommand,       GROUP_CONTROL, "Stop tracking", nullptr},
+  {"ESTOP",      "",   nullptr, handleEStopCommand,      GROUP_CONTROL, "Emergency stop", nullptr},
+  {"RESET",      "",   nullptr, handleResetCommand,      GROUP_CONTROL, "Reset emergency stop", nullptr},
+  {"GOTO",       "FF", "<az> <el>", handleGotoCommand,   GROUP_CONTROL, "Move to position (deg)",
+   "  Example: GOTO 180 45"},
+  {"JOGEXPO",    "f",  "<e>",     handleJogExpoCommand,  GROUP_CONTROL, "Joystick expo curve (0=linear, 1=cubic)", nullptr},
+  {"PROTOCOL",   "w",  "<p>",     handleProtocolCommand, GROUP_CONTROL, "Rotator protocol: GS232A, GS232B, EASYCOMM",
+   "                 (send +++ to return to this CLI)"},
+  {"BINARY",     "",   nullptr, handleBinaryCommand,     GROUP_CONTROL, "Binary framed telemetry/command protocol",
+   "                 (scripts/binlink_decode.py; EXIT frame returns)"},
+
+  {"SHOWTLE",    "",   nullptr, handleShowTLECommand,    GROUP_TLE, "Display current TLE", nullptr},
+  {"SETTLE",     "T",  "<name>",  handleSetTLECommand,   GROUP_TLE, "Enter TLE (next 2 lines)",
+   "  Example: SETTLE ISS\n"
+   "           1 25544U 98067A   ...(line 1)\n"
+   "           2 25544  51.6416 ...(line 2)"},
+  {"CATALOG",    "",   nullptr, handleCatalogCommand,    GROUP_TLE, "Show TLE catalog status", nullptr},
+  {"CATLOAD",    "",   nullptr, handleCatalogLoadCommand, GROUP_TLE, "Upload a 3LE catalog file (end with Ctrl-D)", nullptr},
+  {"CATFIND",    "T",  "<id|name>", handleCatalogFindCommand, GROUP_TLE, "Find catalog entries by NORAD ID or name prefix", nullptr},
+  {"CATSEL",     "T",  "<id|name>", handleCatalogSelectCommand, GROUP_TLE, "Track a catalog entry", nullptr},
+  {"PASSWATCH",  "t",  "<ids>",   handlePassWatchCommand, GROUP_TLE, "Predict passes for NORAD IDs (e.g. 25544,43017)", nullptr},
+  {"PASSES",     "i",  "<n>",     handlePassesCommand,   GROUP_TLE, "Show pass cache and next n passes", nullptr},
+
+  {"RAWCMP",     "i",  "<n>",     handleRawCmpCommand,   GROUP_DIAGNOSTICS, "Print n compass readings", nullptr},
+  {"RAWJOY",     "i",  "<n>",     handleRawJoyCommand,   GROUP_DIAGNOSTICS, "Print n joystick readings", nullptr},
+  {"ENCODER",    "",   nullptr, handleEncoderCommand,    GROUP_DIAGNOSTICS, "Print encoder counts", nullptr},
+  {"INPUTS",     "",   nullptr, handleInputsCommand,     GROUP_DIAGNOSTICS, "Show PIO input debouncer status", nullptr},
+  {"HTTP",       "",   nullptr, handleHttpCommand,       GROUP_DIAGNOSTICS, "Show web server connections", nullptr},
+  {"ROTCTL",     "",   nullptr, handleRotctlCommand,     GROUP_DIAGNOSTICS, "Show rotctl server clients", nullptr},
+  {"BINLINK",    "",   nullptr, handleBinLinkCommand,    GROUP_DIAGNOSTICS, "Show binary protocol counters", nullptr},
+  {"TELEMETRY",  "i",  "<hz>",    handleTelemetryCommand, GROUP_DIAGNOSTICS, "Web live telemetry rate (0-20)", nullptr},
+  {"JSON",       "",   nullptr, handleJsonCommand,       GROUP_DIAGNOSTICS, "Print status as JSON", nullptr},
+  {"HEAP",       "",   nullptr, handleHeapCommand,       GROUP_DIAGNOSTICS, "Show heap usage and allocation counts", nullptr},
+  {"METRICS",    "",   nullptr, handleMetricsCommand,    GROUP_DIAGNOSTICS, "Print the /metrics exposition", nullptr},
+  {"STREAM",     "i",  "<sec>",   handleStreamCommand,   GROUP_DIAGNOSTICS, "Stream GPS data for n seconds", nullptr},
+  {"LEDTEST",    "",   nullptr, handleLedTestCommand,    GROUP_DIAGNOSTICS, "Run LED ring test sequence", nullptr},
+  {"LEDMODE",    "I",  "<n>",     handleLedModeCommand,  GROUP_DIAGNOSTICS, "Set LED mode (0-7)", nullptr},
+  {"LEDINFO",    "",   nullptr, handleLedInfoCommand,    GROUP_DIAGNOSTICS, "Show LED status", nullptr},
+  {"LEDBENCH",   "",   nullptr, handleLedBenchCommand,   GROUP_DIAGNOSTICS, "Time LED frame rendering", nullptr},
+
+  {"HELP",       "",   nullptr, handleHelpCommand,       GROUP_OTHER, "This help message", nullptr},
+  {"?",          "",   nullptr, handleHelpCommand,       GROUP_OTHER, nullptr, nullptr},
+  {"BANNER",     "",   nullptr, handleBannerCommand,     GROUP_OTHER, "System banner", nullptr}
+};
+
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+#define COMMAND_NAME_SIZE 12     // Longest name + 1
+
+struct CommandIndex {
+  uint8_t order[COMMAND_COUNT];  // Table positions sorted by name
+};
+
+constexpr int compareNames(const char* a, const char* b) {
+  while (*a && *a == *b) {
+    a++;
+    b++;
   }
-  else if (commandMatches(cmd.command, "RAWJOY")) {
-    handleRawJoyCommand(cmd.args);
+  return (unsigned char)*a - (unsigned char)*b;
+}
+
+constexpr CommandIndex buildCommandIndex() {
+  CommandIndex index = {};
+  for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+    uint8_t j = i;
+    while (j > 0 && compareNames(commands[index.order[j - 1]].name, commands[i].name) > 0) {
+      index.order[j] = index.order[j - 1];
+      j--;
+    }
+    index.order[j] = i;
   }
-  else if (commandMatches(cmd.command, "ENCODER")) {
-    handleEncoderCommand();
+  return index;
+}
+
+static constexpr CommandIndex commandIndex = buildCommandIndex();
+
+// Names unique, upper case and short enough for the lookup buffer
+constexpr bool commandNamesValid() {
+  for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+    const char* name = commands[commandIndex.order[i]].name;
+    size_t len = 0;
+    for (; name[len]; len++) {
+      if (name[len] >= 'a' && name[len] <= 'z') {
+        return false;
+      }
+    }
+    if (len == 0 || len >= COMMAND_NAME_SIZE) {
+      return false;
+    }
+    if (i > 0 && compareNames(commands[commandIndex.order[i - 1]].name, name) == 0) {
+      return false;
+    }
   }
-  else if (commandMatches(cmd.command, "STREAM")) {
-    handleStreamCommand(cmd.args);
+  return true;
+}
+
+// At most SERIAL_MAX_ARGS letters, known types, text last, optional
+// arguments only at the end
+constexpr bool commandSchemasValid() {
+  for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+    const char* schema = commands[i].schema;
+    bool optional = false;
+    for (uint8_t n = 0; schema[n]; n++) {
+      char c = schema[n];
+      bool lower = c >= 'a' && c <= 'z';
+      char type = lower ? c - 'a' + 'A' : c;
+      if (n >= SERIAL_MAX_ARGS || (type != 'I' && type != 'F' && type != 'W' && type != 'T')) {
+        return false;
+      }
+      if (type == 'T' && schema[n + 1]) {
+        return false;
+      }
+      if (optional && !lower) {
+        return false;
+      }
+      optional = lower;
+    }
   }
-  else if (commandMatches(cmd.command, "LEDTEST")) {
-    Serial.println(F("Running LED test..."));
-    handleLedTest();
+  return true;
+}
+
+static_assert(commandNamesValid(), "Command names must be unique, upper case and short");
+static_assert(commandSchemasValid(), "Malformed command argument schema");
+
+static const CommandDef* findCommand(const char* name) {
+  int lo = 0;
+  int hi = COMMAND_COUNT - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    const CommandDef* def = &commands[commandIndex.order[mid]];
+    int cmp = strcmp(name, def->name);
+    if (cmp == 0) {
+      return def;
+    }
+    if (cmp < 0) {
+      hi = mid - 1;
+    } else {
+      lo = mid + 1;
+    }
   }
-  else if (commandMatches(cmd.command, "LEDMODE")) {
-    if (strlen(cmd.args) > 0) {
-      int mode = atoi(cmd.args);
-      handleLedMode(mode);
+  return nullptr;
+}
+
+static void handleHelpCommand(const CommandArgs* args) {
+  Serial.println(F("\n=== AVAILABLE COMMANDS ==="));
+  Serial.println();
+  
+  for (uint8_t group = 0; group < GROUP_COUNT; group++) {
+    Serial.println(commandGroupTitles[group]);
+    for (const CommandDef& def : commands) {
+      if (def.group != group || !def.help) {
+        continue;
+      }
+      char label[40];
+      snprintf(label, sizeof(label), def.usage ? "%s %s" : "%s", def.name, def.usage);
+      Serial.printf("  %-12s - %s\n", label, def.help);
+      if (def.detail) {
+        Serial.println(def.detail);
+      }
     }
+    Serial.println();
   }
-  else if (commandMatches(cmd.command, "LEDINFO")) {
-    printLedStatus();
+}
+
+// Process a complete command (the line is split in place)
+static void processCommand(char* input) {
+  // Command name, upper-cased for the lookup
+  char name[COMMAND_NAME_SIZE];
+  size_t len = 0;
+  while (input[len] && input[len] != ' ') {
+    len++;
+  }
+  
+  const CommandDef* def = nullptr;
+  if (len < sizeof(name)) {
+    for (size_t i = 0; i < len; i++) {
+      name[i] = toupper(input[i]);
+    }
+    name[len] = '\0';
+    def = findCommand(name);
   }
-  else {
+  
+  if (!def) {
     Serial.print(F("Unknown command: "));
-    Serial.println(cmd.command);
+    Serial.write(input, len);
+    Serial.println();
     Serial.println(F("Type HELP for available commands"));
+    return;
+  }
+  
+  CommandArgs args;
+  if (!parseArgs(def->schema, input + len, &args)) {
+    Serial.printf("ERROR: Usage: %s %s\n", def->name, def->usage ? def->usage : "");
+    if (def->detail) {
+      Serial.println(def->detail);
+    }
+    return;
   }
+  
+  def->handler(&args);
 }
 
 // ============================================================================
@@ -536,17 +980,43 @@ void initSerialInterface() {
 }
 
 void updateSerialInterface() {
-  // Handle GPS streaming mode
-  if (streamingGPS) {
-    if (millis() - streamStartTime >= streamDuration) {
-      streamingGPS = false;
-      Serial.println(F("\n=== GPS Stream Complete ==="));
+  switch (cliState) {
+    case CLI_STREAM:
+      updateStream();
+      return;
+    case CLI_CATALOG_LOAD:
+      updateCatalogLoad();
+      return;
+    case CLI_PROMPT:
+      if (millis() - promptStart >= promptTimeout) {
+        Serial.println();
+        cliState = CLI_COMMAND;
+        promptHandler(nullptr);
+        if (cliState == CLI_COMMAND) {
+          Serial.print(F("> "));
+        }
+      }
+      break;
+    case CLI_COMMAND:
+      break;
+  }
+  
+  // Binary protocol mode: framed messages in both directions
+  if (isBinaryLinkActive()) {
+    pollBinaryLink();
+    return;
+  }
+  
+  // Rotator protocol mode: the port belongs to the station software
+  if (getRotatorProtocol() != ROTATOR_PROTOCOL_NONE) {
+    while (Serial.available() > 0) {
+      feedRotatorProtocol(Serial.read());
     }
     return;
   }
   
-  // Check for incoming data
-  while (Serial.available() > 0) {
+  // Check for incoming data (bounded per call)
+  for (int n = 0; n < SERIAL_MAX_CHARS_PER_UPDATE && Serial.available() > 0; n++) {
     char c = Serial.read();
     
     // Handle newline/carriage return
@@ -562,13 +1032,21 @@ void updateSerialInterface() {
       // Null terminate
       cmdBuffer[cmdBufferPos] = '\0';
       
-      // Process command
-      processCommand(cmdBuffer);
+      // Process command or prompt answer
+      processLine(cmdBuffer);
       
       // Reset buffer
       cmdBufferPos = 0;
       memset(cmdBuffer, 0, sizeof(cmdBuffer));
       
+      // Switched to a rotator protocol, binary mode, an upload, a
+      // stream or a prompt: no command prompt, and the rest of the input
+      // belongs to the new state
+      if (getRotatorProtocol() != ROTATOR_PROTOCOL_NONE || isBinaryLinkActive() ||
+          cliState != CLI_COMMAND) {
+        return;
+      }
+      
       // Print prompt
       Serial.print(F("> "));
     }
@@ -603,7 +1081,7 @@ void printBanner() {
 }
 
 void printHelp() {
-  handleHelpCommand();
+  handleHelpCommand(nullptr);
 }
 
 void printSystemStatus() {
@@ -722,6 +1200,7 @@ void printWiFiStatus() {
       break;
   }
   
+  printWiFiLinkStatus();
   Serial.println();
 }
 
@@ -776,7 +1255,7 @@ void saveConfiguration() {
   config.tleValid = trackerState.tleValid;
   
   if (saveConfig(&config)) {
-    Serial.println(F("Configuration saved successfully"));
+    Serial.println(F("Configuration saved (written to flash in the background)"));
   } else {
     Serial.println(F("ERROR: Failed to save configuration"));
   }
@@ -797,10 +1276,16 @@ void loadConfiguration() {
     return;
   }
   
-  // WiFi credentials
+  // WiFi credentials (reassociate only if they changed)
+  bool wifiChanged = wifiConfigured != config.wifiConfigured ||
+                     strncmp(wifiSSID, config.wifiSSID, sizeof(wifiSSID) - 1) != 0 ||
+                     strncmp(wifiPassword, config.wifiPassword, sizeof(wifiPassword) - 1) != 0;
   strncpy(wifiSSID, config.wifiSSID, sizeof(wifiSSID) - 1);
   strncpy(wifiPassword, config.wifiPassword, sizeof(wifiPassword) - 1);
   wifiConfigured = config.wifiConfigured;
+  if (wifiChanged) {
+    reconnectWiFi();
+  }
   
   // Joystick calibration
   if (config.joyCalibrated) {
@@ -871,22 +1356,7 @@ void endCompassCalibration() {
   
   // Save to storage
   if (isStorageAvailable()) {
-    Serial.println(F("Save calibration? (Y/N):"));
-    unsigned long timeout = millis() + 10000;
-    String response = "";
-    
-    while (millis() < timeout) {
-      if (Serial.available()) {
-        char c = Serial.read();
-        if (c == '\n' || c == '\r') break;
-        response += c;
-      }
-    }
-    
-    response.trim();
-    if (response.equalsIgnoreCase("Y") || response.equalsIgnoreCase("YES")) {
-      saveConfiguration();
-    }
+    beginConfirm("Save calibration? (Y/N):", false, saveConfiguration);
   }
 }
 
@@ -911,22 +1381,7 @@ void endJoystickCalibration() {
   
   // Save to storage
   if (isStorageAvailable()) {
-    Serial.println(F("Save calibration? (Y/N):"));
-    unsigned long timeout = millis() + 10000;
-    String response = "";
-    
-    while (millis() < timeout) {
-      if (Serial.available()) {
-        char c = Serial.read();
-        if (c == '\n' || c == '\r') break;
-        response += c;
-      }
-    }
-    
-    response.trim();
-    if (response.equalsIgnoreCase("Y") || response.equalsIgnoreCase("YES")) {
-      saveConfiguration();
-    }
+    beginConfirm("Save calibration? (Y/N):", false, saveConfiguration);
   }
 }
 
@@ -981,29 +1436,28 @@ void streamGPSData(unsigned long duration) {
   Serial.println(F("Press any key to stop early"));
   Serial.println();
   
-  streamingGPS = true;
-  streamStartTime = millis();
-  streamDuration = duration * 1000;
-  
-  // GPS data will be printed by GPS module's dumpGPSData()
-  // The stream will continue until duration expires or key pressed
+  beginStream(gpsStreamTick, duration, 1000, "\n=== GPS Stream Complete ===");
+}
+
+static void ledTestTick(int index) {
+  stepLEDTest(index);
 }
 
 void handleLedTest() {
-  testLEDs();
+  beginStream(ledTestTick, getLEDTestTicks(), LED_TEST_TICK_MS, nullptr);
 }
 
 void handleLedMode(int mode) {
   if (mode > 0 && mode < LED_MODE_CUSTOM) {
-    if (mode >= 0 && mode <= 6) {
+    if (mode >= 0 && mode <= 7) {
       setLEDMode((LEDMode)mode);
       Serial.print(F("LED mode set to: "));
       Serial.println(mode);
     } else {
-      Serial.println(F("ERROR: Mode must be 0-6"));
-      Serial.println(F("  0=OFF, 1=GREEN, 2=PURPLE, 3=RED, 4=YELLOW, 5=BLUE, 6=RAINBOW"));
+      Serial.println(F("ERROR: Mode must be 0-7"));
+      Serial.println(F("  0=OFF, 1=GREEN, 2=PURPLE, 3=RED, 4=YELLOW, 5=BLUE, 6=RAINBOW, 7=POINTING"));
     }
   } else {
-    Serial.println(F("ERROR: Usage: LEDMODE <0-6>"));
+    Serial.println(F("ERROR: Usage: LEDMODE <0-7>"));
   }
 }
@@ -0,0 +1,85 @@
+// ============================================================================
+// sgp4_cache.cpp - LRU cache of initialised SGP4 predictors
+// ============================================================================
+
+#include "sgp4_cache.h"
+#include "crc32.h"
+#include "metrics.h"
+
+// Sgp4::init() parses both lines with the C library's number conversions
+// and then derives the propagator constants, which for a deep-space orbit
+// is most of the cost of a pass search. The library has no other way in,
+// so the cache holds whole initialised predictors, keyed by CRC-32 of the
+// name and each line (the copied state includes the name). That state is
+// library-internal and about a kilobyte per satellite, so it lives in RAM
+// only. The catalog's TleElements are single precision and lack the epoch
+// fraction and drag derivatives, so they serve screening and display; a
+// miss here always initialises from the text lines.
+
+struct Sgp4CacheEntry {
+  uint32_t crcName;
+  uint32_t crc1;
+  uint32_t crc2;
+  uint32_t lastUse;        // 0 = empty
+  Sgp4 state;
+};
+
+static Sgp4CacheEntry cache[SGP4_CACHE_SIZE];
+static uint32_t useCounter = 0;
+static uint32_t cacheHits = 0;
+static uint32_t cacheMisses = 0;
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+bool initSatellite(Sgp4* sat, const char* name, const char* line1, const char* line2) {
+  uint32_t crcName = calculateCrc32(name, strlen(name));
+  uint32_t crc1 = calculateCrc32(line1, strlen(line1));
+  uint32_t crc2 = calculateCrc32(line2, strlen(line2));
+
+  Sgp4CacheEntry* oldest = &cache[0];
+  for (uint8_t i = 0; i < SGP4_CACHE_SIZE; i++) {
+    Sgp4CacheEntry& entry = cache[i];
+    if (entry.lastUse && entry.crcName == crcName && entry.crc1 == crc1 && entry.crc2 == crc2) {
+      entry.lastUse = ++useCounter;
+      *sat = entry.state;
+      cacheHits++;
+      metricInc(METRIC_SGP4_CACHE_HITS);
+      return true;
+    }
+    if (entry.lastUse < oldest->lastUse) {
+      oldest = &entry;
+    }
+  }
+
+  // Sgp4 parses the lines in place
+  char buf1[130];
+  char buf2[130];
+  strncpy(buf1, line1, sizeof(buf1) - 1);
+  buf1[sizeof(buf1) - 1] = '\0';
+  strncpy(buf2, line2, sizeof(buf2) - 1);
+  buf2[sizeof(buf2) - 1] = '\0';
+
+  cacheMisses++;
+  metricInc(METRIC_SGP4_INITS);
+  if (!sat->init(name, buf1, buf2)) {
+    return false;
+  }
+
+  oldest->crcName = crcName;
+  oldest->crc1 = crc1;
+  oldest->crc2 = crc2;
+  oldest->lastUse = ++useCounter;
+  oldest->state = *sat;
+  return true;
+}
+
+void printSgp4CacheStatus() {
+  uint8_t used = 0;
+  for (uint8_t i = 0; i < SGP4_CACHE_SIZE; i++) {
+    if (cache[i].lastUse) used++;
+  }
+  Serial.printf("SGP4 cache: %u/%d satellites (%u bytes), %lu hits, %lu initialised from text\n",
+                used, SGP4_CACHE_SIZE, (unsigned)sizeof(cache), cacheHits, cacheMisses);
+}
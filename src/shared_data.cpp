@@ -25,6 +25,12 @@ float lastErrorA = 0.0;
 DisplayScreen currentScreen = SCREEN_SETUP;
 bool displayNeedsUpdate = true;
 
+// Pose snapshot halves and their sequence counters (odd = write in progress)
+static AntennaPose antennaPose = {0, 0, 0, 0};
+static SatellitePose satellitePose = {0, 0, 0, false, false};
+static volatile uint32_t antennaPoseSeq = 0;
+static volatile uint32_t satellitePoseSeq = 0;
+
 // WiFi credentials
 char wifiSSID[32] = "";
 char wifiPassword[64] = "";
@@ -58,4 +64,39 @@ void initSharedData() {
   displayNeedsUpdate = true;
   
   Serial.println("Shared data initialized");
-}
\ No newline at end of file
+}
+
+void publishAntennaPose(const AntennaPose& pose) {
+  antennaPoseSeq = antennaPoseSeq + 1;
+  __dmb();
+  antennaPose = pose;
+  __dmb();
+  antennaPoseSeq = antennaPoseSeq + 1;
+}
+
+void publishSatellitePose(const SatellitePose& pose) {
+  satellitePoseSeq = satellitePoseSeq + 1;
+  __dmb();
+  satellitePose = pose;
+  __dmb();
+  satellitePoseSeq = satellitePoseSeq + 1;
+}
+
+void getPoseSnapshot(PoseSnapshot* snapshot) {
+  uint32_t seq;
+  
+  // Retry while a writer is mid-update or finished one during the copy
+  do {
+    seq = antennaPoseSeq;
+    __dmb();
+    snapshot->antenna = antennaPose;
+    __dmb();
+  } while ((seq & 1) || seq != antennaPoseSeq);
+  
+  do {
+    seq = satellitePoseSeq;
+    __dmb();
+    snapshot->satellite = satellitePose;
+    __dmb();
+  } while ((seq & 1) || seq != satellitePoseSeq);
+}
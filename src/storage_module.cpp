@@ -3,28 +3,235 @@
 // ============================================================================
 
 #include "storage_module.h"
+#include "crc32.h"
+#include <stddef.h>
 #include <SPI.h>
 #include <LittleFS.h>
 #include <SD.h>
 
+// The configuration is kept on flash as an append-only log of field
+// records rather than one struct-sized file. Each record carries a single
+// StorageConfig field with a sequence number and a CRC, so changing one
+// value costs one small append. At boot the log is replayed in order into
+// a RAM copy of what is on flash. Once the log outgrows
+// CONFIG_LOG_COMPACT_SIZE the live values are written to a fresh log that
+// replaces the old one.
+//
+// Log file (little-endian):
+//   uint32 magic          CONFIG_LOG_MAGIC
+//   uint16 version        CONFIG_VERSION the log was written with
+//   uint16 reserved
+//   uint32 crc            CRC-32 over magic..reserved
+//   ...    records
+//
+// Record:
+//   uint8  marker         CONFIG_RECORD_MARKER
+//   uint8  field          ConfigFieldId
+//   uint8  length         Payload bytes
+//   uint8  flags          CONFIG_RECORD_END on the last record of a batch
+//   uint32 seq            Increases by one per record, across compactions
+//   ...    payload        Field value (strings without the terminator)
+//   uint32 crc            CRC-32 over marker..payload
+//
+// The records written by one save form a batch. Replay applies a batch
+// only once its END record is seen, so a save cut short by a power loss
+// leaves the previous values in place (a calibration is never half
+// updated).
+//
+// Callers never touch flash: reads and writes go to configCache, a RAM
+// copy loaded once at boot. A change marks the cache dirty and
+// updateStorage() appends the fields that differ from storedConfig once
+// no change has arrived for CONFIG_FLUSH_QUIET_MS, so a burst of saves
+// becomes a single batch. CONFIG_FLUSH_MAX_DELAY_MS bounds how long a
+// change can stay only in RAM while edits keep arriving.
+//
+// Format history. An older configuration is read in its own format, the
+// migration steps from its version up are applied to the RAM copy in one
+// pass, and the result is written back once as a current log:
+//   1  Single StorageConfig struct in CONFIG_V1_FILENAME, 16-bit byte sum
+//   2  Field log without a file header, CRC-16/CCITT-FALSE records
+//   3  Field log with a versioned file header, CRC-32 records
+
 // Storage state
 static StorageType currentStorageType = STORAGE_TYPE_NONE;
 static bool storageInitialized = false;
 
-// Magic number for config validation
-#define CONFIG_MAGIC 0xCAFEBABE
-#define CONFIG_VERSION 1
-#define CONFIG_FILENAME "/tracker_config.dat"
+#define CONFIG_VERSION 3
+
+#define CONFIG_LOG_FILENAME "/tracker_config.log"
+#define CONFIG_LOG_TEMP_FILENAME "/tracker_config.tmp"
+#define CONFIG_LOG_MAGIC 0x47464354                // "TCFG"
+#define CONFIG_LOG_HEADER_SIZE 12
+#define CONFIG_LOG_COMPACT_SIZE 8192               // Compact once the log exceeds this
+#define CONFIG_RECORD_MARKER 0xC5
+#define CONFIG_RECORD_END 0x01
+#define CONFIG_RECORD_HEADER_SIZE 8
+#define CONFIG_RECORD_MAX_PAYLOAD 72
+#define CONFIG_RECORD_MAX_SIZE (CONFIG_RECORD_HEADER_SIZE + CONFIG_RECORD_MAX_PAYLOAD + 4)
+
+#define CONFIG_FLUSH_QUIET_MS 2000                 // Flush once changes stop for this long
+#define CONFIG_FLUSH_MAX_DELAY_MS 10000            // ...or at the latest this long after the first
+#define CONFIG_FLUSH_RETRY_MS 5000                 // After a failed flush
+
+// Version 1 file: the StorageConfig layout of that release, frozen here
+// so the current struct can change freely
+#define CONFIG_V1_FILENAME "/tracker_config.dat"
+#define CONFIG_V1_MAGIC 0xCAFEBABE
+
+struct ConfigV1 {
+  char wifiSSID[32];
+  char wifiPassword[64];
+  bool wifiConfigured;
+  int compassMinX, compassMaxX;
+  int compassMinY, compassMaxY;
+  int compassMinZ, compassMaxZ;
+  int compassDeadband;
+  bool compassCalibrated;
+  uint16_t joyXMin, joyXCenter, joyXMax;
+  uint16_t joyYMin, joyYCenter, joyYMax;
+  uint16_t joyDeadband;
+  bool joyCalibrated;
+  char satelliteName[25];
+  char tleLine1[70];
+  char tleLine2[70];
+  bool tleValid;
+  uint32_t magic;
+  uint16_t version;
+  uint16_t checksum;
+};
+
+// The schema: on-flash field IDs and where each lives in StorageConfig.
+// IDs are part of the storage format: never reuse or renumber one, only
+// append new IDs. Records for IDs this firmware does not know are
+// skipped, so an older release can still read a newer log.
+typedef enum : uint8_t {
+  CFG_WIFI_SSID = 1,
+  CFG_WIFI_PASSWORD = 2,
+  CFG_WIFI_CONFIGURED = 3,
+  CFG_COMPASS_MIN_X = 10,
+  CFG_COMPASS_MAX_X = 11,
+  CFG_COMPASS_MIN_Y = 12,
+  CFG_COMPASS_MAX_Y = 13,
+  CFG_COMPASS_MIN_Z = 14,
+  CFG_COMPASS_MAX_Z = 15,
+  CFG_COMPASS_DEADBAND = 16,
+  CFG_COMPASS_CALIBRATED = 17,
+  CFG_JOY_X_MIN = 20,
+  CFG_JOY_X_CENTER = 21,
+  CFG_JOY_X_MAX = 22,
+  CFG_JOY_Y_MIN = 23,
+  CFG_JOY_Y_CENTER = 24,
+  CFG_JOY_Y_MAX = 25,
+  CFG_JOY_DEADBAND = 26,
+  CFG_JOY_CALIBRATED = 27,
+  CFG_SATELLITE_NAME = 30,
+  CFG_TLE_LINE1 = 31,
+  CFG_TLE_LINE2 = 32,
+  CFG_TLE_VALID = 33
+} ConfigFieldId;
+
+typedef enum : uint8_t {
+  FIELD_VALUE,       // Stored as its raw bytes
+  FIELD_STRING       // char array; stored up to the terminator
+} ConfigFieldKind;
+
+struct ConfigField {
+  uint8_t id;        // ConfigFieldId
+  uint8_t kind;      // ConfigFieldKind
+  uint16_t offset;   // Within StorageConfig
+  uint8_t size;
+};
+
+#define CONFIG_FIELD(id, member, kind) \
+  { id, kind, offsetof(StorageConfig, member), sizeof(StorageConfig::member) }
+
+static constexpr ConfigField configFields[] = {
+  CONFIG_FIELD(CFG_WIFI_SSID, wifiSSID, FIELD_STRING),
+  CONFIG_FIELD(CFG_WIFI_PASSWORD, wifiPassword, FIELD_STRING),
+  CONFIG_FIELD(CFG_WIFI_CONFIGURED, wifiConfigured, FIELD_VALUE),
+  CONFIG_FIELD(CFG_COMPASS_MIN_X, compassMinX, FIELD_VALUE),
+  CONFIG_FIELD(CFG_COMPASS_MAX_X, compassMaxX, FIELD_VALUE),
+  CONFIG_FIELD(CFG_COMPASS_MIN_Y, compassMinY, FIELD_VALUE),
+  CONFIG_FIELD(CFG_COMPASS_MAX_Y, compassMaxY, FIELD_VALUE),
+  CONFIG_FIELD(CFG_COMPASS_MIN_Z, compassMinZ, FIELD_VALUE),
+  CONFIG_FIELD(CFG_COMPASS_MAX_Z, compassMaxZ, FIELD_VALUE),
+  CONFIG_FIELD(CFG_COMPASS_DEADBAND, compassDeadband, FIELD_VALUE),
+  CONFIG_FIELD(CFG_COMPASS_CALIBRATED, compassCalibrated, FIELD_VALUE),
+  CONFIG_FIELD(CFG_JOY_X_MIN, joyXMin, FIELD_VALUE),
+  CONFIG_FIELD(CFG_JOY_X_CENTER, joyXCenter, FIELD_VALUE),
+  CONFIG_FIELD(CFG_JOY_X_MAX, joyXMax, FIELD_VALUE),
+  CONFIG_FIELD(CFG_JOY_Y_MIN, joyYMin, FIELD_VALUE),
+  CONFIG_FIELD(CFG_JOY_Y_CENTER, joyYCenter, FIELD_VALUE),
+  CONFIG_FIELD(CFG_JOY_Y_MAX, joyYMax, FIELD_VALUE),
+  CONFIG_FIELD(CFG_JOY_DEADBAND, joyDeadband, FIELD_VALUE),
+  CONFIG_FIELD(CFG_JOY_CALIBRATED, joyCalibrated, FIELD_VALUE),
+  CONFIG_FIELD(CFG_SATELLITE_NAME, satelliteName, FIELD_STRING),
+  CONFIG_FIELD(CFG_TLE_LINE1, tleLine1, FIELD_STRING),
+  CONFIG_FIELD(CFG_TLE_LINE2, tleLine2, FIELD_STRING),
+  CONFIG_FIELD(CFG_TLE_VALID, tleValid, FIELD_VALUE)
+};
+
+#define CONFIG_FIELD_COUNT (sizeof(configFields) / sizeof(configFields[0]))
+
+static constexpr bool configFieldsFit() {
+  for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    if (configFields[i].size > CONFIG_RECORD_MAX_PAYLOAD) return false;
+  }
+  return true;
+}
+static_assert(configFieldsFit(), "config field larger than CONFIG_RECORD_MAX_PAYLOAD");
+
+// One step of forward migration, applied to the RAM copy after an older
+// configuration has been read. A step without an apply function changed
+// only the encoding. When a field changes meaning or units, bump
+// CONFIG_VERSION and add a step that converts it here.
+struct ConfigMigration {
+  uint16_t from;                          // Version the step upgrades
+  void (*apply)(StorageConfig* config);
+  const char* change;
+};
+
+static const ConfigMigration configMigrations[] = {
+  {1, nullptr, "single struct file to field log"},
+  {2, nullptr, "CRC-16 records to CRC-32 with file header"}
+};
+
+static_assert(sizeof(configMigrations) / sizeof(configMigrations[0]) == CONFIG_VERSION - 1,
+              "one migration step per config version");
+
+// Configuration as seen by callers
+static StorageConfig configCache;
+static bool configPresent = false;             // Stored, or saved since boot
+static bool configDirty = false;
+static unsigned long firstChangeMs = 0;        // Oldest change not yet on flash
+static unsigned long lastChangeMs = 0;
+static unsigned long lastFlushAttemptMs = 0;
+static bool flushFailed = false;
+
+// Configuration as on flash, rebuilt from the log at boot
+static StorageConfig storedConfig;
+static uint32_t fieldSeq[CONFIG_FIELD_COUNT];  // Record each field came from (0 = never stored)
+static uint32_t nextSeq = 1;
+static uint16_t logVersion = CONFIG_VERSION;   // Format of the log on flash
+static uint16_t loadedVersion = 0;             // Format read at boot (0 = none)
+static uint32_t loadMs = 0;                    // Time to read and migrate it
+
+// Log statistics
+static uint32_t logBytes = 0;
+static uint32_t logRecords = 0;
+static uint32_t logAppends = 0;                // Records appended since boot
+static uint32_t logCompactions = 0;
+static uint32_t configFlushes = 0;
 
 // ============================================================================
 // INTERNAL FUNCTIONS
 // ============================================================================
 
-// Calculate simple checksum
-static uint16_t calculateChecksum(const StorageConfig* config) {
+// Version 1 checksum: byte sum over everything before the checksum field
+static uint16_t calculateChecksum(const ConfigV1* config) {
   uint16_t checksum = 0;
   const uint8_t* data = (const uint8_t*)config;
-  size_t len = sizeof(StorageConfig) - sizeof(uint16_t); // Exclude checksum field
+  size_t len = sizeof(ConfigV1) - sizeof(uint16_t); // Exclude checksum field
   
   for (size_t i = 0; i < len; i++) {
     checksum += data[i];
@@ -33,14 +240,14 @@ static uint16_t calculateChecksum(const StorageConfig* config) {
   return checksum;
 }
 
-// Validate config structure
-static bool validateConfig(const StorageConfig* config) {
-  if (config->magic != CONFIG_MAGIC) {
+// Validate a version 1 config file
+static bool validateConfig(const ConfigV1* config) {
+  if (config->magic != CONFIG_V1_MAGIC) {
     Serial.println("Config validation failed: bad magic number");
     return false;
   }
   
-  if (config->version != CONFIG_VERSION) {
+  if (config->version != 1) {
     Serial.println("Config validation failed: version mismatch");
     return false;
   }
@@ -119,6 +326,459 @@ static bool initSDCard() {
   return false;
 }
 
+// File access on whichever medium was mounted
+typedef enum {
+  OPEN_READ,
+  OPEN_APPEND,
+  OPEN_TRUNCATE
+} OpenMode;
+
+static File openStorageFile(const char* path, OpenMode mode) {
+  if (currentStorageType == STORAGE_TYPE_W25Q_FLASH) {
+    return LittleFS.open(path, mode == OPEN_READ ? "r" : mode == OPEN_APPEND ? "a" : "w");
+  }
+  if (currentStorageType == STORAGE_TYPE_SD_CARD) {
+    if (mode == OPEN_READ) {
+      return SD.open(path, FILE_READ);
+    }
+    if (mode == OPEN_TRUNCATE) {
+      SD.remove(path);
+    }
+    return SD.open(path, FILE_WRITE);  // Appends
+  }
+  return File();
+}
+
+static bool storageExists(const char* path) {
+  if (currentStorageType == STORAGE_TYPE_W25Q_FLASH) return LittleFS.exists(path);
+  if (currentStorageType == STORAGE_TYPE_SD_CARD) return SD.exists(path);
+  return false;
+}
+
+static bool storageRemove(const char* path) {
+  if (currentStorageType == STORAGE_TYPE_W25Q_FLASH) return LittleFS.remove(path);
+  if (currentStorageType == STORAGE_TYPE_SD_CARD) return SD.remove(path);
+  return false;
+}
+
+// Replace 'to' with 'from'. Atomic on LittleFS; on SD the target is
+// removed first and initConfigLog() finishes an interrupted swap.
+static bool storageReplace(const char* from, const char* to) {
+  if (currentStorageType == STORAGE_TYPE_W25Q_FLASH) return LittleFS.rename(from, to);
+  if (currentStorageType == STORAGE_TYPE_SD_CARD) {
+    SD.remove(to);
+    return SD.rename(from, to);
+  }
+  return false;
+}
+
+static int findConfigField(uint8_t id) {
+  for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    if (configFields[i].id == id) return i;
+  }
+  return -1;
+}
+
+static bool configFieldEqual(size_t index, const StorageConfig* a, const StorageConfig* b) {
+  const ConfigField& field = configFields[index];
+  const char* va = (const char*)a + field.offset;
+  const char* vb = (const char*)b + field.offset;
+  if (field.kind == FIELD_STRING) {
+    return strncmp(va, vb, field.size - 1) == 0;
+  }
+  return memcmp(va, vb, field.size) == 0;
+}
+
+// Set a field from a record payload. Fixed-size values must match the
+// field size exactly; strings are truncated and terminated.
+static bool applyConfigField(StorageConfig* config, size_t index, const uint8_t* payload, size_t len) {
+  const ConfigField& field = configFields[index];
+  uint8_t* value = (uint8_t*)config + field.offset;
+  if (field.kind == FIELD_STRING) {
+    size_t n = min(len, (size_t)field.size - 1);
+    memcpy(value, payload, n);
+    memset(value + n, 0, field.size - n);
+    return true;
+  }
+  if (len != field.size) {
+    return false;
+  }
+  memcpy(value, payload, len);
+  return true;
+}
+
+static size_t encodeConfigRecord(uint8_t* out, size_t index, const StorageConfig* config,
+                                 uint32_t seq, bool last) {
+  const ConfigField& field = configFields[index];
+  const uint8_t* value = (const uint8_t*)config + field.offset;
+  size_t len = field.size;
+  if (field.kind == FIELD_STRING) {
+    len = strnlen((const char*)value, field.size - 1);
+  }
+
+  out[0] = CONFIG_RECORD_MARKER;
+  out[1] = field.id;
+  out[2] = len;
+  out[3] = last ? CONFIG_RECORD_END : 0;
+  out[4] = seq & 0xFF;
+  out[5] = (seq >> 8) & 0xFF;
+  out[6] = (seq >> 16) & 0xFF;
+  out[7] = seq >> 24;
+  memcpy(out + CONFIG_RECORD_HEADER_SIZE, value, len);
+
+  size_t n = CONFIG_RECORD_HEADER_SIZE + len;
+  uint32_t crc = calculateCrc32(out, n);
+  out[n] = crc & 0xFF;
+  out[n + 1] = (crc >> 8) & 0xFF;
+  out[n + 2] = (crc >> 16) & 0xFF;
+  out[n + 3] = crc >> 24;
+  return n + 4;
+}
+
+static void encodeLogHeader(uint8_t* out) {
+  uint32_t magic = CONFIG_LOG_MAGIC;
+  memcpy(out, &magic, 4);
+  out[4] = CONFIG_VERSION & 0xFF;
+  out[5] = CONFIG_VERSION >> 8;
+  out[6] = 0;
+  out[7] = 0;
+  uint32_t crc = calculateCrc32(out, 8);
+  memcpy(out + 8, &crc, 4);
+}
+
+// Format version of an open log, leaving the file at the first record.
+// Version 2 logs have no header and start with a record; 0 means the
+// header is damaged.
+static uint16_t readLogVersion(File& file) {
+  uint8_t header[CONFIG_LOG_HEADER_SIZE];
+  size_t n = file.read(header, sizeof(header));
+  if (n > 0 && header[0] == CONFIG_RECORD_MARKER) {
+    file.seek(0);
+    return 2;
+  }
+
+  uint32_t magic, crc;
+  memcpy(&magic, header, 4);
+  memcpy(&crc, header + 8, 4);
+  if (n != sizeof(header) || magic != CONFIG_LOG_MAGIC || crc != calculateCrc32(header, 8)) {
+    return 0;
+  }
+  return header[4] | (header[5] << 8);
+}
+
+static bool configStored() {
+  for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    if (fieldSeq[i] != 0) return true;
+  }
+  return false;
+}
+
+static void resetStoredConfig() {
+  memset(&storedConfig, 0, sizeof(storedConfig));
+  memset(fieldSeq, 0, sizeof(fieldSeq));
+  nextSeq = 1;
+  logBytes = 0;
+  logRecords = 0;
+  logVersion = CONFIG_VERSION;
+}
+
+// Replay log records (version 2 or 3) into storedConfig, one complete
+// batch at a time. Returns the number of bytes read up to the end of
+// the last complete batch; anything after it is a torn append.
+static uint32_t replayConfigLog(File& file, uint16_t version) {
+  StorageConfig work = storedConfig;
+  uint32_t workSeq[CONFIG_FIELD_COUNT];
+  memcpy(workSeq, fieldSeq, sizeof(workSeq));
+
+  size_t crcSize = version >= 3 ? 4 : 2;
+  uint8_t record[CONFIG_RECORD_MAX_SIZE];
+  uint32_t offset = file.position();
+  uint32_t committed = offset;
+  uint32_t batchRecords = 0;
+
+  while (file.read(record, CONFIG_RECORD_HEADER_SIZE) == CONFIG_RECORD_HEADER_SIZE) {
+    size_t len = record[2];
+    if (record[0] != CONFIG_RECORD_MARKER || len > CONFIG_RECORD_MAX_PAYLOAD) break;
+    if (file.read(record + CONFIG_RECORD_HEADER_SIZE, len + crcSize) != len + crcSize) break;
+
+    size_t n = CONFIG_RECORD_HEADER_SIZE + len;
+    bool crcOk;
+    if (crcSize == 4) {
+      uint32_t crc;
+      memcpy(&crc, record + n, 4);
+      crcOk = crc == calculateCrc32(record, n);
+    } else {
+      crcOk = (record[n] | (record[n + 1] << 8)) == calculateCrc16(record, n);
+    }
+    if (!crcOk) break;
+    offset += n + crcSize;
+    batchRecords++;
+
+    uint32_t seq = record[4] | (record[5] << 8) | (record[6] << 16) | ((uint32_t)record[7] << 24);
+    if (seq >= nextSeq) {
+      nextSeq = seq + 1;
+    }
+
+    int index = findConfigField(record[1]);
+    if (index >= 0 && seq > workSeq[index] &&
+        applyConfigField(&work, index, record + CONFIG_RECORD_HEADER_SIZE, len)) {
+      workSeq[index] = seq;
+    }
+
+    if (record[3] & CONFIG_RECORD_END) {
+      storedConfig = work;
+      memcpy(fieldSeq, workSeq, sizeof(fieldSeq));
+      committed = offset;
+      logRecords += batchRecords;
+      batchRecords = 0;
+    }
+  }
+
+  return committed;
+}
+
+// Read a version 1 struct file into storedConfig
+static bool readConfigV1() {
+  File file = openStorageFile(CONFIG_V1_FILENAME, OPEN_READ);
+  if (!file) {
+    return false;
+  }
+
+  ConfigV1 v1;
+  size_t bytesRead = file.read((uint8_t*)&v1, sizeof(ConfigV1));
+  file.close();
+  if (bytesRead != sizeof(ConfigV1) || !validateConfig(&v1)) {
+    return false;
+  }
+
+  StorageConfig& c = storedConfig;
+  memcpy(c.wifiSSID, v1.wifiSSID, sizeof(c.wifiSSID));
+  memcpy(c.wifiPassword, v1.wifiPassword, sizeof(c.wifiPassword));
+  c.wifiConfigured = v1.wifiConfigured;
+  c.compassMinX = v1.compassMinX;
+  c.compassMaxX = v1.compassMaxX;
+  c.compassMinY = v1.compassMinY;
+  c.compassMaxY = v1.compassMaxY;
+  c.compassMinZ = v1.compassMinZ;
+  c.compassMaxZ = v1.compassMaxZ;
+  c.compassDeadband = v1.compassDeadband;
+  c.compassCalibrated = v1.compassCalibrated;
+  c.joyXMin = v1.joyXMin;
+  c.joyXCenter = v1.joyXCenter;
+  c.joyXMax = v1.joyXMax;
+  c.joyYMin = v1.joyYMin;
+  c.joyYCenter = v1.joyYCenter;
+  c.joyYMax = v1.joyYMax;
+  c.joyDeadband = v1.joyDeadband;
+  c.joyCalibrated = v1.joyCalibrated;
+  memcpy(c.satelliteName, v1.satelliteName, sizeof(c.satelliteName));
+  memcpy(c.tleLine1, v1.tleLine1, sizeof(c.tleLine1));
+  memcpy(c.tleLine2, v1.tleLine2, sizeof(c.tleLine2));
+  c.tleValid = v1.tleValid;
+
+  for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    fieldSeq[i] = nextSeq++;
+  }
+  return true;
+}
+
+// Apply every migration step from 'version' up to CONFIG_VERSION
+static void migrateConfig(uint16_t version) {
+  for (const ConfigMigration& step : configMigrations) {
+    if (step.from < version) continue;
+    if (step.apply) {
+      step.apply(&storedConfig);
+    }
+    Serial.printf("Config migration v%u -> v%u: %s\n", step.from, step.from + 1, step.change);
+  }
+}
+
+// Write all fields of 'source' to a fresh current-format log and swap it
+// in for the old one. storedConfig becomes 'source' only on success.
+static bool compactConfigLog(const StorageConfig* source) {
+  File file = openStorageFile(CONFIG_LOG_TEMP_FILENAME, OPEN_TRUNCATE);
+  if (!file) {
+    Serial.println("Config log compaction failed: cannot create file");
+    return false;
+  }
+
+  uint8_t record[CONFIG_RECORD_MAX_SIZE];
+  encodeLogHeader(record);
+  bool ok = file.write(record, CONFIG_LOG_HEADER_SIZE) == CONFIG_LOG_HEADER_SIZE;
+  uint32_t bytes = CONFIG_LOG_HEADER_SIZE;
+  for (size_t i = 0; ok && i < CONFIG_FIELD_COUNT; i++) {
+    size_t n = encodeConfigRecord(record, i, source, nextSeq + i, i == CONFIG_FIELD_COUNT - 1);
+    ok = file.write(record, n) == n;
+    bytes += n;
+  }
+  file.close();
+
+  if (!ok || !storageReplace(CONFIG_LOG_TEMP_FILENAME, CONFIG_LOG_FILENAME)) {
+    storageRemove(CONFIG_LOG_TEMP_FILENAME);
+    Serial.println("Config log compaction failed");
+    return false;
+  }
+
+  storedConfig = *source;
+  for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    fieldSeq[i] = nextSeq++;
+  }
+  logBytes = bytes;
+  logRecords = CONFIG_FIELD_COUNT;
+  logVersion = CONFIG_VERSION;
+  logCompactions++;
+  return true;
+}
+
+// Append the fields of 'config' that differ from the stored values as
+// one batch. On a write error the log is rewritten from the RAM copy so
+// no later append lands behind a partial record.
+static bool appendConfigChanges(const StorageConfig* config, uint32_t* changedCount) {
+  uint8_t changed[CONFIG_FIELD_COUNT];
+  size_t count = 0;
+  for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    if (fieldSeq[i] == 0 || !configFieldEqual(i, config, &storedConfig)) {
+      changed[count++] = i;
+    }
+  }
+  *changedCount = count;
+  if (count == 0) {
+    return true;
+  }
+
+  // An older log that could not be migrated at boot, or one left with a
+  // torn tail by a failed rescue, is rewritten whole
+  if (logVersion != CONFIG_VERSION) {
+    return compactConfigLog(config);
+  }
+
+  File file = openStorageFile(CONFIG_LOG_FILENAME, OPEN_APPEND);
+  if (!file) {
+    return false;
+  }
+
+  uint8_t record[CONFIG_RECORD_MAX_SIZE];
+  uint32_t bytes = 0;
+  bool ok = true;
+  if (file.size() == 0) {
+    encodeLogHeader(record);
+    ok = file.write(record, CONFIG_LOG_HEADER_SIZE) == CONFIG_LOG_HEADER_SIZE;
+    bytes += CONFIG_LOG_HEADER_SIZE;
+  }
+  for (size_t k = 0; ok && k < count; k++) {
+    size_t n = encodeConfigRecord(record, changed[k], config, nextSeq + k, k == count - 1);
+    ok = file.write(record, n) == n;
+    bytes += n;
+  }
+  file.close();
+
+  if (!ok) {
+    // A torn tail stays on flash until the rewrite succeeds; never append
+    // after it (the next flush rewrites the log whole instead)
+    if (!compactConfigLog(&storedConfig)) {
+      logVersion = 0;
+    }
+    return false;
+  }
+
+  for (size_t k = 0; k < count; k++) {
+    const ConfigField& field = configFields[changed[k]];
+    memcpy((uint8_t*)&storedConfig + field.offset, (const uint8_t*)config + field.offset, field.size);
+    fieldSeq[changed[k]] = nextSeq + k;
+  }
+  nextSeq += count;
+  logBytes += bytes;
+  logRecords += count;
+  logAppends += count;
+
+  if (logBytes > CONFIG_LOG_COMPACT_SIZE) {
+    compactConfigLog(&storedConfig);
+  }
+  return true;
+}
+
+static void resetConfig() {
+  resetStoredConfig();
+  memset(&configCache, 0, sizeof(configCache));
+  configPresent = false;
+  configDirty = false;
+  flushFailed = false;
+}
+
+static void markConfigDirty() {
+  unsigned long now = millis();
+  if (!configDirty) {
+    firstChangeMs = now;
+  }
+  lastChangeMs = now;
+  configDirty = true;
+  configPresent = true;
+}
+
+// Read whichever format is on flash into the RAM copies, migrating an
+// older one and writing it back in the current format
+static void initConfigLog() {
+  resetConfig();
+  unsigned long start = millis();
+
+  if (storageExists(CONFIG_LOG_FILENAME)) {
+    storageRemove(CONFIG_LOG_TEMP_FILENAME);  // Compaction cut short before the swap
+  } else if (storageExists(CONFIG_LOG_TEMP_FILENAME)) {
+    storageReplace(CONFIG_LOG_TEMP_FILENAME, CONFIG_LOG_FILENAME);  // Cut short mid-swap (SD)
+  }
+
+  uint16_t version = 0;
+  uint32_t size = 0;
+  File file = openStorageFile(CONFIG_LOG_FILENAME, OPEN_READ);
+  if (file) {
+    size = file.size();
+    version = readLogVersion(file);
+    if (version == 0) {
+      Serial.println("Config log header damaged, starting from defaults");
+    } else if (version > CONFIG_VERSION) {
+      Serial.printf("Config log v%u is newer than this firmware (v%u), starting from defaults\n",
+                    version, CONFIG_VERSION);
+    } else {
+      logBytes = replayConfigLog(file, version);
+    }
+    file.close();
+    // Anything unreadable is replaced by the first save
+    logVersion = version == CONFIG_VERSION ? version : 0;
+  } else if (readConfigV1()) {
+    version = 1;
+    logVersion = 0;
+  }
+
+  if (version != 0 && version < CONFIG_VERSION) {
+    migrateConfig(version);
+    StorageConfig migrated = storedConfig;
+    if (compactConfigLog(&migrated) && version == 1) {
+      storageRemove(CONFIG_V1_FILENAME);
+    }
+  } else if (version == CONFIG_VERSION && logBytes < size) {
+    Serial.printf("Config log: dropping %lu bytes of incomplete records\n", size - logBytes);
+    if (configStored()) {
+      StorageConfig recovered = storedConfig;
+      compactConfigLog(&recovered);
+    } else {
+      storageRemove(CONFIG_LOG_FILENAME);
+      logBytes = 0;
+    }
+  } else if (logBytes > CONFIG_LOG_COMPACT_SIZE) {
+    StorageConfig current = storedConfig;
+    compactConfigLog(&current);
+  }
+
+  configCache = storedConfig;
+  configPresent = configStored();
+  loadedVersion = version;
+  loadMs = millis() - start;
+  if (configPresent) {
+    Serial.printf("Config v%u loaded in %lu ms: %lu records, %lu bytes\n",
+                  version, loadMs, logRecords, logBytes);
+  }
+}
+
 // ============================================================================
 // PUBLIC API IMPLEMENTATION
 // ============================================================================
@@ -131,6 +791,7 @@ bool initStorage() {
     currentStorageType = STORAGE_TYPE_W25Q_FLASH;
     storageInitialized = true;
     Serial.println("Using W25Q SPI flash storage");
+    initConfigLog();
     return true;
   }
   
@@ -139,6 +800,7 @@ bool initStorage() {
     currentStorageType = STORAGE_TYPE_SD_CARD;
     storageInitialized = true;
     Serial.println("Using SD card storage");
+    initConfigLog();
     return true;
   }
   
@@ -163,35 +825,12 @@ bool loadConfig(StorageConfig* config) {
     return false;
   }
   
-  File file;
-  
-  // Open file based on storage type
-  if (currentStorageType == STORAGE_TYPE_W25Q_FLASH) {
-    file = LittleFS.open(CONFIG_FILENAME, "r");
-  } else if (currentStorageType == STORAGE_TYPE_SD_CARD) {
-    file = SD.open(CONFIG_FILENAME, FILE_READ);
-  }
-  
-  if (!file) {
-    Serial.println("Config file not found");
-    return false;
-  }
-  
-  // Read config structure
-  size_t bytesRead = file.read((uint8_t*)config, sizeof(StorageConfig));
-  file.close();
-  
-  if (bytesRead != sizeof(StorageConfig)) {
-    Serial.println("Config file read error");
-    return false;
-  }
-  
-  // Validate config
-  if (!validateConfig(config)) {
+  if (!configPresent) {
+    Serial.println("No stored configuration");
     return false;
   }
   
-  Serial.println("Configuration loaded successfully");
+  *config = configCache;
   return true;
 }
 
@@ -201,51 +840,58 @@ bool saveConfig(const StorageConfig* config) {
     return false;
   }
   
-  // Create a copy to add magic/version/checksum
-  StorageConfig configCopy = *config;
-  configCopy.magic = CONFIG_MAGIC;
-  configCopy.version = CONFIG_VERSION;
-  configCopy.checksum = calculateChecksum(&configCopy);
-  
-  File file;
-  
-  // Open file based on storage type
-  if (currentStorageType == STORAGE_TYPE_W25Q_FLASH) {
-    file = LittleFS.open(CONFIG_FILENAME, "w");
-  } else if (currentStorageType == STORAGE_TYPE_SD_CARD) {
-    file = SD.open(CONFIG_FILENAME, FILE_WRITE);
+  configCache = *config;
+  markConfigDirty();
+  return true;
+}
+
+void updateStorage() {
+  if (!configDirty) {
+    return;
   }
   
-  if (!file) {
-    Serial.println("Failed to open config file for writing");
-    return false;
+  unsigned long now = millis();
+  if (now - lastChangeMs < CONFIG_FLUSH_QUIET_MS &&
+      now - firstChangeMs < CONFIG_FLUSH_MAX_DELAY_MS) {
+    return;
+  }
+  if (flushFailed && now - lastFlushAttemptMs < CONFIG_FLUSH_RETRY_MS) {
+    return;
   }
   
-  // Write config structure
-  size_t bytesWritten = file.write((const uint8_t*)&configCopy, sizeof(StorageConfig));
-  file.close();
+  lastFlushAttemptMs = now;
+  flushFailed = !flushConfig();
+}
+
+bool flushConfig() {
+  if (!configDirty) {
+    return true;
+  }
   
-  if (bytesWritten != sizeof(StorageConfig)) {
-    Serial.println("Config file write error");
+  uint32_t changed;
+  if (!appendConfigChanges(&configCache, &changed)) {
+    Serial.println("Config log write error, will retry");
     return false;
   }
   
-  Serial.println("Configuration saved successfully");
+  configDirty = false;
+  configFlushes++;
   return true;
 }
 
+bool isConfigDirty() {
+  return configDirty;
+}
+
 bool eraseConfig() {
   if (!storageInitialized) {
     return false;
   }
   
-  bool result = false;
-  
-  if (currentStorageType == STORAGE_TYPE_W25Q_FLASH) {
-    result = LittleFS.remove(CONFIG_FILENAME);
-  } else if (currentStorageType == STORAGE_TYPE_SD_CARD) {
-    result = SD.remove(CONFIG_FILENAME);
-  }
+  bool result = storageRemove(CONFIG_LOG_FILENAME);
+  storageRemove(CONFIG_LOG_TEMP_FILENAME);
+  storageRemove(CONFIG_V1_FILENAME);
+  resetConfig();
   
   if (result) {
     Serial.println("Configuration erased");
@@ -272,11 +918,12 @@ bool formatStorage() {
       LittleFS.begin();
     }
   } else if (currentStorageType == STORAGE_TYPE_SD_CARD) {
-    // SD card format not supported, just delete config file
-    result = SD.remove(CONFIG_FILENAME);
+    // SD card format not supported, just delete the config log
+    result = SD.remove(CONFIG_LOG_FILENAME);
   }
   
   if (result) {
+    resetConfig();
     Serial.println("Storage formatted");
   } else {
     Serial.println("Format failed");
@@ -315,18 +962,28 @@ void printStorageInfo() {
       break;
   }
   
+  if (storageInitialized) {
+    Serial.printf("Config log: %lu bytes, %lu records (compacts at %u)\n",
+                  logBytes, logRecords, CONFIG_LOG_COMPACT_SIZE);
+    Serial.printf("Appends: %lu since boot, %lu compactions, next seq %lu\n",
+                  logAppends, logCompactions, nextSeq);
+    Serial.printf("Flushes: %lu, pending: %s\n", configFlushes,
+                  configDirty ? "yes" : "no");
+    Serial.printf("Format: v%u (read v%u at boot in %lu ms)\n",
+                  CONFIG_VERSION, loadedVersion, loadMs);
+  }
+  
   Serial.println();
 }
 
 // ============================================================================
 // CONVENIENCE FUNCTIONS
 // ============================================================================
+// All of these work on the RAM cache; the next flush appends only the
+// fields that actually changed.
 
 bool saveWiFiCredentials(const char* ssid, const char* password) {
-  StorageConfig config = {0};
-  
-  // Try to load existing config
-  loadConfig(&config);
+  StorageConfig config = configCache;
   
   // Update WiFi credentials
   strncpy(config.wifiSSID, ssid, sizeof(config.wifiSSID) - 1);
@@ -341,25 +998,18 @@ bool saveWiFiCredentials(const char* ssid, const char* password) {
 }
 
 bool loadWiFiCredentials(char* ssid, char* password) {
-  StorageConfig config = {0};
-  
-  if (!loadConfig(&config)) {
+  if (!configCache.wifiConfigured) {
     return false;
   }
   
-  if (!config.wifiConfigured) {
-    return false;
-  }
-  
-  strcpy(ssid, config.wifiSSID);
-  strcpy(password, config.wifiPassword);
+  strcpy(ssid, configCache.wifiSSID);
+  strcpy(password, configCache.wifiPassword);
   
   return true;
 }
 
 bool saveCompassCalibration(int minX, int maxX, int minY, int maxY, int minZ, int maxZ) {
-  StorageConfig config = {0};
-  loadConfig(&config);
+  StorageConfig config = configCache;
   
   config.compassMinX = minX;
   config.compassMaxX = maxX;
@@ -373,30 +1023,23 @@ bool saveCompassCalibration(int minX, int maxX, int minY, int maxY, int minZ, in
 }
 
 bool loadCompassCalibration(int* minX, int* maxX, int* minY, int* maxY, int* minZ, int* maxZ) {
-  StorageConfig config = {0};
-  
-  if (!loadConfig(&config)) {
+  if (!configCache.compassCalibrated) {
     return false;
   }
   
-  if (!config.compassCalibrated) {
-    return false;
-  }
-  
-  *minX = config.compassMinX;
-  *maxX = config.compassMaxX;
-  *minY = config.compassMinY;
-  *maxY = config.compassMaxY;
-  *minZ = config.compassMinZ;
-  *maxZ = config.compassMaxZ;
+  *minX = configCache.compassMinX;
+  *maxX = configCache.compassMaxX;
+  *minY = configCache.compassMinY;
+  *maxY = configCache.compassMaxY;
+  *minZ = configCache.compassMinZ;
+  *maxZ = configCache.compassMaxZ;
   
   return true;
 }
 
 bool saveJoystickCalibration(uint16_t xMin, uint16_t xCenter, uint16_t xMax,
                              uint16_t yMin, uint16_t yCenter, uint16_t yMax, uint16_t deadband) {
-  StorageConfig config = {0};
-  loadConfig(&config);
+  StorageConfig config = configCache;
   
   config.joyXMin = xMin;
   config.joyXCenter = xCenter;
@@ -412,30 +1055,23 @@ bool saveJoystickCalibration(uint16_t xMin, uint16_t xCenter, uint16_t xMax,
 
 bool loadJoystickCalibration(uint16_t* xMin, uint16_t* xCenter, uint16_t* xMax,
                              uint16_t* yMin, uint16_t* yCenter, uint16_t* yMax, uint16_t* deadband) {
-  StorageConfig config = {0};
-  
-  if (!loadConfig(&config)) {
+  if (!configCache.joyCalibrated) {
     return false;
   }
   
-  if (!config.joyCalibrated) {
-    return false;
-  }
-  
-  *xMin = config.joyXMin;
-  *xCenter = config.joyXCenter;
-  *xMax = config.joyXMax;
-  *yMin = config.joyYMin;
-  *yCenter = config.joyYCenter;
-  *yMax = config.joyYMax;
-  *deadband = config.joyDeadband;
+  *xMin = configCache.joyXMin;
+  *xCenter = configCache.joyXCenter;
+  *xMax = configCache.joyXMax;
+  *yMin = configCache.joyYMin;
+  *yCenter = configCache.joyYCenter;
+  *yMax = configCache.joyYMax;
+  *deadband = configCache.joyDeadband;
   
   return true;
 }
 
 bool saveTLE(const char* name, const char* line1, const char* line2) {
-  StorageConfig config = {0};
-  loadConfig(&config);
+  StorageConfig config = configCache;
   
   strncpy(config.satelliteName, name, sizeof(config.satelliteName) - 1);
   config.satelliteName[sizeof(config.satelliteName) - 1] = '\0';
@@ -452,19 +1088,13 @@ bool saveTLE(const char* name, const char* line1, const char* line2) {
 }
 
 bool loadTLE(char* name, char* line1, char* line2) {
-  StorageConfig config = {0};
-  
-  if (!loadConfig(&config)) {
-    return false;
-  }
-  
-  if (!config.tleValid) {
+  if (!configCache.tleValid) {
     return false;
   }
   
-  strcpy(name, config.satelliteName);
-  strcpy(line1, config.tleLine1);
-  strcpy(line2, config.tleLine2);
+  strcpy(name, configCache.satelliteName);
+  strcpy(line1, configCache.tleLine1);
+  strcpy(line2, configCache.tleLine2);
   
   return true;
 }
@@ -0,0 +1,994 @@
+// ============================================================================
+// tle_catalog.cpp - On-flash TLE catalog and streaming 3LE ingest
+// ============================================================================
+
+#include "tle_catalog.h"
+#include "crc32.h"
+#include <LittleFS.h>
+
+// Input arrives in arbitrary pieces (TCP segments, serial reads). Bytes
+// are assembled into lines in a small buffer; a name line and the two
+// element lines form an entry, which is validated and appended to a
+// temporary file. When the upload ends, stepCatalogBuild() sorts it into
+// a new live catalog a few records at a time.
+//
+// Committed catalog file (little-endian):
+//   CatalogHeader
+//   TleRecord[count]            Sorted by NORAD ID, one per ID
+//   uint32 ids[count]           NORAD ID of each record
+//   uint32 crc                  CRC-32 of the ID table
+//   CatalogNameKey[count]       Sorted by key, then record index
+//   uint32 crc                  CRC-32 of the name index
+// The two tables are read into RAM when the catalog is opened. An ID
+// lookup is a binary search over ids[], a name lookup one over the keys;
+// either way the record itself is a single seek and read.
+
+#define TLE_CATALOG_MAGIC 0x54414354     // "TCAT"
+#define CATALOG_BUILD_RECORDS_PER_STEP 8 // Record reads/writes per stepCatalogBuild()
+#define TLE_CATALOG_VERSION 3            // 1: unsorted, no header; 2: no elements
+#define TLE_MAX_NORAD_ID 339999          // Alpha-5 "Z9999"
+
+struct CatalogHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordSize;       // sizeof(TleRecord)
+  uint32_t count;
+  uint32_t idTableOffset;
+  uint32_t nameIndexOffset;
+  uint32_t crc;              // CRC-32 over the fields above
+};
+
+struct CatalogNameKey {
+  char key[TLE_NAME_KEY_LENGTH];  // Upper-cased, zero padded
+  uint16_t record;
+};
+
+// Records of older catalogs, for converting them
+struct TleRecordV1 {
+  uint32_t noradId;
+  char name[25];
+  char line1[TLE_LINE_LENGTH + 1];
+  char line2[TLE_LINE_LENGTH + 1];
+};
+
+struct TleRecordV2 {
+  uint32_t noradId;
+  uint32_t epoch;
+  char name[25];
+  char line1[TLE_LINE_LENGTH + 1];
+  char line2[TLE_LINE_LENGTH + 1];
+};
+
+// While a catalog is built, each ID table slot holds the NORAD ID and the
+// entry's position in the upload: (id << 11) | position. Sorting those
+// orders by ID, then by arrival, without a second array.
+#define BUILD_POSITION_BITS 11
+#define BUILD_POSITION_MASK ((1u << BUILD_POSITION_BITS) - 1)
+static_assert(TLE_CATALOG_MAX_ENTRIES <= (1 << BUILD_POSITION_BITS), "upload position must fit");
+static_assert(2 * TLE_CATALOG_MAX_ENTRIES * sizeof(TleRecord) <= 420 * 1024,
+              "upload and sorted catalog must fit beside the other files");
+static_assert(((uint64_t)TLE_MAX_NORAD_ID << BUILD_POSITION_BITS) <= 0xFFFFFFFF, "NORAD ID must fit");
+
+// Catalog build, one phase at a time from stepCatalogBuild()
+typedef enum {
+  BUILD_IDLE = 0,
+  BUILD_CONVERT,             // Older catalog rewritten as an upload
+  BUILD_SCAN,                // Upload read into ID slots and name keys
+  BUILD_SORT,                // Both tables sorted in RAM, header written
+  BUILD_COPY,                // Records copied in ID order
+  BUILD_TABLES,              // Tables written, new file renamed into place
+  BUILD_DONE,
+  BUILD_FAILED
+} BuildPhase;
+
+typedef enum {
+  TLE_OK = 0,
+  TLE_BAD_FORMAT,
+  TLE_BAD_CHECKSUM
+} TleCheck;
+
+// Ingest state
+static bool ingestActive = false;
+static File ingestFile;
+static unsigned long ingestStart = 0;
+static CatalogIngestStats ingestStats;
+static CatalogIngestStats lastStats;
+static bool haveLastStats = false;
+
+static char lineBuf[TLE_INGEST_LINE_SIZE];
+static uint8_t lineLen = 0;
+static bool lineTooLong = false;
+
+static TleRecord pendingRecord;        // Entry being assembled
+static bool haveName = false;
+static bool haveLine1 = false;
+
+// RAM index of the live catalog (Core 0 only)
+static uint32_t indexIds[TLE_CATALOG_MAX_ENTRIES];
+static CatalogNameKey nameIndex[TLE_CATALOG_MAX_ENTRIES];
+static uint32_t catalogCount = 0;
+static bool indexLoaded = false;        // False until first use and after a commit
+static File catalogFile;                // Kept open for record reads
+static uint32_t indexLoadMs = 0;
+static uint32_t lastLookupUs = 0;
+static uint32_t catalogGeneration = 0;
+
+// Build state
+static BuildPhase buildPhase = BUILD_IDLE;
+static bool buildFromIngest = false;    // Finish the ingest stats when done
+static uint16_t convertVersion = 0;     // Format being converted, 0 for an upload
+static File buildIn;                    // Old catalog, then the upload
+static File buildOut;                   // Upload (converting), then the new catalog
+static uint32_t buildTotal = 0;         // Records in buildIn
+static uint32_t buildPos = 0;
+static uint32_t buildCount = 0;         // Records left after dropping duplicates
+
+// ============================================================================
+// INTERNAL FUNCTIONS
+// ============================================================================
+
+// Modulo-10 checksum over columns 1-68: digits count their value, '-' one
+static bool checksumValid(const char* line) {
+  int sum = 0;
+  for (int i = 0; i < TLE_LINE_LENGTH - 1; i++) {
+    char c = line[i];
+    if (c >= '0' && c <= '9') {
+      sum += c - '0';
+    } else if (c == '-') {
+      sum += 1;
+    }
+  }
+  char check = line[TLE_LINE_LENGTH - 1];
+  return check >= '0' && check <= '9' && (sum % 10) == check - '0';
+}
+
+static bool allDigits(const char* s, int len) {
+  for (int i = 0; i < len; i++) {
+    if (s[i] < '0' || s[i] > '9') return false;
+  }
+  return true;
+}
+
+// Catalog number from columns 3-7, including Alpha-5 (A=10 ... Z=33, no
+// I or O). Returns 0 if the field is malformed.
+static uint32_t parseCatalogNumber(const char* field) {
+  uint32_t first;
+  char c = field[0];
+  if (c >= '0' && c <= '9') {
+    first = c - '0';
+  } else if (c >= 'A' && c <= 'Z' && c != 'I' && c != 'O') {
+    first = 10 + (c - 'A') - (c > 'I') - (c > 'O');
+  } else if (c == ' ') {
+    first = 0;
+  } else {
+    return 0;
+  }
+
+  uint32_t rest = 0;
+  for (int i = 1; i < 5; i++) {
+    if (field[i] == ' ' && rest == 0) continue;
+    if (field[i] < '0' || field[i] > '9') return 0;
+    rest = rest * 10 + (field[i] - '0');
+  }
+  return first * 10000 + rest;
+}
+
+// Epoch in columns 19-32 (YYDDD.DDDDDDDD) as Unix time. Years 57-99 are
+// 1957-1999; the leap rule is exact for 1970-2099.
+static uint32_t parseEpoch(const char* line1) {
+  int yy = (line1[18] - '0') * 10 + (line1[19] - '0');
+  int year = yy < 57 ? 2000 + yy : 1900 + yy;
+  if (year < 1970) {
+    return 0;
+  }
+
+  uint32_t day = (line1[20] - '0') * 100 + (line1[21] - '0') * 10 + (line1[22] - '0');
+  uint32_t frac = 0;
+  for (int i = 24; i < 32; i++) {
+    frac = frac * 10 + (line1[i] - '0');
+  }
+
+  uint32_t days = 365 * (year - 1970) + (year - 1969) / 4 + day - 1;
+  return days * 86400 + (uint32_t)(((uint64_t)frac * 86400 + 50000000) / 100000000);
+}
+
+// Fixed-column decimal field ("  51.6416", "15.50377579"). No strtod:
+// newlib's version allocates.
+static bool parseFixedField(const char* field, int len, float* out) {
+  int i = 0;
+  while (i < len && field[i] == ' ') i++;
+
+  bool negative = false;
+  if (i < len && (field[i] == '-' || field[i] == '+')) {
+    negative = field[i] == '-';
+    i++;
+  }
+
+  uint32_t whole = 0;
+  uint32_t frac = 0;
+  uint32_t scale = 1;
+  bool digits = false;
+  bool point = false;
+  for (; i < len; i++) {
+    char c = field[i];
+    if (c == '.' && !point) {
+      point = true;
+    } else if (c >= '0' && c <= '9') {
+      digits = true;
+      if (!point) {
+        whole = whole * 10 + (c - '0');
+      } else if (scale < 100000000) {
+        frac = frac * 10 + (c - '0');
+        scale *= 10;
+      }
+    } else {
+      return false;
+    }
+  }
+  if (!digits) return false;
+
+  float value = whole + (float)frac / scale;
+  *out = negative ? -value : value;
+  return true;
+}
+
+// Exponent field with an implied leading point (" 10270-3" = 0.10270e-3)
+static bool parseExponentField(const char* field, float* out) {
+  float mantissa;
+  char buf[8] = {'.'};
+  memcpy(buf + 1, field + 1, 5);
+  if (!parseFixedField(buf, 6, &mantissa) || (field[6] != '-' && field[6] != '+') ||
+      field[7] < '0' || field[7] > '9') {
+    return false;
+  }
+
+  int exponent = field[7] - '0';
+  float value = mantissa * powf(10.0f, field[6] == '-' ? -exponent : exponent);
+  *out = field[0] == '-' ? -value : value;
+  return true;
+}
+
+// Mean elements from their fixed columns (line 2: inclination 9-16, RAAN
+// 18-25, eccentricity 27-33 with an implied point, argument of perigee
+// 35-42, mean anomaly 44-51, mean motion 53-63; line 1: B* 54-61)
+static bool parseElements(const char* line1, const char* line2, TleElements* el) {
+  char ecc[9] = {'.'};
+  memcpy(ecc + 1, line2 + 26, 7);
+  return parseFixedField(line2 + 8, 8, &el->inclination) &&
+         parseFixedField(line2 + 17, 8, &el->raan) &&
+         parseFixedField(ecc, 8, &el->eccentricity) &&
+         parseFixedField(line2 + 34, 8, &el->argPerigee) &&
+         parseFixedField(line2 + 43, 8, &el->meanAnomaly) &&
+         parseFixedField(line2 + 52, 11, &el->meanMotion) &&
+         parseExponentField(line1 + 53, &el->bstar);
+}
+
+static TleCheck checkTle(const char* line1, const char* line2, const char** reason) {
+  *reason = "";
+
+  if (strlen(line1) != TLE_LINE_LENGTH || strlen(line2) != TLE_LINE_LENGTH) {
+    *reason = "lines must be 69 characters";
+    return TLE_BAD_FORMAT;
+  }
+  if (line1[0] != '1' || line1[1] != ' ' || line2[0] != '2' || line2[1] != ' ') {
+    *reason = "lines must start with '1 ' and '2 '";
+    return TLE_BAD_FORMAT;
+  }
+  if (!checksumValid(line1) || !checksumValid(line2)) {
+    *reason = "checksum mismatch";
+    return TLE_BAD_CHECKSUM;
+  }
+
+  uint32_t id1 = parseCatalogNumber(line1 + 2);
+  uint32_t id2 = parseCatalogNumber(line2 + 2);
+  if (id1 == 0 || id1 != id2) {
+    *reason = "catalog numbers missing or different";
+    return TLE_BAD_FORMAT;
+  }
+
+  // Epoch YYDDD.DDDDDDDD in columns 19-32
+  int day = (line1[20] - '0') * 100 + (line1[21] - '0') * 10 + (line1[22] - '0');
+  if (!allDigits(line1 + 18, 5) || line1[23] != '.' || !allDigits(line1 + 24, 8) ||
+      day < 1 || day > 366) {
+    *reason = "bad epoch";
+    return TLE_BAD_FORMAT;
+  }
+
+  // Inclination (cols 9-16), eccentricity (27-33, implied point), mean
+  // motion (53-63)
+  float inclination, meanMotion;
+  if (!parseFixedField(line2 + 8, 8, &inclination) || inclination < 0.0f || inclination > 180.0f) {
+    *reason = "bad inclination";
+    return TLE_BAD_FORMAT;
+  }
+  if (!allDigits(line2 + 26, 7)) {
+    *reason = "bad eccentricity";
+    return TLE_BAD_FORMAT;
+  }
+  if (!parseFixedField(line2 + 52, 11, &meanMotion) || meanMotion <= 0.0f || meanMotion >= 20.0f) {
+    *reason = "bad mean motion";
+    return TLE_BAD_FORMAT;
+  }
+
+  return TLE_OK;
+}
+
+// Validate the assembled entry and append it to the upload file
+static void commitEntry() {
+  const char* reason;
+  TleCheck result = checkTle(pendingRecord.line1, pendingRecord.line2, &reason);
+  haveLine1 = false;
+  haveName = false;
+
+  if (result == TLE_BAD_CHECKSUM) {
+    ingestStats.badChecksum++;
+    return;
+  }
+  if (result != TLE_OK || !parseElements(pendingRecord.line1, pendingRecord.line2, &pendingRecord.elements)) {
+    ingestStats.badFormat++;
+    return;
+  }
+  if (ingestStats.entries >= TLE_CATALOG_MAX_ENTRIES) {
+    ingestStats.dropped++;
+    return;
+  }
+
+  pendingRecord.noradId = parseCatalogNumber(pendingRecord.line1 + 2);
+  pendingRecord.epoch = parseEpoch(pendingRecord.line1);
+  if (ingestFile.write((const uint8_t*)&pendingRecord, sizeof(pendingRecord)) != sizeof(pendingRecord)) {
+    ingestStats.dropped++;  // Filesystem full
+    return;
+  }
+  ingestStats.entries++;
+}
+
+static void copyLine(char* dest, const char* line) {
+  memcpy(dest, line, TLE_LINE_LENGTH);
+  dest[TLE_LINE_LENGTH] = '\0';
+}
+
+// Classify one complete input line (CR and trailing blanks stripped)
+static void processLine(char* line, uint8_t len) {
+  ingestStats.lines++;
+  if (len == 0) {
+    return;
+  }
+
+  if (len == TLE_LINE_LENGTH && line[0] == '1' && line[1] == ' ') {
+    if (haveLine1) {
+      ingestStats.badFormat++;  // Previous line 1 never got its line 2
+    }
+    if (!haveName) {
+      pendingRecord.name[0] = '\0';  // 2LE input: no name line
+    }
+    copyLine(pendingRecord.line1, line);
+    haveLine1 = true;
+    return;
+  }
+
+  if (len == TLE_LINE_LENGTH && line[0] == '2' && line[1] == ' ') {
+    if (!haveLine1) {
+      ingestStats.badFormat++;
+      haveName = false;
+      return;
+    }
+    copyLine(pendingRecord.line2, line);
+    commitEntry();
+    return;
+  }
+
+  // Anything else is a name line ("0 " prefix in some 3LE exports)
+  if (haveLine1) {
+    ingestStats.badFormat++;
+    haveLine1 = false;
+  }
+  if (len >= 2 && line[0] == '0' && line[1] == ' ') {
+    line += 2;
+    len -= 2;
+  }
+  while (len > 0 && *line == ' ') {
+    line++;
+    len--;
+  }
+  len = min(len, (uint8_t)(sizeof(pendingRecord.name) - 1));
+  memcpy(pendingRecord.name, line, len);
+  pendingRecord.name[len] = '\0';
+  haveName = true;
+}
+
+static void finishLine() {
+  while (lineLen > 0 && (lineBuf[lineLen - 1] == ' ' || lineBuf[lineLen - 1] == '\r')) {
+    lineLen--;
+  }
+
+  if (lineTooLong) {
+    ingestStats.lines++;
+    ingestStats.badFormat++;
+    haveLine1 = false;
+    haveName = false;
+  } else {
+    lineBuf[lineLen] = '\0';
+    processLine(lineBuf, lineLen);
+  }
+
+  lineLen = 0;
+  lineTooLong = false;
+}
+
+static void makeNameKey(char* key, const char* name, size_t len) {
+  memset(key, 0, TLE_NAME_KEY_LENGTH);
+  for (size_t i = 0; i < len && i < TLE_NAME_KEY_LENGTH && name[i]; i++) {
+    key[i] = toupper((unsigned char)name[i]);
+  }
+}
+
+static int compareBuildSlots(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return x < y ? -1 : x > y;
+}
+
+static int compareNameKeys(const void* a, const void* b) {
+  const CatalogNameKey* x = (const CatalogNameKey*)a;
+  const CatalogNameKey* y = (const CatalogNameKey*)b;
+  int c = memcmp(x->key, y->key, TLE_NAME_KEY_LENGTH);
+  return c != 0 ? c : (int)x->record - (int)y->record;
+}
+
+static void closeCatalog() {
+  if (catalogFile) {
+    catalogFile.close();
+  }
+  catalogCount = 0;
+  indexLoaded = false;
+}
+
+static bool writeTable(File& file, const void* table, size_t bytes) {
+  uint32_t crc = calculateCrc32(table, bytes);
+  return file.write((const uint8_t*)table, bytes) == bytes &&
+         file.write((const uint8_t*)&crc, 4) == 4;
+}
+
+static bool readTable(File& file, void* table, size_t bytes) {
+  uint32_t crc;
+  return file.read((uint8_t*)table, bytes) == bytes &&
+         file.read((uint8_t*)&crc, 4) == 4 &&
+         crc == calculateCrc32(table, bytes);
+}
+
+// Read one record of an older catalog and derive the fields it lacks
+static bool readOldRecord(File& old, uint16_t version, TleRecord* record) {
+  memset(record, 0, sizeof(TleRecord));
+  if (version == 1) {
+    TleRecordV1 v1;
+    if (old.read((uint8_t*)&v1, sizeof(v1)) != sizeof(v1)) return false;
+    record->noradId = v1.noradId;
+    memcpy(record->name, v1.name, sizeof(record->name));
+    memcpy(record->line1, v1.line1, sizeof(record->line1));
+    memcpy(record->line2, v1.line2, sizeof(record->line2));
+  } else {
+    TleRecordV2 v2;
+    if (old.read((uint8_t*)&v2, sizeof(v2)) != sizeof(v2)) return false;
+    record->noradId = v2.noradId;
+    memcpy(record->name, v2.name, sizeof(record->name));
+    memcpy(record->line1, v2.line1, sizeof(record->line1));
+    memcpy(record->line2, v2.line2, sizeof(record->line2));
+  }
+  record->epoch = parseEpoch(record->line1);
+  return true;
+}
+
+static bool isBuilding() {
+  return buildPhase != BUILD_IDLE && buildPhase != BUILD_DONE && buildPhase != BUILD_FAILED;
+}
+
+static void finishIngestStats(uint32_t count) {
+  ingestStats.entries = count;
+  ingestStats.elapsedMs = millis() - ingestStart;
+  ingestStats.entriesPerSec = ingestStats.elapsedMs > 0 ?
+      count * 1000.0f / ingestStats.elapsedMs : 0.0f;
+  lastStats = ingestStats;
+  haveLastStats = true;
+}
+
+// Put the new catalog in place and open it, or give up on the build. The
+// generation only moves when a new catalog was committed.
+static void finishBuild(bool ok) {
+  if (buildIn) buildIn.close();
+  if (buildOut) buildOut.close();
+  LittleFS.remove(TLE_CATALOG_TEMP_FILE);
+
+  ok = ok && LittleFS.rename(TLE_CATALOG_BUILD_FILE, TLE_CATALOG_FILE);
+  if (ok) {
+    catalogFile = LittleFS.open(TLE_CATALOG_FILE, "r");
+    catalogCount = buildCount;
+    catalogGeneration++;
+    buildPhase = BUILD_DONE;
+    if (convertVersion) {
+      Serial.printf("Catalog: converted %lu entries from format %u\n", catalogCount, convertVersion);
+    }
+  } else {
+    LittleFS.remove(TLE_CATALOG_BUILD_FILE);
+    catalogCount = 0;
+    buildPhase = BUILD_FAILED;
+    Serial.println("Catalog: build failed");
+  }
+  indexLoaded = true;
+
+  if (buildFromIngest) {
+    finishIngestStats(catalogCount);
+  }
+}
+
+// Start sorting the upload by NORAD ID into the live catalog, keeping the
+// last entry for each ID. The old catalog is removed first so only two
+// copies ever share the flash; a failed build leaves the catalog empty.
+static void startBuild() {
+  closeCatalog();
+  LittleFS.remove(TLE_CATALOG_FILE);
+
+  buildIn = LittleFS.open(TLE_CATALOG_TEMP_FILE, "r");
+  if (!buildIn) {
+    finishBuild(false);
+    return;
+  }
+  buildTotal = min((uint32_t)(buildIn.size() / sizeof(TleRecord)), (uint32_t)TLE_CATALOG_MAX_ENTRIES);
+  buildPos = 0;
+  buildCount = 0;
+  buildPhase = BUILD_SCAN;
+}
+
+// Rewrite the records of an older catalog (version 1: unsorted, no epoch;
+// version 2: no parsed elements) as an upload, then build it like one.
+// 'old' is positioned at the first record.
+static void startConversion(File& old, uint16_t version, uint32_t count) {
+  buildOut = LittleFS.open(TLE_CATALOG_TEMP_FILE, "w");
+  if (!buildOut) {
+    old.close();
+    return;
+  }
+  buildIn = old;
+  buildTotal = min(count, (uint32_t)TLE_CATALOG_MAX_ENTRIES);
+  buildPos = 0;
+  buildCount = 0;
+  buildFromIngest = false;
+  convertVersion = version;
+  buildPhase = BUILD_CONVERT;
+}
+
+static void stepConvert() {
+  TleRecord record;
+  for (int n = 0; n < CATALOG_BUILD_RECORDS_PER_STEP && buildPos < buildTotal; n++, buildPos++) {
+    if (!readOldRecord(buildIn, convertVersion, &record)) {
+      finishBuild(false);
+      return;
+    }
+    if (parseElements(record.line1, record.line2, &record.elements) &&
+        buildOut.write((const uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+      finishBuild(false);
+      return;
+    }
+  }
+
+  if (buildPos == buildTotal) {
+    buildIn.close();
+    buildOut.close();
+    startBuild();
+  }
+}
+
+// Pass 1: ID/position slots and name keys, in arrival order
+static void stepScan() {
+  TleRecord record;
+  for (int n = 0; n < CATALOG_BUILD_RECORDS_PER_STEP && buildPos < buildTotal; n++, buildPos++) {
+    if (buildIn.read((uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+      buildTotal = buildPos;
+      break;
+    }
+    indexIds[buildPos] = (min(record.noradId, (uint32_t)TLE_MAX_NORAD_ID) << BUILD_POSITION_BITS) | buildPos;
+    makeNameKey(nameIndex[buildPos].key, record.name, sizeof(record.name));
+    nameIndex[buildPos].record = 0xFFFF;  // Superseded unless assigned below
+  }
+
+  if (buildPos == buildTotal) {
+    buildPhase = BUILD_SORT;
+  }
+}
+
+// Sort by ID, keep the last arrival of each, and point the surviving name
+// keys at their final record index; then start the new file
+static void stepSort() {
+  qsort(indexIds, buildTotal, sizeof(uint32_t), compareBuildSlots);
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < buildTotal; i++) {
+    if (i + 1 < buildTotal && (indexIds[i] >> BUILD_POSITION_BITS) == (indexIds[i + 1] >> BUILD_POSITION_BITS)) {
+      continue;
+    }
+    indexIds[count] = indexIds[i];
+    nameIndex[indexIds[count] & BUILD_POSITION_MASK].record = count;
+    count++;
+  }
+  buildCount = count;
+  if (buildFromIngest) {
+    ingestStats.duplicates = buildTotal - count;
+  }
+
+  uint32_t names = 0;
+  for (uint32_t i = 0; i < buildTotal; i++) {
+    if (nameIndex[i].record != 0xFFFF) {
+      nameIndex[names++] = nameIndex[i];
+    }
+  }
+  qsort(nameIndex, count, sizeof(CatalogNameKey), compareNameKeys);
+
+  // Pass 2 writes the header, records in ID order, then both tables
+  buildOut = LittleFS.open(TLE_CATALOG_BUILD_FILE, "w");
+  if (!buildOut) {
+    finishBuild(false);
+    return;
+  }
+
+  CatalogHeader header;
+  header.magic = TLE_CATALOG_MAGIC;
+  header.version = TLE_CATALOG_VERSION;
+  header.recordSize = sizeof(TleRecord);
+  header.count = count;
+  header.idTableOffset = sizeof(CatalogHeader) + count * sizeof(TleRecord);
+  header.nameIndexOffset = header.idTableOffset + count * sizeof(uint32_t) + 4;
+  header.crc = calculateCrc32(&header, offsetof(CatalogHeader, crc));
+  if (buildOut.write((const uint8_t*)&header, sizeof(header)) != sizeof(header)) {
+    finishBuild(false);
+    return;
+  }
+
+  buildPos = 0;
+  buildPhase = BUILD_COPY;
+}
+
+static void stepCopy() {
+  TleRecord record;
+  for (int n = 0; n < CATALOG_BUILD_RECORDS_PER_STEP && buildPos < buildCount; n++, buildPos++) {
+    bool ok = buildIn.seek((indexIds[buildPos] & BUILD_POSITION_MASK) * sizeof(TleRecord)) &&
+              buildIn.read((uint8_t*)&record, sizeof(record)) == sizeof(record) &&
+              buildOut.write((const uint8_t*)&record, sizeof(record)) == sizeof(record);
+    if (!ok) {
+      finishBuild(false);
+      return;
+    }
+    indexIds[buildPos] >>= BUILD_POSITION_BITS;
+  }
+
+  if (buildPos == buildCount) {
+    buildPhase = BUILD_TABLES;
+  }
+}
+
+static void stepTables() {
+  buildIn.close();
+  bool ok = writeTable(buildOut, indexIds, buildCount * sizeof(uint32_t)) &&
+            writeTable(buildOut, nameIndex, buildCount * sizeof(CatalogNameKey));
+  buildOut.close();
+  finishBuild(ok);
+}
+
+// Open the live catalog and read its index into RAM (first use)
+static bool loadCatalogIndex() {
+  // The build uses the index tables as scratch
+  if (isBuilding()) {
+    return false;
+  }
+  if (indexLoaded) {
+    return catalogCount > 0;
+  }
+  indexLoaded = true;
+  catalogCount = 0;
+
+  unsigned long start = millis();
+  File file = LittleFS.open(TLE_CATALOG_FILE, "r");
+  if (!file) {
+    return false;
+  }
+
+  CatalogHeader header;
+  bool headerOk = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                  header.magic == TLE_CATALOG_MAGIC &&
+                  header.crc == calculateCrc32(&header, offsetof(CatalogHeader, crc));
+  bool convertible = !ingestActive &&
+      (headerOk ? header.version == 2 && header.recordSize == sizeof(TleRecordV2)
+                : file.size() % sizeof(TleRecordV1) == 0);
+  if (convertible) {
+    file.seek(headerOk ? sizeof(CatalogHeader) : 0);
+    startConversion(file, headerOk ? 2 : 1, headerOk ? header.count : file.size() / sizeof(TleRecordV1));
+    return false;
+  }
+  if (!headerOk) {
+    file.close();
+    Serial.println("Catalog: unrecognised file, ignored");
+    return false;
+  }
+
+  bool ok = header.version == TLE_CATALOG_VERSION &&
+            header.recordSize == sizeof(TleRecord) &&
+            header.count <= TLE_CATALOG_MAX_ENTRIES &&
+            file.seek(header.idTableOffset) &&
+            readTable(file, indexIds, header.count * sizeof(uint32_t)) &&
+            file.seek(header.nameIndexOffset) &&
+            readTable(file, nameIndex, header.count * sizeof(CatalogNameKey));
+  if (!ok) {
+    file.close();
+    Serial.println("Catalog: index damaged or from another version, ignored");
+    return false;
+  }
+
+  catalogFile = file;
+  catalogCount = header.count;
+  indexLoadMs = millis() - start;
+  return true;
+}
+
+static bool readRecordAt(uint32_t index, TleRecord* record) {
+  return catalogFile.seek(sizeof(CatalogHeader) + index * sizeof(TleRecord)) &&
+         catalogFile.read((uint8_t*)record, sizeof(TleRecord)) == sizeof(TleRecord);
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
+bool validateTle(const char* line1, const char* line2, char* error, size_t errorSize) {
+  const char* reason;
+  bool ok = checkTle(line1, line2, &reason) == TLE_OK;
+  if (!ok && error && errorSize > 0) {
+    snprintf(error, errorSize, "Invalid TLE: %s", reason);
+  }
+  return ok;
+}
+
+uint32_t tleCatalogNumber(const char* line1) {
+  return strlen(line1) >= 7 ? parseCatalogNumber(line1 + 2) : 0;
+}
+
+uint32_t tleEpoch(const char* line1) {
+  if (strlen(line1) < 32 || !allDigits(line1 + 18, 5) || line1[23] != '.' ||
+      !allDigits(line1 + 24, 8)) {
+    return 0;
+  }
+  return parseEpoch(line1);
+}
+
+bool parseTleElements(const char* line1, const char* line2, TleElements* elements) {
+  const char* reason;
+  return checkTle(line1, line2, &reason) == TLE_OK && parseElements(line1, line2, elements);
+}
+
+bool beginCatalogIngest() {
+  if (ingestActive || isBuilding()) {
+    return false;
+  }
+
+  if (!LittleFS.begin()) {
+    Serial.println("Catalog: LittleFS not available");
+    return false;
+  }
+
+  ingestFile = LittleFS.open(TLE_CATALOG_TEMP_FILE, "w");
+  if (!ingestFile) {
+    Serial.println("Catalog: cannot create " TLE_CATALOG_TEMP_FILE);
+    return false;
+  }
+
+  memset(&ingestStats, 0, sizeof(ingestStats));
+  lineLen = 0;
+  lineTooLong = false;
+  haveName = false;
+  haveLine1 = false;
+  ingestStart = millis();
+  ingestActive = true;
+  return true;
+}
+
+void feedCatalogIngest(const char* data, size_t len) {
+  if (!ingestActive) {
+    return;
+  }
+
+  ingestStats.bytes += len;
+  for (size_t i = 0; i < len; i++) {
+    char c = data[i];
+    if (c == '\n') {
+      finishLine();
+    } else if (lineLen < sizeof(lineBuf) - 1) {
+      lineBuf[lineLen++] = c;
+    } else {
+      lineTooLong = true;
+    }
+  }
+}
+
+bool endCatalogIngest(CatalogIngestStats* stats) {
+  if (!ingestActive) {
+    return false;
+  }
+
+  // Last line may lack a newline
+  if (lineLen > 0 || lineTooLong) {
+    finishLine();
+  }
+  if (haveLine1) {
+    ingestStats.badFormat++;
+  }
+
+  ingestFile.close();
+  ingestActive = false;
+
+  // Keep the old catalog if nothing usable arrived
+  if (ingestStats.entries > 0) {
+    buildFromIngest = true;
+    convertVersion = 0;
+    startBuild();
+  } else {
+    LittleFS.remove(TLE_CATALOG_TEMP_FILE);
+    finishIngestStats(0);
+  }
+
+  if (stats) {
+    *stats = ingestStats;
+  }
+  return isBuilding();
+}
+
+void abortCatalogIngest() {
+  if (!ingestActive) {
+    return;
+  }
+  ingestFile.close();
+  ingestActive = false;
+  LittleFS.remove(TLE_CATALOG_TEMP_FILE);
+}
+
+bool isCatalogIngestActive() {
+  return ingestActive;
+}
+
+CatalogBuildState stepCatalogBuild() {
+  switch (buildPhase) {
+    case BUILD_CONVERT: stepConvert(); break;
+    case BUILD_SCAN: stepScan(); break;
+    case BUILD_SORT: stepSort(); break;
+    case BUILD_COPY: stepCopy(); break;
+    case BUILD_TABLES: stepTables(); break;
+    default: break;
+  }
+
+  switch (buildPhase) {
+    case BUILD_IDLE: return CATALOG_BUILD_IDLE;
+    case BUILD_DONE: return CATALOG_BUILD_DONE;
+    case BUILD_FAILED: return CATALOG_BUILD_FAILED;
+    default: return CATALOG_BUILD_RUNNING;
+  }
+}
+
+bool isCatalogBuildActive() {
+  return isBuilding();
+}
+
+const char* getCatalogBuildMessage() {
+  switch (buildPhase) {
+    case BUILD_CONVERT: return "Converting old catalog";
+    case BUILD_SCAN: return "Reading upload";
+    case BUILD_SORT: return "Sorting";
+    case BUILD_COPY: return "Writing records";
+    case BUILD_TABLES: return "Writing index";
+    case BUILD_DONE: return "Catalog stored";
+    case BUILD_FAILED: return "Catalog build failed";
+    default: return "Idle";
+  }
+}
+
+bool getLastIngestStats(CatalogIngestStats* stats) {
+  if (haveLastStats) {
+    *stats = lastStats;
+  }
+  return haveLastStats;
+}
+
+uint32_t getCatalogCount() {
+  loadCatalogIndex();
+  return catalogCount;
+}
+
+bool readCatalogRecord(uint32_t index, TleRecord* record) {
+  if (!loadCatalogIndex() || index >= catalogCount) {
+    return false;
+  }
+  return readRecordAt(index, record);
+}
+
+bool findCatalogRecord(uint32_t noradId, TleRecord* record) {
+  if (!loadCatalogIndex()) {
+    return false;
+  }
+
+  uint32_t start = micros();
+  uint32_t lo = 0;
+  uint32_t hi = catalogCount;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (indexIds[mid] < noradId) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  bool found = lo < catalogCount && indexIds[lo] == noradId && readRecordAt(lo, record);
+  lastLookupUs = micros() - start;
+  return found;
+}
+
+uint32_t findCatalogByName(const char* prefix, uint32_t* indices, uint32_t maxResults) {
+  if (!loadCatalogIndex()) {
+    return 0;
+  }
+
+  size_t len = strlen(prefix);
+  size_t keyLen = min(len, (size_t)TLE_NAME_KEY_LENGTH);
+  char key[TLE_NAME_KEY_LENGTH];
+  makeNameKey(key, prefix, len);
+
+  uint32_t lo = 0;
+  uint32_t hi = catalogCount;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (memcmp(nameIndex[mid].key, key, keyLen) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  // Keys hold only the first TLE_NAME_KEY_LENGTH characters; a longer
+  // prefix is checked against the record
+  uint32_t found = 0;
+  TleRecord record;
+  for (uint32_t i = lo; i < catalogCount && found < maxResults; i++) {
+    if (memcmp(nameIndex[i].key, key, keyLen) != 0) {
+      break;
+    }
+    if (len > TLE_NAME_KEY_LENGTH &&
+        (!readRecordAt(nameIndex[i].record, &record) || strncasecmp(record.name, prefix, len) != 0)) {
+      continue;
+    }
+    indices[found++] = nameIndex[i].record;
+  }
+  return found;
+}
+
+uint32_t getCatalogGeneration() {
+  return catalogGeneration;
+}
+
+void printCatalogStatus() {
+  Serial.println(F("\n=== TLE CATALOG ==="));
+  Serial.printf("Entries: %lu (max %d, %u bytes each)\n",
+                (unsigned long)getCatalogCount(), TLE_CATALOG_MAX_ENTRIES, (unsigned)sizeof(TleRecord));
+  Serial.printf("Index: %u bytes RAM, loaded in %lu ms, last ID lookup %lu us\n",
+                (unsigned)(sizeof(indexIds) + sizeof(nameIndex)), indexLoadMs, lastLookupUs);
+  Serial.printf("Ingest: %s\n", ingestActive ? "IN PROGRESS" : "idle");
+  if (isBuilding()) {
+    Serial.printf("Build: %s (%lu of %lu records)\n", getCatalogBuildMessage(),
+                  buildPos, buildPhase == BUILD_COPY ? buildCount : buildTotal);
+  }
+
+  const CatalogIngestStats& s = ingestActive ? ingestStats : lastStats;
+  if (ingestActive || haveLastStats) {
+    Serial.printf("%s upload: %lu bytes, %lu lines\n", ingestActive ? "Current" : "Last",
+                  s.bytes, s.lines);
+    Serial.printf("  Entries: %lu stored, %lu bad checksum, %lu bad format, %lu dropped, %lu duplicate\n",
+                  s.entries, s.badChecksum, s.badFormat, s.dropped, s.duplicates);
+    if (!ingestActive) {
+      Serial.printf("  Time: %lu ms (%.1f entries/s)\n", s.elapsedMs, s.entriesPerSec);
+    }
+  }
+  Serial.println();
+}
@@ -3,6 +3,8 @@
 // ============================================================================
 
 #include "tracking_logic.h"
+#include "metrics.h"
+#include "sgp4_cache.h"
 
 // External references to shared data (defined in shared_data.cpp)
 extern MotorPosition motorPos;
@@ -22,6 +24,24 @@ static double lastAz = 0.0;
 static double lastEl = 0.0;
 static unsigned long lastPredictionTime = 0;
 
+// Next-AOS prediction (refreshed while the satellite is below the horizon)
+#define AOS_PREDICTION_MS 60000
+#define AOS_PREDICTION_ITERATIONS 20
+static double aosAzimuth = 0.0;
+static bool aosValid = false;
+static unsigned long lastAOSPrediction = 0;
+
+// Publish satellite position for the pose snapshot
+static void publishSatellite(bool valid, double az, double el) {
+  SatellitePose pose;
+  pose.azimuth = (float)az;
+  pose.elevation = (float)el;
+  pose.aosAzimuth = (float)aosAzimuth;
+  pose.valid = valid;
+  pose.aosValid = valid && aosValid;
+  publishSatellitePose(pose);
+}
+
 double dateToJulian(int year, int month, int day, int hour, int minute, int second) {
   int a = (14 - month) / 12;
   int y = year + 4800 - a;
@@ -40,6 +60,8 @@ void initTracking() {
   lastAz = 0.0;
   lastEl = 0.0;
   lastPredictionTime = 0;
+  aosValid = false;
+  lastAOSPrediction = 0;
 }
 
 void updateTracking() {
@@ -57,10 +79,20 @@ void updateTracking() {
     }
     
     // Initialize satellite with current position
+    if (!initSatellite(&sat, satelliteName, tleLine1, tleLine2)) {
+      Serial.println("Core 1: TLE rejected by SGP4, not tracking");
+      satInitialized = false;
+      trackerState.tleValid = false;
+      trackerState.tracking = false;
+      __dmb();
+      tleUpdatePending = false;
+      return;
+    }
     sat.site(trackerState.latitude, trackerState.longitude, trackerState.altitude);
-    sat.init(satelliteName, tleLine1, tleLine2);
     
     satInitialized = true;
+    aosValid = false;
+    lastAOSPrediction = 0;
     trackerState.tleValid = true;
     trackerState.tracking = true;
     
@@ -95,6 +127,7 @@ void updateTracking() {
     
     // Find current satellite position
     sat.findsat(jdNow);
+    metricInc(METRIC_SGP4_EVALUATIONS);
     double azNow = sat.satAz;
     double elNow = sat.satEl;
     
@@ -142,8 +175,24 @@ void updateTracking() {
       targetPos.elevation = 0.0;
       // Could optionally stop tracking when satellite sets
       // trackerState.tracking = false;
+      
+      // Predict where the next pass rises (nextpass() moves the propagator,
+      // so this runs after azNow/elNow have been taken)
+      if (!aosValid || now - lastAOSPrediction >= AOS_PREDICTION_MS) {
+        passinfo pass;
+        sat.initpredpoint(jdNow, 0.0);
+        aosValid = sat.nextpass(&pass, AOS_PREDICTION_ITERATIONS);
+        if (aosValid) {
+          aosAzimuth = pass.azstart;
+        }
+        lastAOSPrediction = now;
+      }
+    } else {
+      aosValid = false;
     }
     
+    publishSatellite(true, azNow, elNow);
+    
     // Debug output every 5 seconds
     static unsigned long lastDebug = 0;
     if (now - lastDebug >= 5000) {
@@ -155,5 +204,8 @@ void updateTracking() {
     // GPS was lost during tracking
     Serial.println("Core 1: GPS lost, stopping tracking");
     trackerState.tracking = false;
+    publishSatellite(false, 0.0, 0.0);
+  } else if (!trackerState.tracking) {
+    publishSatellite(false, 0.0, 0.0);
   }
 }
\ No newline at end of file
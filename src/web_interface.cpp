@@ -4,6 +4,8 @@
 
 #include "web_interface.h"
 #include <LEAmDNS.h>
+#include <LittleFS.h>
+#include "crc32.h"
 
 // External references to shared data (defined in shared_data.cpp)
 extern MotorPosition motorPos;
@@ -17,181 +19,434 @@ extern char wifiSSID[32];
 extern char wifiPassword[64];
 extern bool wifiConfigured;
 
-WebServer server(80);
-
 // Authentication credentials (TODO: Move to EEPROM/config)
 const char* www_username = "admin";
 const char* www_password = "changeme";  // Change this!
 
-// HTML sanitization to prevent XSS
-String sanitizeHTML(const String& input) {
-  String output = input;
-  output.replace("&", "&amp;");
-  output.replace("<", "&lt;");
-  output.replace(">", "&gt;");
-  output.replace("\"", "&quot;");
-  output.replace("'", "&#39;");
-  return output;
-}
-
-void handleRoot() {
-  // Require authentication
-  if (!server.authenticate(www_username, www_password)) {
-    return server.requestAuthentication();
-  }
-  
-  // Sanitize user-provided data
-  String safeSatName = sanitizeHTML(String(satelliteName));
-  String safeTLE1 = sanitizeHTML(String(tleLine1));
-  String safeTLE2 = sanitizeHTML(String(tleLine2));
-  
-  String html = "<!DOCTYPE html><html><head><title>Sat Tracker</title>";
-  html += "<meta charset='UTF-8'>";
-  html += "<style>body{font-family:Arial;margin:20px;background:#f0f0f0;}";
-  html += "table{border-collapse:collapse;background:white;}td,th{border:1px solid #ddd;padding:8px;}";
-  html += "th{background:#4CAF50;color:white;}";
-  html += "input[type=text]{width:500px;max-width:100%;padding:5px;}";
-  html += "input[type=submit]{background:#4CAF50;color:white;padding:10px 20px;border:none;cursor:pointer;margin:5px;}";
-  html += "input[type=submit]:hover{background:#45a049;}";
-  html += ".status-good{color:green;font-weight:bold;}";
-  html += ".status-bad{color:red;font-weight:bold;}";
-  html += "h1,h2{color:#333;}</style>";
-  
-  // JavaScript for AJAX updates
-  html += "<script>";
-  html += "function updateStatus(){";
-  html += "  fetch('/status').then(r=>r.json()).then(d=>{";
-  html += "    document.getElementById('gpsValid').textContent=d.gpsValid?'Yes':'No';";
-  html += "    document.getElementById('gpsValid').className=d.gpsValid?'status-good':'status-bad';";
-  html += "    document.getElementById('location').textContent=d.lat.toFixed(6)+', '+d.lon.toFixed(6);";
-  html += "    document.getElementById('altitude').textContent=d.alt.toFixed(1)+' m';";
-  html += "    document.getElementById('time').textContent=d.time;";
-  html += "    document.getElementById('tleLoaded').textContent=d.tleValid?'Yes':'No';";
-  html += "    document.getElementById('tleLoaded').className=d.tleValid?'status-good':'status-bad';";
-  html += "    document.getElementById('tracking').textContent=d.tracking?'Active':'Idle';";
-  html += "    document.getElementById('tracking').className=d.tracking?'status-good':'status-bad';";
-  html += "    document.getElementById('currentAz').textContent=d.curAz.toFixed(2)+'°';";
-  html += "    document.getElementById('currentEl').textContent=d.curEl.toFixed(2)+'°';";
-  html += "    document.getElementById('targetAz').textContent=d.tgtAz.toFixed(2)+'°';";
-  html += "    document.getElementById('targetEl').textContent=d.tgtEl.toFixed(2)+'°';";
-  html += "  }).catch(e=>console.log('Update failed',e));";
-  html += "}";
-  html += "setInterval(updateStatus,1000);";
-  html += "window.onload=updateStatus;";
-  html += "</script>";
-  
-  html += "</head><body>";
-  html += "<h1>Satellite Tracker Control</h1>";
-  
-  html += "<h2>Status</h2><table>";
-  html += "<tr><td>GPS Valid</td><td id='gpsValid'>...</td></tr>";
-  html += "<tr><td>Location</td><td id='location'>...</td></tr>";
-  html += "<tr><td>Altitude</td><td id='altitude'>...</td></tr>";
-  html += "<tr><td>Time (UTC)</td><td id='time'>...</td></tr>";
-  html += "<tr><td>TLE Loaded</td><td id='tleLoaded'>...</td></tr>";
-  html += "<tr><td>Tracking</td><td id='tracking'>...</td></tr>";
-  html += "</table>";
-  
-  html += "<h2>Position</h2><table>";
-  html += "<tr><td>Current Azimuth</td><td id='currentAz'>...</td></tr>";
-  html += "<tr><td>Current Elevation</td><td id='currentEl'>...</td></tr>";
-  html += "<tr><td>Target Azimuth</td><td id='targetAz'>...</td></tr>";
-  html += "<tr><td>Target Elevation</td><td id='targetEl'>...</td></tr>";
-  html += "</table>";
-  
-  html += "<h2>Commands</h2>";
-  html += "<form action='/tle' method='POST'>";
-  html += "Satellite Name: <input type='text' name='name' value='" + safeSatName + "' maxlength='24'><br><br>";
-  html += "TLE Line 1: <input type='text' name='line1' value='" + safeTLE1 + "' maxlength='69'><br><br>";
-  html += "TLE Line 2: <input type='text' name='line2' value='" + safeTLE2 + "' maxlength='69'><br><br>";
-  html += "<input type='submit' value='Update TLE and Track'></form><br>";
-  
-  html += "<form action='/home' method='POST'>";
-  html += "<input type='submit' value='Home Axes'></form><br>";
-  
-  html += "<form action='/stop' method='POST'>";
-  html += "<input type='submit' value='Stop Tracking'></form>";
-  
-  html += "</body></html>";
-  
-  server.send(200, "text/html", html);
-}
-
-void handleStatus() {
-  // Require authentication
-  if (!server.authenticate(www_username, www_password)) {
-    return server.requestAuthentication();
+// ============================================================================
+// ASYNC JOBS
+// ============================================================================
+// Anything that takes longer than one poll runs as a job: the request
+// returns 202 with a status URL, and updateWebJobs() steps the job from
+// the main loop.
+
+#define WEB_MAX_JOBS 4
+
+typedef enum {
+  JOB_PENDING = 0,
+  JOB_RUNNING,
+  JOB_DONE,
+  JOB_FAILED
+} WebJobState;
+
+struct WebJob;
+typedef WebJobState (*WebJobStep)(WebJob* job);
+
+struct WebJob {
+  uint16_t id;             // 0 = slot unused
+  const char* type;
+  WebJobStep step;
+  WebJobState state;
+  unsigned long startMs;
+  unsigned long endMs;
+  const char* message;
+};
+
+static WebJob webJobs[WEB_MAX_JOBS];
+static uint16_t nextJobId = 1;
+
+static const char* jobStateName(WebJobState state) {
+  switch (state) {
+    case JOB_PENDING: return "pending";
+    case JOB_RUNNING: return "running";
+    case JOB_DONE: return "done";
+    case JOB_FAILED: return "failed";
+    default: return "unknown";
+  }
+}
+
+static bool isJobActive(const WebJob& job) {
+  return job.id && (job.state == JOB_PENDING || job.state == JOB_RUNNING);
+}
+
+// Queue a job; reuses the oldest finished slot. Returns nullptr if all
+// slots hold active jobs.
+static WebJob* startWebJob(const char* type, WebJobStep step) {
+  WebJob* slot = nullptr;
+  for (int i = 0; i < WEB_MAX_JOBS; i++) {
+    WebJob& job = webJobs[i];
+    if (isJobActive(job)) {
+      continue;
+    }
+    if (!slot || job.id < slot->id) {
+      slot = &job;
+    }
+  }
+  if (!slot) {
+    return nullptr;
+  }
+  
+  slot->id = nextJobId++;
+  if (nextJobId == 0) nextJobId = 1;
+  slot->type = type;
+  slot->step = step;
+  slot->state = JOB_PENDING;
+  slot->startMs = millis();
+  slot->endMs = 0;
+  slot->message = "Queued";
+  return slot;
+}
+
+static WebJob* findActiveJob(const char* type) {
+  for (int i = 0; i < WEB_MAX_JOBS; i++) {
+    if (isJobActive(webJobs[i]) && strcmp(webJobs[i].type, type) == 0) {
+      return &webJobs[i];
+    }
+  }
+  return nullptr;
+}
+
+static void updateWebJobs() {
+  for (int i = 0; i < WEB_MAX_JOBS; i++) {
+    WebJob& job = webJobs[i];
+    if (!isJobActive(job)) {
+      continue;
+    }
+    job.state = job.step(&job);
+    if (!isJobActive(job)) {
+      job.endMs = millis();
+    }
+  }
+}
+
+// Homing job: drives the motor control homing state machine
+static WebJobState homeJobStep(WebJob* job) {
+  if (job->state == JOB_PENDING) {
+    trackerState.tracking = false;
+    targetPos.elevation = 0.0;
+    targetPos.azimuth = 0.0;
+    if (!beginHoming()) {
+      job->message = "Could not start homing";
+      return JOB_FAILED;
+    }
+    job->message = "Homing elevation";
+    return JOB_RUNNING;
   }
   
+  switch (updateHoming()) {
+    case HOMING_ELEVATION: job->message = "Homing elevation"; return JOB_RUNNING;
+    case HOMING_AZIMUTH: job->message = "Homing azimuth"; return JOB_RUNNING;
+    case HOMING_SETTLING: job->message = "Settling"; return JOB_RUNNING;
+    case HOMING_DONE: job->message = "Homing complete"; return JOB_DONE;
+    default: job->message = "Homing failed"; return JOB_FAILED;
+  }
+}
+
+// Job description as JSON
+static void writeJob(JsonWriter* w, const WebJob& job) {
+  char statusUrl[20];
+  snprintf(statusUrl, sizeof(statusUrl), "/jobs?id=%u", job.id);
+  unsigned long elapsed = (job.endMs ? job.endMs : millis()) - job.startMs;
+  
+  jsonObjectBegin(w);
+  jsonUInt(w, "id", job.id);
+  jsonString(w, "type", job.type);
+  jsonString(w, "state", jobStateName(job.state));
+  jsonString(w, "message", job.message);
+  jsonUInt(w, "elapsedMs", elapsed);
+  jsonString(w, "status", statusUrl);
+  jsonObjectEnd(w);
+}
+
+// Serialize straight into the connection's send buffer
+static void beginJsonResponse(HttpConnection* conn, JsonWriter* w) {
+  size_t cap;
+  char* buf = httpBodyBuffer(conn, &cap);
+  jsonBegin(w, buf, cap);
+}
+
+static void sendJsonResponse(HttpConnection* conn, int status, const char* extraHeaders,
+                             const JsonWriter* w) {
+  if (w->overflow) {
+    httpSend(conn, 500, "text/plain", "Response too large");
+    return;
+  }
+  httpSendBody(conn, status, "application/json", extraHeaders, w->len);
+}
+
+static void sendJob(HttpConnection* conn, int status, const char* extraHeaders, const WebJob& job) {
+  JsonWriter w;
+  beginJsonResponse(conn, &w);
+  writeJob(&w, job);
+  sendJsonResponse(conn, status, extraHeaders, &w);
+}
+
+// Answer 202 Accepted with the job's status URL
+static void sendJobAccepted(HttpConnection* conn, const WebJob& job) {
+  char location[40];
+  snprintf(location, sizeof(location), "Location: /jobs?id=%u\r\n", job.id);
+  sendJob(conn, 202, location, job);
+}
+
+// ============================================================================
+// STATUS AND TELEMETRY
+// ============================================================================
+// Live telemetry goes out as Server-Sent Events on /events. Each tick the
+// frame is serialized once into a shared buffer and fanned out to every
+// open stream, so cost does not grow with the number of viewers.
+//   event: pose    - antenna pose and pointing error, at telemetryHz
+//   event: status  - the /status document, every TELEMETRY_STATUS_MS
+
+static uint8_t telemetryHz = TELEMETRY_DEFAULT_HZ;
+static unsigned long lastPoseEvent = 0;
+static unsigned long lastStatusEvent = 0;
+static char eventFrame[448];
+
+#define EVENT_FRAME_END "\n\n"
+
+// Full status document (also served by GET /status)
+void writeStatusJson(JsonWriter* w) {
   float currentEl = motorPos.elevation * DEGREES_PER_PULSE;
   float currentAz = motorPos.azimuth * DEGREES_PER_PULSE;
   while (currentAz < 0) currentAz += 360.0;
   while (currentAz >= 360) currentAz -= 360.0;
   
-  // Build JSON response
-  String json = "{";
-  json += "\"gpsValid\":" + String(trackerState.gpsValid ? "true" : "false") + ",";
-  json += "\"lat\":" + String(trackerState.latitude, 6) + ",";
-  json += "\"lon\":" + String(trackerState.longitude, 6) + ",";
-  json += "\"alt\":" + String(trackerState.altitude, 1) + ",";
-  json += "\"time\":\"" + String(trackerState.gpsYear) + "-" + 
-          String(trackerState.gpsMonth) + "-" + String(trackerState.gpsDay) + " " +
-          String(trackerState.gpsHour) + ":" + String(trackerState.gpsMinute) + ":" + 
-          String(trackerState.gpsSecond) + "\",";
-  json += "\"tleValid\":" + String(trackerState.tleValid ? "true" : "false") + ",";
-  json += "\"tracking\":" + String(trackerState.tracking ? "true" : "false") + ",";
-  json += "\"curAz\":" + String(currentAz, 2) + ",";
-  json += "\"curEl\":" + String(currentEl, 2) + ",";
-  json += "\"tgtAz\":" + String(targetPos.azimuth, 2) + ",";
-  json += "\"tgtEl\":" + String(targetPos.elevation, 2);
-  json += "}";
-  
-  server.send(200, "application/json", json);
-}
-
-void handleTLE() {
-  // Require authentication
-  if (!server.authenticate(www_username, www_password)) {
-    return server.requestAuthentication();
-  }
-  
-  if (!server.hasArg("name") || !server.hasArg("line1") || !server.hasArg("line2")) {
-    server.send(400, "text/plain", "Missing parameters");
+  char time[32];
+  snprintf(time, sizeof(time), "%lu-%u-%u %u:%u:%u",
+           (unsigned long)trackerState.gpsYear, trackerState.gpsMonth, trackerState.gpsDay,
+           trackerState.gpsHour, trackerState.gpsMinute, trackerState.gpsSecond);
+  
+  jsonObjectBegin(w);
+  jsonBool(w, "gpsValid", trackerState.gpsValid);
+  jsonFixed(w, "lat", trackerState.latitude, 6);
+  jsonFixed(w, "lon", trackerState.longitude, 6);
+  jsonFixed(w, "alt", trackerState.altitude, 1);
+  jsonString(w, "time", time);
+  jsonBool(w, "tleValid", trackerState.tleValid);
+  jsonBool(w, "tracking", trackerState.tracking);
+  jsonFixed(w, "curAz", currentAz, 2);
+  jsonFixed(w, "curEl", currentEl, 2);
+  jsonFixed(w, "tgtAz", targetPos.azimuth, 2);
+  jsonFixed(w, "tgtEl", targetPos.elevation, 2);
+  jsonObjectEnd(w);
+}
+
+// Frame = "event: <name>\ndata: <json>\n\n", built in eventFrame
+static void broadcastEventFrame(JsonWriter* w) {
+  jsonRaw(w, EVENT_FRAME_END);
+  if (!w->overflow) {
+    httpBroadcastEvent(eventFrame, w->len);
+  }
+}
+
+static void sendStatusEvent() {
+  JsonWriter w;
+  jsonBegin(&w, eventFrame, sizeof(eventFrame));
+  jsonRaw(&w, "event: status\ndata: ");
+  writeStatusJson(&w);
+  broadcastEventFrame(&w);
+}
+
+static void sendPoseEvent() {
+  PoseSnapshot pose;
+  getPoseSnapshot(&pose);
+  
+  JsonWriter w;
+  jsonBegin(&w, eventFrame, sizeof(eventFrame));
+  jsonRaw(&w, "event: pose\ndata: ");
+  jsonObjectBegin(&w);
+  jsonUInt(&w, "t", millis());
+  jsonFixed(&w, "az", pose.antenna.azimuth, 2);
+  jsonFixed(&w, "el", pose.antenna.elevation, 2);
+  jsonFixed(&w, "eaz", pose.antenna.errorAz, 3);
+  jsonFixed(&w, "eel", pose.antenna.errorEl, 3);
+  jsonFixed(&w, "saz", pose.satellite.azimuth, 2);
+  jsonFixed(&w, "sel", pose.satellite.elevation, 2);
+  jsonUInt(&w, "sv", pose.satellite.valid ? 1 : 0);
+  jsonObjectEnd(&w);
+  broadcastEventFrame(&w);
+}
+
+static void updateTelemetry() {
+  if (httpEventStreamCount() == 0) {
+    return;  // Nobody listening - skip serialization entirely
+  }
+  
+  unsigned long now = millis();
+  
+  if (httpTakeNewEventStreams() > 0 || now - lastStatusEvent >= TELEMETRY_STATUS_MS) {
+    lastStatusEvent = now;
+    sendStatusEvent();
+  }
+  
+  if (telemetryHz > 0 && now - lastPoseEvent >= 1000UL / telemetryHz) {
+    lastPoseEvent = now;
+    sendPoseEvent();
+  }
+}
+
+// ============================================================================
+// STATIC ASSETS
+// ============================================================================
+// The UI lives in LittleFS as pre-gzipped files built from web/ by
+// scripts/build_web.py and sent as-is with Content-Encoding: gzip. The
+// HTML references assets as name?v=<hash>, so those can be cached for
+// good; the HTML itself is revalidated with its ETag on each load.
+
+#define WEB_ASSET_DIR "/www"
+
+struct WebAsset {
+  const char* path;        // URL path
+  const char* file;        // LittleFS file
+  const char* type;
+  bool immutable;          // URL carries a content hash
+  char etag[12];           // Quoted CRC-32 of the file, "" if missing
+};
+
+static WebAsset webAssets[] = {
+  {"/",          WEB_ASSET_DIR "/index.html.gz", "text/html",              false, ""},
+  {"/app.js",    WEB_ASSET_DIR "/app.js.gz",     "application/javascript", true,  ""},
+  {"/style.css", WEB_ASSET_DIR "/style.css.gz",  "text/css",               true,  ""}
+};
+
+#define WEB_ASSET_COUNT (sizeof(webAssets) / sizeof(webAssets[0]))
+
+// Served when the filesystem image has not been uploaded
+static const char missingUiPage[] =
+  "<!DOCTYPE html><html><body><h1>Satellite Tracker</h1>"
+  "<p>Web UI files not found. Upload the filesystem image with "
+  "<code>pio run -t uploadfs</code>.</p>"
+  "<p>API: /status /events /tle /jobs /catalog /passes /metrics</p></body></html>";
+
+// Compute ETags once at startup; the files only change with uploadfs
+static void initWebAssets() {
+  if (!LittleFS.begin()) {
+    Serial.println("Web assets: LittleFS not available");
+    return;
+  }
+  
+  for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+    WebAsset& asset = webAssets[i];
+    asset.etag[0] = '\0';
+    
+    File file = LittleFS.open(asset.file, "r");
+    if (!file) {
+      Serial.printf("Web assets: %s missing\n", asset.file);
+      continue;
+    }
+    
+    uint8_t buf[256];
+    uint32_t crc = 0;
+    int len;
+    while ((len = file.read(buf, sizeof(buf))) > 0) {
+      crc = crc32Update(crc, buf, len);
+    }
+    snprintf(asset.etag, sizeof(asset.etag), "\"%08lx\"", (unsigned long)crc);
+    Serial.printf("Web assets: %s %u bytes, ETag %s\n", asset.file, (unsigned)file.size(), asset.etag);
+    file.close();
+  }
+}
+
+static void handleAsset(HttpConnection* conn, const HttpRequest* req) {
+  const WebAsset* asset = nullptr;
+  for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+    if (strcmp(webAssets[i].path, req->path) == 0) {
+      asset = &webAssets[i];
+      break;
+    }
+  }
+  
+  if (!asset || !asset->etag[0]) {
+    if (asset == &webAssets[0]) {
+      httpSend(conn, 200, "text/html", missingUiPage);
+    } else {
+      httpSend(conn, 404, "text/plain", "Not found");
+    }
     return;
   }
   
-  String name = server.arg("name");
-  String line1 = server.arg("line1");
-  String line2 = server.arg("line2");
+  char cacheHeaders[96];
+  snprintf(cacheHeaders, sizeof(cacheHeaders), "ETag: %s\r\nCache-Control: %s\r\n",
+           asset->etag, asset->immutable ? "public, max-age=31536000, immutable" : "no-cache");
   
-  // Input validation - length checks
-  if (name.length() == 0 || name.length() >= sizeof(satelliteName)) {
-    server.send(400, "text/plain", "Invalid satellite name (max 24 chars)");
+  char clientTag[16];
+  if (httpGetHeader(req, "If-None-Match", clientTag, sizeof(clientTag)) &&
+      strcmp(clientTag, asset->etag) == 0) {
+    httpSendWithHeaders(conn, 304, asset->type, cacheHeaders, "");
+    return;
+  }
+  
+  char headers[128];
+  snprintf(headers, sizeof(headers), "Content-Encoding: gzip\r\n%s", cacheHeaders);
+  httpSendFile(conn, 200, asset->type, headers, LittleFS.open(asset->file, "r"));
+}
+
+// ============================================================================
+// REQUEST HANDLERS
+// ============================================================================
+
+static void handleStatus(HttpConnection* conn, const HttpRequest* req) {
+  JsonWriter w;
+  beginJsonResponse(conn, &w);
+  writeStatusJson(&w);
+  sendJsonResponse(conn, 200, nullptr, &w);
+}
+
+// A new client gets the full status as soon as its stream is ready
+// (see updateTelemetry)
+static void handleEvents(HttpConnection* conn, const HttpRequest* req) {
+  httpBeginEventStream(conn);
+}
+
+// Current TLE for the UI form
+static void handleGetTLE(HttpConnection* conn, const HttpRequest* req) {
+  JsonWriter w;
+  beginJsonResponse(conn, &w);
+  jsonObjectBegin(&w);
+  jsonString(&w, "name", satelliteName);
+  jsonString(&w, "line1", tleLine1);
+  jsonString(&w, "line2", tleLine2);
+  jsonBool(&w, "valid", trackerState.tleValid);
+  jsonObjectEnd(&w);
+  sendJsonResponse(conn, 200, nullptr, &w);
+}
+
+static void handleTLE(HttpConnection* conn, const HttpRequest* req) {
+  char name[sizeof(satelliteName) + 1];
+  char line1[sizeof(tleLine1) + 1];
+  char line2[sizeof(tleLine2) + 1];
+  
+  if (!httpGetParam(req->body, "name", name, sizeof(name)) ||
+      !httpGetParam(req->body, "line1", line1, sizeof(line1)) ||
+      !httpGetParam(req->body, "line2", line2, sizeof(line2))) {
+    httpSend(conn, 400, "text/plain", "Missing parameters");
     return;
   }
   
-  if (line1.length() != 69 || line2.length() != 69) {
-    server.send(400, "text/plain", "Invalid TLE format (lines must be 69 chars)");
+  // Input validation - length checks
+  if (strlen(name) == 0 || strlen(name) >= sizeof(satelliteName)) {
+    httpSend(conn, 400, "text/plain", "Invalid satellite name (max 24 chars)");
     return;
   }
   
-  // Basic TLE format validation
-  if (line1[0] != '1' || line2[0] != '2') {
-    server.send(400, "text/plain", "Invalid TLE format (must start with '1' and '2')");
+  // Line layout, checksums and element ranges
+  char error[64];
+  if (!validateTle(line1, line2, error, sizeof(error))) {
+    httpSend(conn, 400, "text/plain", error);
     return;
   }
   
   // Safe copy with bounds checking and null termination
   memset(satelliteName, 0, sizeof(satelliteName));
-  strncpy(satelliteName, name.c_str(), sizeof(satelliteName) - 1);
+  strncpy(satelliteName, name, sizeof(satelliteName) - 1);
   satelliteName[sizeof(satelliteName) - 1] = '\0';
   
   memset(tleLine1, 0, sizeof(tleLine1));
-  strncpy(tleLine1, line1.c_str(), sizeof(tleLine1) - 1);
+  strncpy(tleLine1, line1, sizeof(tleLine1) - 1);
   tleLine1[sizeof(tleLine1) - 1] = '\0';
   
   memset(tleLine2, 0, sizeof(tleLine2));
-  strncpy(tleLine2, line2.c_str(), sizeof(tleLine2) - 1);
+  strncpy(tleLine2, line2, sizeof(tleLine2) - 1);
   tleLine2[sizeof(tleLine2) - 1] = '\0';
   
   // Memory barrier
@@ -199,48 +454,466 @@ void handleTLE() {
   
   tleUpdatePending = true;
   
-  server.send(200, "text/plain", "TLE updated - Core 1 will initialize tracking");
+  httpSend(conn, 200, "text/plain", "TLE updated - Core 1 will initialize tracking");
   
   Serial.print("TLE updated via web: ");
   Serial.println(satelliteName);
 }
 
-void handleHome() {
-  // Require authentication
-  if (!server.authenticate(www_username, www_password)) {
-    return server.requestAuthentication();
+// ============================================================================
+// CATALOG UPLOAD
+// ============================================================================
+// POST /catalog takes a whole 3LE file (curl --data-binary @active.txt)
+// and feeds it to the catalog ingest piece by piece as it arrives. An
+// upload whose client vanished is abandoned after the HTTP idle timeout.
+// Sorting it into the catalog runs as a "catalog" job; so do builds
+// started elsewhere (CATLOAD, converting an older catalog format).
+
+static bool catalogUploadActive = false;
+static unsigned long catalogUploadLastData = 0;
+
+static void catalogUploadBody(HttpConnection* conn, const HttpRequest* req,
+                              const char* data, size_t len) {
+  if (!data) {
+    if (isCatalogIngestActive() || isCatalogBuildActive()) {
+      httpSend(conn, 409, "application/json", "{\"error\":\"catalog upload in progress\"}");
+    } else if (!beginCatalogIngest()) {
+      httpSend(conn, 500, "application/json", "{\"error\":\"catalog storage unavailable\"}");
+    } else {
+      catalogUploadActive = true;
+      catalogUploadLastData = millis();
+    }
+    return;
+  }
+
+  feedCatalogIngest(data, len);
+  catalogUploadLastData = millis();
+}
+
+static void writeIngestStats(JsonWriter* w, const CatalogIngestStats& stats) {
+  jsonUInt(w, "lines", stats.lines);
+  jsonUInt(w, "entries", stats.entries);
+  jsonUInt(w, "badChecksum", stats.badChecksum);
+  jsonUInt(w, "badFormat", stats.badFormat);
+  jsonUInt(w, "dropped", stats.dropped);
+  jsonUInt(w, "duplicates", stats.duplicates);
+  jsonUInt(w, "bytes", stats.bytes);
+  jsonUInt(w, "elapsedMs", stats.elapsedMs);
+  jsonFixed(w, "entriesPerSec", stats.entriesPerSec, 1);
+}
+
+static WebJobState catalogJobStep(WebJob* job) {
+  CatalogBuildState state = stepCatalogBuild();
+  job->message = getCatalogBuildMessage();
+  switch (state) {
+    case CATALOG_BUILD_RUNNING: return JOB_RUNNING;
+    case CATALOG_BUILD_DONE: return JOB_DONE;
+    default: return JOB_FAILED;
+  }
+}
+
+static void handleCatalogUpload(HttpConnection* conn, const HttpRequest* req) {
+  CatalogIngestStats stats;
+  bool building = endCatalogIngest(&stats);
+  catalogUploadActive = false;
+
+  WebJob* job = building ? startWebJob("catalog", catalogJobStep) : nullptr;
+  if (job) {
+    sendJobAccepted(conn, *job);
+    Serial.printf("Catalog upload via web: %lu entries, building as job %u\n",
+                  stats.entries, job->id);
+    return;
+  }
+
+  // Nothing to build, or no free job slot (checkCatalogUpload() starts
+  // the job once one frees up)
+  JsonWriter w;
+  beginJsonResponse(conn, &w);
+  jsonObjectBegin(&w);
+  jsonBool(&w, "stored", false);
+  jsonBool(&w, "building", building);
+  writeIngestStats(&w, stats);
+  jsonObjectEnd(&w);
+  sendJsonResponse(conn, building ? 202 : 400, nullptr, &w);
+}
+
+static void handleCatalogInfo(HttpConnection* conn, const HttpRequest* req) {
+  JsonWriter w;
+  beginJsonResponse(conn, &w);
+  jsonObjectBegin(&w);
+  jsonUInt(&w, "entries", getCatalogCount());
+  jsonUInt(&w, "maxEntries", TLE_CATALOG_MAX_ENTRIES);
+  jsonBool(&w, "uploading", isCatalogIngestActive());
+  jsonBool(&w, "building", isCatalogBuildActive());
+  CatalogIngestStats last;
+  if (getLastIngestStats(&last)) {
+    jsonObjectBegin(&w, "lastUpload");
+    writeIngestStats(&w, last);
+    jsonObjectEnd(&w);
+  }
+  jsonObjectEnd(&w);
+  sendJsonResponse(conn, 200, nullptr, &w);
+}
+
+static void checkCatalogUpload() {
+  if (catalogUploadActive && millis() - catalogUploadLastData > HTTP_IDLE_TIMEOUT_MS) {
+    abortCatalogIngest();
+    catalogUploadActive = false;
+    Serial.println("Catalog upload via web abandoned");
+  }
+  if (isCatalogBuildActive() && !findActiveJob("catalog")) {
+    startWebJob("catalog", catalogJobStep);
+  }
+}
+
+// ============================================================================
+// PASS SCHEDULE
+// ============================================================================
+// GET /passes?sat=25544,43017&from=<unix>&to=<unix>&limit=N answers from
+// the pass cache; passes are streamed one object at a time so the list
+// length is not bounded by the send buffer.
+
+#define PASSES_DEFAULT_LIMIT 50
+#define PASSES_MAX_LIMIT 500
+
+typedef enum {
+  PASSES_HEADER = 0,
+  PASSES_BODY,
+  PASSES_DONE
+} PassesPhase;
+
+struct PassesContext {
+  PassQuery query;
+  PassCursor cursor;
+  uint16_t remaining;
+  uint8_t phase;
+  bool first;
+};
+
+static_assert(sizeof(PassesContext) <= HTTP_CONTEXT_SIZE, "PassesContext too large");
+
+static size_t passesChunk(char* buf, size_t cap, void* context) {
+  PassesContext* ctx = (PassesContext*)context;
+  size_t len = 0;
+
+  if (ctx->phase == PASSES_HEADER) {
+    len = snprintf(buf, cap, "{\"from\":%lu,\"to\":%lu,\"passes\":[",
+                   (unsigned long)ctx->query.from, (unsigned long)ctx->query.to);
+    ctx->phase = PASSES_BODY;
+  }
+
+  while (ctx->phase == PASSES_BODY) {
+    PassCursor next = ctx->cursor;
+    PassEntry pass;
+    if (ctx->remaining == 0 || queryPasses(&ctx->query, &next, &pass, 1) == 0) {
+      if (cap - len < 3) break;
+      memcpy(buf + len, "]}", 2);
+      len += 2;
+      ctx->phase = PASSES_DONE;
+      break;
+    }
+
+    // Room for a comma ahead and the closing "]}" after
+    size_t comma = ctx->first ? 0 : 1;
+    if (cap - len <= comma + 3) break;
+    JsonWriter w;
+    jsonBegin(&w, buf + len + comma, cap - len - comma - 2);
+    jsonObjectBegin(&w);
+    jsonUInt(&w, "norad", pass.noradId);
+    jsonString(&w, "name", getPassWatchName(pass.noradId));
+    jsonUInt(&w, "aos", pass.aos);
+    jsonUInt(&w, "los", pass.los);
+    jsonFixed(&w, "aosAz", pass.aosAz / 10.0, 1);
+    jsonFixed(&w, "maxAz", pass.maxAz / 10.0, 1);
+    jsonFixed(&w, "losAz", pass.losAz / 10.0, 1);
+    jsonFixed(&w, "maxEl", pass.maxEl / 10.0, 1);
+    jsonObjectEnd(&w);
+    if (w.overflow) {
+      break;  // Goes out in the next chunk
+    }
+
+    if (comma) buf[len] = ',';
+    len += comma + w.len;
+    ctx->cursor = next;
+    ctx->remaining--;
+    ctx->first = false;
+  }
+
+  return len;
+}
+
+static void handlePasses(HttpConnection* conn, const HttpRequest* req) {
+  PassCacheInfo info;
+  getPassCacheInfo(&info);
+  if (!info.ready) {
+    httpSend(conn, 503, "application/json", "{\"error\":\"pass cache not ready\"}");
+    return;
+  }
+
+  PassQuery query;
+  char text[96];
+  query.satCount = 0;
+  if (httpGetParam(req->query, "sat", text, sizeof(text))) {
+    query.satCount = parseNoradList(text, query.sats, PASS_QUERY_MAX_SATS);
+    if (query.satCount == 0) {
+      httpSend(conn, 400, "application/json", "{\"error\":\"bad sat list\"}");
+      return;
+    }
+  }
+
+  uint32_t now = getGpsUnixTime();
+  query.from = httpGetParam(req->query, "from", text, sizeof(text)) ?
+               strtoul(text, nullptr, 10) : (now ? now : info.start);
+  query.to = httpGetParam(req->query, "to", text, sizeof(text)) ?
+             strtoul(text, nullptr, 10) : query.from + PASS_CACHE_HOURS * 3600UL;
+
+  uint16_t limit = PASSES_DEFAULT_LIMIT;
+  if (httpGetParam(req->query, "limit", text, sizeof(text))) {
+    limit = constrain(atoi(text), 1, PASSES_MAX_LIMIT);
+  }
+
+  PassesContext* ctx = (PassesContext*)httpSendChunked(conn, 200, "application/json", passesChunk);
+  if (!ctx) {
+    return;
+  }
+  ctx->query = query;
+  passCursorBegin(&ctx->query, &ctx->cursor);
+  ctx->remaining = limit;
+  ctx->phase = PASSES_HEADER;
+  ctx->first = true;
+}
+
+// POST /passes/watch with sats=25544,43017 sets the satellites to predict
+static void handlePassWatch(HttpConnection* conn, const HttpRequest* req) {
+  char text[128] = "";
+  uint32_t ids[PASS_WATCH_MAX];
+  httpGetParam(req->body, "sats", text, sizeof(text));
+  uint8_t count = parseNoradList(text, ids, PASS_WATCH_MAX);
+  if (count == 0 && text[0] != '\0') {
+    httpSend(conn, 400, "application/json", "{\"error\":\"bad sats list\"}");
+    return;
+  }
+
+  uint8_t found = setPassWatchList(ids, count);
+
+  JsonWriter w;
+  beginJsonResponse(conn, &w);
+  jsonObjectBegin(&w);
+  jsonUInt(&w, "requested", count);
+  jsonUInt(&w, "found", found);
+  jsonArrayBegin(&w, "watching");
+  uint8_t watched = getPassWatchList(ids, PASS_WATCH_MAX);
+  for (uint8_t i = 0; i < watched; i++) {
+    jsonObjectBegin(&w);
+    jsonUInt(&w, "norad", ids[i]);
+    jsonString(&w, "name", getPassWatchName(ids[i]));
+    jsonObjectEnd(&w);
+  }
+  jsonArrayEnd(&w);
+  jsonObjectEnd(&w);
+  sendJsonResponse(conn, 200, nullptr, &w);
+}
+
+static void handleHome(HttpConnection* conn, const HttpRequest* req) {
+  WebJob* running = findActiveJob("home");
+  if (running) {
+    sendJob(conn, 409, nullptr, *running);
+    return;
   }
   
-  trackerState.tracking = false;
-  targetPos.elevation = 0.0;
-  targetPos.azimuth = 0.0;
-  delay(100);
-  homeAxes();
-  server.send(200, "text/plain", "Homing complete");
+  WebJob* job = startWebJob("home", homeJobStep);
+  if (!job) {
+    httpSend(conn, 503, "text/plain", "Too many jobs running");
+    return;
+  }
   
+  sendJobAccepted(conn, *job);
   Serial.println("Home command via web");
 }
 
-void handleStop() {
-  // Require authentication
-  if (!server.authenticate(www_username, www_password)) {
-    return server.requestAuthentication();
-  }
-  
+static void handleStop(HttpConnection* conn, const HttpRequest* req) {
   trackerState.tracking = false;
+  
+  // A running home job would start the next axis on its next step
+  cancelHoming();
+  WebJob* homing = findActiveJob("home");
+  if (homing) {
+    homing->state = JOB_FAILED;
+    homing->message = "Homing aborted";
+    homing->endMs = millis();
+  }
   stopAllMotors();
-  server.send(200, "text/plain", "Tracking stopped");
+  httpSend(conn, 200, "text/plain", "Tracking stopped");
   
   Serial.println("Stop command via web");
 }
 
-void handleNotFound() {
-  server.send(404, "text/plain", "Not found");
+// Job status: /jobs?id=N for one job, /jobs for all
+static void handleJobs(HttpConnection* conn, const HttpRequest* req) {
+  char idText[8];
+  
+  if (httpGetParam(req->query, "id", idText, sizeof(idText))) {
+    uint16_t id = atoi(idText);
+    for (int i = 0; i < WEB_MAX_JOBS; i++) {
+      if (webJobs[i].id && webJobs[i].id == id) {
+        sendJob(conn, 200, nullptr, webJobs[i]);
+        return;
+      }
+    }
+    httpSend(conn, 404, "application/json", "{\"error\":\"unknown job\"}");
+    return;
+  }
+  
+  JsonWriter w;
+  beginJsonResponse(conn, &w);
+  jsonArrayBegin(&w);
+  for (int i = 0; i < WEB_MAX_JOBS; i++) {
+    if (webJobs[i].id) {
+      writeJob(&w, webJobs[i]);
+    }
+  }
+  jsonArrayEnd(&w);
+  sendJsonResponse(conn, 200, nullptr, &w);
+}
+
+// ============================================================================
+// METRICS
+// ============================================================================
+
+// Prometheus text exposition, formatted line by line as the send buffer
+// drains; the registry itself is only read here
+static void handleMetrics(HttpConnection* conn, const HttpRequest* req) {
+  httpSendChunked(conn, 200, "text/plain; version=0.0.4", metricsChunk);
+}
+
+static const HttpRoute webRoutes[] = {
+  {"/",          HTTP_GET,  true, handleAsset},
+  {"/app.js",    HTTP_GET,  true, handleAsset},
+  {"/style.css", HTTP_GET,  true, handleAsset},
+  {"/status",    HTTP_GET,  true, handleStatus},
+  {"/tle",       HTTP_GET,  true, handleGetTLE},
+  {"/tle",       HTTP_POST, true, handleTLE},
+  {"/home",      HTTP_POST, true, handleHome},
+  {"/stop",      HTTP_POST, true, handleStop},
+  {"/jobs",      HTTP_GET,  true, handleJobs},
+  {"/events",    HTTP_GET,  true, handleEvents},
+  {"/catalog",   HTTP_GET,  true, handleCatalogInfo},
+  {"/catalog",   HTTP_POST, true, handleCatalogUpload, catalogUploadBody},
+  {"/passes",    HTTP_GET,  true, handlePasses},
+  {"/passes/watch", HTTP_POST, true, handlePassWatch},
+  {"/metrics",   HTTP_GET,  true, handleMetrics}
+};
+
+// ============================================================================
+// WIFI CONNECTION
+// ============================================================================
+// Association runs in the background so setup never waits for the network.
+// Failed attempts are retried with exponential backoff; when the link
+// drops, the network services are stopped and reconnection starts over.
+
+enum WiFiLinkState {
+  WIFI_LINK_IDLE,          // Not configured
+  WIFI_LINK_CONNECTING,    // Association in progress
+  WIFI_LINK_ONLINE,        // Connected, services running
+  WIFI_LINK_BACKOFF        // Waiting before the next attempt
+};
+
+static WiFiLinkState wifiState = WIFI_LINK_IDLE;
+static unsigned long wifiStateSince = 0;
+static unsigned long wifiRetryMs = WIFI_RETRY_MIN_MS;
+static uint32_t wifiConnects = 0;
+static uint32_t wifiFailures = 0;
+static bool mdnsStarted = false;
+
+static void setWiFiState(WiFiLinkState state) {
+  wifiState = state;
+  wifiStateSince = millis();
+}
+
+static void startNetworkServices() {
+  Serial.print("WiFi connected, IP: ");
+  Serial.println(WiFi.localIP());
+  
+  if (MDNS.begin("sattracker")) {
+    MDNS.addService("http", "tcp", 80);
+    mdnsStarted = true;
+    Serial.println("mDNS started: http://sattracker.local");
+  }
+  
+  if (startHttpServer(80, webRoutes, sizeof(webRoutes) / sizeof(webRoutes[0]),
+                      www_username, www_password)) {
+    Serial.println("Web server started");
+  }
+  
+  startRotctlServer(ROTCTL_PORT);
+}
+
+static void stopNetworkServices() {
+  stopRotctlServer();
+  stopHttpServer();
+  if (mdnsStarted) {
+    MDNS.end();
+    mdnsStarted = false;
+  }
+}
+
+static void beginAssociation() {
+  Serial.print("Connecting to WiFi: ");
+  Serial.println(wifiSSID);
+  WiFi.beginNoBlock(wifiSSID, wifiPassword);
+  setWiFiState(WIFI_LINK_CONNECTING);
 }
 
+// Advance the link state machine (called every loop, never blocks)
+static void updateWiFi() {
+  unsigned long elapsed = millis() - wifiStateSince;
+  
+  switch (wifiState) {
+    case WIFI_LINK_IDLE:
+      break;
+      
+    case WIFI_LINK_CONNECTING:
+      if (WiFi.status() == WL_CONNECTED) {
+        wifiConnects++;
+        wifiRetryMs = WIFI_RETRY_MIN_MS;
+        setWiFiState(WIFI_LINK_ONLINE);
+        startNetworkServices();
+      } else if (elapsed >= WIFI_CONNECT_TIMEOUT_MS) {
+        WiFi.disconnect();
+        wifiFailures++;
+        Serial.printf("WiFi connection failed, retry in %lu s\n", wifiRetryMs / 1000);
+        setWiFiState(WIFI_LINK_BACKOFF);
+      }
+      break;
+      
+    case WIFI_LINK_ONLINE:
+      if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("WiFi link lost, reconnecting");
+        stopNetworkServices();
+        WiFi.disconnect();
+        wifiRetryMs = WIFI_RETRY_MIN_MS;
+        setWiFiState(WIFI_LINK_BACKOFF);
+      }
+      break;
+      
+    case WIFI_LINK_BACKOFF:
+      if (elapsed >= wifiRetryMs) {
+        wifiRetryMs = min(wifiRetryMs * 2, (unsigned long)WIFI_RETRY_MAX_MS);
+        beginAssociation();
+      }
+      break;
+  }
+}
+
+// ============================================================================
+// PUBLIC API IMPLEMENTATION
+// ============================================================================
+
 void initWebInterface() {
   Serial.println("Initializing web interface...");
   
+  initWebAssets();
+  
   // Only connect if WiFi is configured
   if (!wifiConfigured || strlen(wifiSSID) == 0) {
     Serial.println("WiFi not configured - skipping");
@@ -248,50 +921,62 @@ void initWebInterface() {
     return;
   }
   
-  WiFi.begin(wifiSSID, wifiPassword);
-  Serial.print("Connecting to WiFi: ");
-  Serial.println(wifiSSID);
-  
-  int wifiAttempts = 0;
-  while (WiFi.status() != WL_CONNECTED && wifiAttempts < 30) {
-    delay(500);
-    Serial.print(".");
-    wifiAttempts++;
+  Serial.println("Login: admin / changeme");
+  Serial.println("CHANGE THE PASSWORD!");
+  beginAssociation();
+}
+
+void reconnectWiFi() {
+  if (wifiState == WIFI_LINK_ONLINE) {
+    stopNetworkServices();
+  }
+  if (wifiState != WIFI_LINK_IDLE) {
+    WiFi.disconnect();
   }
   
-  if (WiFi.status() == WL_CONNECTED) {
-    // Start mDNS
-    if (MDNS.begin("sattracker")) {
-      Serial.println("mDNS started: http://sattracker.local");
-      MDNS.addService("http", "tcp", 80);
-    }
-
-    Serial.println("\nWiFi connected!");
-    Serial.print("IP: ");
-    Serial.println(WiFi.localIP());
-    Serial.println("Login: admin / changeme");
-    Serial.println("CHANGE THE PASSWORD!");
+  wifiRetryMs = WIFI_RETRY_MIN_MS;
+  if (wifiConfigured && strlen(wifiSSID) > 0) {
+    beginAssociation();
   } else {
-    Serial.println("\nWiFi connection failed");
-    wifiConfigured = false;
-    return;
+    setWiFiState(WIFI_LINK_IDLE);
   }
+}
+
+bool isWiFiOnline() {
+  return wifiState == WIFI_LINK_ONLINE;
+}
+
+void printWiFiLinkStatus() {
+  static const char* stateNames[] = {"idle", "connecting", "online", "backoff"};
+  unsigned long elapsed = millis() - wifiStateSince;
   
-  server.on("/", handleRoot);
-  server.on("/status", handleStatus);
-  server.on("/tle", HTTP_POST, handleTLE);
-  server.on("/home", HTTP_POST, handleHome);
-  server.on("/stop", HTTP_POST, handleStop);
-  server.onNotFound(handleNotFound);
-  server.begin();
-  
-  Serial.println("Web server started");
+  Serial.printf("Link state:    %s for %lu s\n", stateNames[wifiState], elapsed / 1000);
+  if (wifiState == WIFI_LINK_BACKOFF) {
+    Serial.printf("Next attempt:  %lu s\n", (wifiRetryMs - min(elapsed, wifiRetryMs)) / 1000);
+  }
+  Serial.printf("Connects: %lu, failed attempts: %lu\n", wifiConnects, wifiFailures);
 }
 
 void handleWebClient() {
-  // Only handle web requests if WiFi is connected
-  if (WiFi.status() == WL_CONNECTED) {
+  updateWiFi();
+  
+  // Only handle web requests while the services are up
+  if (wifiState == WIFI_LINK_ONLINE) {
     MDNS.update();
-    server.handleClient();
+    pollHttpServer();
+    pollRotctlServer();
+    updateTelemetry();
   }
-}
\ No newline at end of file
+  checkCatalogUpload();
+  
+  // Jobs keep running (and can finish) without a network
+  updateWebJobs();
+}
+
+void setTelemetryRate(uint8_t hz) {
+  telemetryHz = min(hz, (uint8_t)TELEMETRY_MAX_HZ);
+}
+
+uint8_t getTelemetryRate() {
+  return telemetryHz;
+}
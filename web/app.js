@@ -0,0 +1,127 @@
+// Satellite Tracker web UI
+// Static page; everything dynamic comes from the JSON API and the
+// /events Server-Sent Events stream.
+
+function $(id) {
+  return document.getElementById(id);
+}
+
+function flag(id, value, yes, no) {
+  $(id).textContent = value ? yes : no;
+  $(id).className = value ? 'status-good' : 'status-bad';
+}
+
+function deg(v) {
+  return v.toFixed(2) + '°';
+}
+
+function showStatus(d) {
+  flag('gpsValid', d.gpsValid, 'Yes', 'No');
+  $('location').textContent = d.lat.toFixed(6) + ', ' + d.lon.toFixed(6);
+  $('altitude').textContent = d.alt.toFixed(1) + ' m';
+  $('time').textContent = d.time;
+  flag('tleLoaded', d.tleValid, 'Yes', 'No');
+  flag('tracking', d.tracking, 'Active', 'Idle');
+  $('targetAz').textContent = deg(d.tgtAz);
+  $('targetEl').textContent = deg(d.tgtEl);
+}
+
+// Pointing error history for the plot
+var HISTORY = 200;
+var errAz = [];
+var errEl = [];
+
+function showPose(p) {
+  $('currentAz').textContent = deg(p.az);
+  $('currentEl').textContent = deg(p.el);
+  $('errorAz').textContent = deg(p.eaz);
+  $('errorEl').textContent = deg(p.eel);
+  errAz.push(p.eaz);
+  errEl.push(p.eel);
+  if (errAz.length > HISTORY) {
+    errAz.shift();
+    errEl.shift();
+  }
+}
+
+function plot() {
+  var c = $('plot');
+  var g = c.getContext('2d');
+  var w = c.width;
+  var h = c.height;
+  var scale = 0.5;
+  errAz.concat(errEl).forEach(function (v) { scale = Math.max(scale, Math.abs(v)); });
+
+  g.clearRect(0, 0, w, h);
+  g.strokeStyle = '#ccc';
+  g.beginPath();
+  g.moveTo(0, h / 2);
+  g.lineTo(w, h / 2);
+  g.stroke();
+
+  [[errAz, '#2196F3'], [errEl, '#f44336']].forEach(function (series) {
+    g.strokeStyle = series[1];
+    g.beginPath();
+    series[0].forEach(function (v, i) {
+      var x = i * w / (HISTORY - 1);
+      var y = h / 2 - v * h / (2.2 * scale);
+      if (i) g.lineTo(x, y); else g.moveTo(x, y);
+    });
+    g.stroke();
+  });
+
+  $('scale').textContent = '±' + scale.toFixed(2) + '°';
+  requestAnimationFrame(plot);
+}
+
+// Fallback for browsers without EventSource
+function poll() {
+  fetch('/status').then(function (r) { return r.json(); }).then(function (d) {
+    showStatus(d);
+    $('currentAz').textContent = deg(d.curAz);
+    $('currentEl').textContent = deg(d.curEl);
+  }).catch(function (e) { console.log('Update failed', e); });
+}
+
+function loadTLE() {
+  fetch('/tle').then(function (r) { return r.json(); }).then(function (t) {
+    var f = $('tleForm').elements;
+    f['name'].value = t.name;
+    f['line1'].value = t.line1;
+    f['line2'].value = t.line2;
+  });
+}
+
+// Submit command forms in place and show the reply
+function bindForms() {
+  Array.prototype.forEach.call(document.forms, function (form) {
+    form.addEventListener('submit', function (e) {
+      e.preventDefault();
+      fetch(form.action, {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/x-www-form-urlencoded' },
+        body: new URLSearchParams(new FormData(form)).toString()
+      }).then(function (r) { return r.text(); }).then(function (text) {
+        $('result').textContent = text;
+      });
+    });
+  });
+}
+
+window.onload = function () {
+  bindForms();
+  loadTLE();
+
+  if (!window.EventSource) {
+    poll();
+    setInterval(poll, 1000);
+    return;
+  }
+
+  var es = new EventSource('/events');
+  es.addEventListener('status', function (e) { showStatus(JSON.parse(e.data)); });
+  es.addEventListener('pose', function (e) { showPose(JSON.parse(e.data)); });
+  es.onopen = function () { flag('link', true, 'Live', ''); };
+  es.onerror = function () { flag('link', false, '', 'Reconnecting'); };
+  requestAnimationFrame(plot);
+};